@@ -0,0 +1,521 @@
+/* *****************************************************************
+    * FILE INFORMATION *
+   ***************************************************************** */
+
+/// @brief Apache Arrow IPC export of simulation state, for pandas/DuckDB/pyarrow consumers.
+        // A path ending in ".arrows" receives one IPC stream with a record batch per export
+        // (under /dev/shm it is shared memory); any other path is used as a prefix for one
+        // complete Arrow file per export, which readers can memory-map without copies.
+        // The integration thread only copies the state; a writer thread computes the orbital
+        // elements and writes the batch
+/// @author Marc S. Ressl, Ian A. Dib, Luciano S. Cordero
+/// @copyright Copyright (c) 2022-2023
+
+
+/* *****************************************************************
+    * FILE CONFIGURATION *
+   ***************************************************************** */
+
+    //* NECESSARY LIBRARIES
+
+    #include <stdio.h>
+    #include <math.h>
+    #include <condition_variable>
+    #include <mutex>
+    #include <string>
+    #include <thread>
+    #include <vector>
+
+    #include <arrow/api.h>
+    #include <arrow/io/file.h>
+    #include <arrow/ipc/writer.h>
+
+
+    //* NECESSARY HEADERS
+
+    #include "arrowExport.h"
+    #include "orbitalElements.h"
+
+
+    //* CONSTANTS
+
+    #define ARROW_STREAM_EXTENSION ".arrows"
+
+    // Group column value of significant bodies (asteroids use their group index)
+    #define ARROW_SIGNIFICANT_BODY_GROUP -1
+
+
+    //* STRUCTURES
+
+    /// @brief Columns of the exported record batches, in schema order
+    enum ArrowColumn
+    {
+        ARROW_COLUMN_ID,
+        ARROW_COLUMN_GROUP,
+        ARROW_COLUMN_X,
+        ARROW_COLUMN_Y,
+        ARROW_COLUMN_Z,
+        ARROW_COLUMN_VX,
+        ARROW_COLUMN_VY,
+        ARROW_COLUMN_VZ,
+        ARROW_COLUMN_MASS,
+        ARROW_COLUMN_SEMI_MAJOR_AXIS,
+        ARROW_COLUMN_ECCENTRICITY,
+        ARROW_COLUMN_INCLINATION,
+        ARROW_COLUMN_MEGNO,
+        ARROW_COLUMN_LYAPUNOV,
+        ARROW_COLUMN_NUM
+    };
+
+
+    /// @brief State copied by the integration thread, completed and written by the writer thread
+    struct ArrowExportJob
+    {
+        std::vector<std::shared_ptr<arrow::Buffer>> buffers;   // One per ArrowColumn
+        int64_t length;                                         // Rows
+        int centerIndex;                                        // Row the elements are referred to
+        double gravitationalParameter;                          // Of the center [m^3/s^2]
+        float time;                                             // [s]
+        unsigned long exportIndex;
+    };
+
+
+    struct ArrowExporter
+    {
+        std::string path;
+        bool isStream;
+        unsigned long exportCount;
+        unsigned long droppedCount;                             // Exports skipped while the writer was busy
+        std::shared_ptr<arrow::Schema> schema;
+        std::shared_ptr<arrow::io::FileOutputStream> streamFile;
+        std::shared_ptr<arrow::ipc::RecordBatchWriter> streamWriter;
+
+        // Writer thread
+        std::thread writer;
+        std::mutex mutex;
+        std::condition_variable wake;                           // A job was handed off or the exporter is stopping
+        ArrowExportJob *pendingJob;                             // Handed off and not yet taken, or NULL
+        bool isWriting;                                         // The writer holds a job
+        bool isStopping;
+    };
+
+
+    //* PRIVATE FUNCTIONS PROTOTYPES
+
+    static std::shared_ptr<arrow::Schema> makeArrowSchema();
+    static ArrowExportJob *makeArrowExportJob(ArrowExporter *exporter, OrbitalSim *sim);
+    static std::shared_ptr<arrow::RecordBatch> completeArrowRecordBatch(ArrowExporter *exporter, ArrowExportJob *job);
+    static bool writeArrowFile(ArrowExporter *exporter, unsigned long exportIndex, const arrow::RecordBatch &batch,
+                                const std::shared_ptr<const arrow::KeyValueMetadata> &metadata);
+    static void writeArrowJob(ArrowExporter *exporter, ArrowExportJob *job);
+    static void runArrowWriter(ArrowExporter *exporter);
+    static bool checkArrowStatus(const arrow::Status &status);
+
+
+/* *****************************************************************
+    * LOGIC MODULES *
+   ***************************************************************** */
+
+    //* RECORD BATCH CONSTRUCTION
+
+    /// @brief Builds the schema shared by every exported record batch
+    /// @return The schema
+    static std::shared_ptr<arrow::Schema> makeArrowSchema()
+    {
+        std::shared_ptr<arrow::KeyValueMetadata> metadata = arrow::key_value_metadata(
+            {"frame", "units"},
+            {"ecliptic J2000 with y and z swapped (y is the ecliptic pole), elements relative to the most massive body",
+             "x/y/z [m], vx/vy/vz [m/s], mass [kg], semi_major_axis [m], inclination [rad], lyapunov [1/s]; "
+             "megno and lyapunov are NaN for significant bodies and without CHAOS_INDICATORS"});
+
+        return arrow::schema({
+            arrow::field("id", arrow::int32(), false),
+            arrow::field("group", arrow::int16(), false),
+            arrow::field("x", arrow::float32(), false),
+            arrow::field("y", arrow::float32(), false),
+            arrow::field("z", arrow::float32(), false),
+            arrow::field("vx", arrow::float32(), false),
+            arrow::field("vy", arrow::float32(), false),
+            arrow::field("vz", arrow::float32(), false),
+            arrow::field("mass", arrow::float32(), false),
+            arrow::field("semi_major_axis", arrow::float64(), false),
+            arrow::field("eccentricity", arrow::float64(), false),
+            arrow::field("inclination", arrow::float64(), false),
+            arrow::field("megno", arrow::float32(), false),
+            arrow::field("lyapunov", arrow::float32(), false),
+        }, metadata);
+    }
+
+
+    /// @brief Allocates a column buffer
+    /// @param length Number of rows
+    /// @param buffers Buffers of the batch, the new one is appended
+    /// @return Pointer to the (uninitialized) column values
+    template <typename T>
+    static T *allocateArrowColumn(int64_t length, std::vector<std::shared_ptr<arrow::Buffer>> &buffers)
+    {
+        arrow::Result<std::unique_ptr<arrow::Buffer>> buffer = arrow::AllocateBuffer(length * sizeof(T));
+        if (!buffer.ok())
+        {
+            return NULL;
+        }
+
+        buffers.push_back(std::shared_ptr<arrow::Buffer>(std::move(*buffer)));
+        return (T *)buffers.back()->mutable_data();
+    }
+
+
+    /// @brief Copies the simulation state (one row per body). The orbital elements are left for
+            // the writer thread
+    /// @param exporter The exporter
+    /// @param sim The orbital simulation
+    /// @return The job, or NULL if memory could not be allocated
+    static ArrowExportJob *makeArrowExportJob(ArrowExporter *exporter, OrbitalSim *sim)
+    {
+        int length = sim->bodyCount + sim->asteroidCount;
+        ArrowExportJob *job = new ArrowExportJob;
+        std::vector<std::shared_ptr<arrow::Buffer>> &buffers = job->buffers;
+
+        int32_t *id = allocateArrowColumn<int32_t>(length, buffers);
+        int16_t *group = allocateArrowColumn<int16_t>(length, buffers);
+        float *x = allocateArrowColumn<float>(length, buffers);
+        float *y = allocateArrowColumn<float>(length, buffers);
+        float *z = allocateArrowColumn<float>(length, buffers);
+        float *vx = allocateArrowColumn<float>(length, buffers);
+        float *vy = allocateArrowColumn<float>(length, buffers);
+        float *vz = allocateArrowColumn<float>(length, buffers);
+        float *mass = allocateArrowColumn<float>(length, buffers);
+        allocateArrowColumn<double>(length, buffers);
+        allocateArrowColumn<double>(length, buffers);
+        allocateArrowColumn<double>(length, buffers);
+        float *megno = allocateArrowColumn<float>(length, buffers);
+        float *lyapunov = allocateArrowColumn<float>(length, buffers);
+
+        if (buffers.size() != (size_t)exporter->schema->num_fields())
+        {
+            delete job;
+            return NULL;
+        }
+
+        // Elements are referred to the most massive significant body
+        int centerIndex = 0;
+        for (int i = 1; i < sim->bodyCount; i++)
+        {
+            if (sim->bodies[i].mass > sim->bodies[centerIndex].mass)
+            {
+                centerIndex = i;
+            }
+        }
+
+        job->length = length;
+        job->centerIndex = centerIndex;
+        job->gravitationalParameter = GRAVITATIONAL_CONSTANT * sim->bodies[centerIndex].mass;
+        job->time = sim->time;
+
+        for (int i = 0; i < sim->bodyCount; i++)
+        {
+            group[i] = ARROW_SIGNIFICANT_BODY_GROUP;
+            mass[i] = sim->bodies[i].mass;
+        }
+
+        for (int i = 0; i < ASTEROID_GROUPNUM; i++)
+        {
+            AsteroidGroup *asteroidGroup = &sim->asteroidGroups[i];
+            int firstRow = sim->bodyCount + asteroidGroup->startIndex;
+
+            for (int row = firstRow; row < firstRow + asteroidGroup->count; row++)
+            {
+                group[row] = (int16_t)i;
+                mass[row] = asteroidGroup->mass;
+            }
+        }
+
+        for (int row = 0; row < length; row++)
+        {
+            bool isAsteroid = row >= sim->bodyCount;
+            Vector3 position = isAsteroid ? sim->asteroids[row - sim->bodyCount].position : sim->bodies[row].position;
+            Vector3 velocity = isAsteroid ? sim->asteroids[row - sim->bodyCount].velocity : sim->bodies[row].velocity;
+
+            id[row] = row;
+            x[row] = position.x;
+            y[row] = position.y;
+            z[row] = position.z;
+            vx[row] = velocity.x;
+            vy[row] = velocity.y;
+            vz[row] = velocity.z;
+
+            ChaosIndicators indicators = {NAN, NAN};
+            if (isAsteroid)
+            {
+                indicators = getChaosIndicators(sim, row - sim->bodyCount);
+            }
+
+            megno[row] = indicators.megno;
+            lyapunov[row] = indicators.lyapunov;
+        }
+
+        return job;
+    }
+
+
+    /// @brief Computes the orbital elements of a copied state and builds its record batch
+    /// @param exporter The exporter
+    /// @param job The job
+    /// @return The record batch
+    static std::shared_ptr<arrow::RecordBatch> completeArrowRecordBatch(ArrowExporter *exporter, ArrowExportJob *job)
+    {
+        const float *x = (const float *)job->buffers[ARROW_COLUMN_X]->data();
+        const float *y = (const float *)job->buffers[ARROW_COLUMN_Y]->data();
+        const float *z = (const float *)job->buffers[ARROW_COLUMN_Z]->data();
+        const float *vx = (const float *)job->buffers[ARROW_COLUMN_VX]->data();
+        const float *vy = (const float *)job->buffers[ARROW_COLUMN_VY]->data();
+        const float *vz = (const float *)job->buffers[ARROW_COLUMN_VZ]->data();
+        double *semiMajorAxis = (double *)job->buffers[ARROW_COLUMN_SEMI_MAJOR_AXIS]->mutable_data();
+        double *eccentricity = (double *)job->buffers[ARROW_COLUMN_ECCENTRICITY]->mutable_data();
+        double *inclination = (double *)job->buffers[ARROW_COLUMN_INCLINATION]->mutable_data();
+
+        int center = job->centerIndex;
+        Vector3 centerPosition = {x[center], y[center], z[center]};
+        Vector3 centerVelocity = {vx[center], vy[center], vz[center]};
+
+        for (int64_t row = 0; row < job->length; row++)
+        {
+            OrbitalElements elements = {0, 0, 0, 0, 0, 0};
+            if (row != center)
+            {
+                Vector3 position = {x[row], y[row], z[row]};
+                Vector3 velocity = {vx[row], vy[row], vz[row]};
+
+                elements = calculateOrbitalElements(Vector3Subtract(position, centerPosition),
+                                                    Vector3Subtract(velocity, centerVelocity),
+                                                    job->gravitationalParameter);
+            }
+
+            semiMajorAxis[row] = elements.semiMajorAxis;
+            eccentricity[row] = elements.eccentricity;
+            inclination[row] = elements.inclination;
+        }
+
+        std::vector<std::shared_ptr<arrow::Array>> columns;
+        for (int i = 0; i < exporter->schema->num_fields(); i++)
+        {
+            columns.push_back(arrow::MakeArray(arrow::ArrayData::Make(exporter->schema->field(i)->type(),
+                                                                    job->length, {nullptr, job->buffers[i]}, 0)));
+        }
+
+        return arrow::RecordBatch::Make(exporter->schema, job->length, columns);
+    }
+
+
+    //* EXPORTER MANAGEMENT
+
+    /// @brief Reports a failed Arrow operation
+    /// @param status Status of the operation
+    /// @return Whether the operation succeeded
+    static bool checkArrowStatus(const arrow::Status &status)
+    {
+        if (!status.ok())
+        {
+            fprintf(stderr, "arrowExport: %s\n", status.ToString().c_str());
+        }
+
+        return status.ok();
+    }
+
+
+    /// @brief Constructs an Arrow exporter
+    /// @param path Stream path (ending in ".arrows") or file prefix
+    /// @return The exporter, or NULL if the stream could not be opened
+    ArrowExporter *constructArrowExporter(const char *path)
+    {
+        ArrowExporter *exporter = new ArrowExporter;
+        exporter->path = path;
+        exporter->exportCount = 0;
+        exporter->droppedCount = 0;
+        exporter->schema = makeArrowSchema();
+        exporter->pendingJob = NULL;
+        exporter->isWriting = false;
+        exporter->isStopping = false;
+
+        std::string extension = ARROW_STREAM_EXTENSION;
+        exporter->isStream = (exporter->path.size() > extension.size()) &&
+            (exporter->path.compare(exporter->path.size() - extension.size(), extension.size(), extension) == 0);
+
+        if (exporter->isStream)
+        {
+            arrow::Result<std::shared_ptr<arrow::io::FileOutputStream>> file =
+                arrow::io::FileOutputStream::Open(exporter->path);
+            if (!checkArrowStatus(file.status()))
+            {
+                delete exporter;
+                return NULL;
+            }
+            exporter->streamFile = *file;
+
+            arrow::Result<std::shared_ptr<arrow::ipc::RecordBatchWriter>> writer =
+                arrow::ipc::MakeStreamWriter(exporter->streamFile, exporter->schema);
+            if (!checkArrowStatus(writer.status()))
+            {
+                delete exporter;
+                return NULL;
+            }
+            exporter->streamWriter = *writer;
+        }
+
+        exporter->writer = std::thread(runArrowWriter, exporter);
+
+        return exporter;
+    }
+
+
+    /// @brief Writes a complete Arrow file, renamed into place so readers never see it partially written
+    /// @param exporter The exporter
+    /// @param exportIndex Number of the export, part of the file name
+    /// @param batch The record batch
+    /// @param metadata Batch metadata
+    /// @return Whether the file was written
+    static bool writeArrowFile(ArrowExporter *exporter, unsigned long exportIndex, const arrow::RecordBatch &batch,
+                                const std::shared_ptr<const arrow::KeyValueMetadata> &metadata)
+    {
+        char suffix[32];
+        snprintf(suffix, sizeof(suffix), "-%08lu.arrow", exportIndex);
+        std::string path = exporter->path + suffix;
+        std::string temporaryPath = path + ".tmp";
+
+        arrow::Result<std::shared_ptr<arrow::io::FileOutputStream>> file =
+            arrow::io::FileOutputStream::Open(temporaryPath);
+        if (!checkArrowStatus(file.status()))
+        {
+            return false;
+        }
+
+        arrow::Result<std::shared_ptr<arrow::ipc::RecordBatchWriter>> writer =
+            arrow::ipc::MakeFileWriter(*file, exporter->schema);
+        if (!checkArrowStatus(writer.status()) ||
+            !checkArrowStatus((*writer)->WriteRecordBatch(batch, metadata)) ||
+            !checkArrowStatus((*writer)->Close()) ||
+            !checkArrowStatus((*file)->Close()))
+        {
+            remove(temporaryPath.c_str());
+            return false;
+        }
+
+        return rename(temporaryPath.c_str(), path.c_str()) == 0;
+    }
+
+
+    /// @brief Completes and writes a handed off state. Failures are reported on stderr
+    /// @param exporter The exporter
+    /// @param job The job, destroyed
+    static void writeArrowJob(ArrowExporter *exporter, ArrowExportJob *job)
+    {
+        std::shared_ptr<arrow::RecordBatch> batch = completeArrowRecordBatch(exporter, job);
+
+        std::shared_ptr<const arrow::KeyValueMetadata> metadata = arrow::key_value_metadata(
+            {"time"}, {std::to_string(job->time)});
+
+        if (exporter->isStream)
+        {
+            checkArrowStatus(exporter->streamWriter->WriteRecordBatch(*batch, metadata));
+        }
+
+        else if (!writeArrowFile(exporter, job->exportIndex, *batch, metadata))
+        {
+            fprintf(stderr, "arrowExport: could not write export %lu\n", job->exportIndex);
+        }
+
+        delete job;
+    }
+
+
+    /// @brief Writer thread: writes handed off states until the exporter stops, finishing the pending one
+    /// @param exporter The exporter
+    static void runArrowWriter(ArrowExporter *exporter)
+    {
+        std::unique_lock<std::mutex> lock(exporter->mutex);
+
+        while (true)
+        {
+            while (!exporter->isStopping && !exporter->pendingJob)
+            {
+                exporter->wake.wait(lock);
+            }
+
+            if (!exporter->pendingJob)
+            {
+                return;
+            }
+
+            ArrowExportJob *job = exporter->pendingJob;
+            exporter->pendingJob = NULL;
+            exporter->isWriting = true;
+
+            lock.unlock();
+            writeArrowJob(exporter, job);
+            lock.lock();
+
+            exporter->isWriting = false;
+        }
+    }
+
+
+    /// @brief Copies the current simulation state and hands it off to the writer thread. Never
+            // waits for the writer: while it is still busy with an earlier export, this one is dropped
+    /// @param exporter The exporter
+    /// @param sim The orbital simulation
+    /// @return Whether the state was handed off
+    bool exportArrowSnapshot(ArrowExporter *exporter, OrbitalSim *sim)
+    {
+        {
+            std::lock_guard<std::mutex> lock(exporter->mutex);
+
+            if (exporter->isWriting || exporter->pendingJob)
+            {
+                exporter->droppedCount++;
+                return false;
+            }
+        }
+
+        ArrowExportJob *job = makeArrowExportJob(exporter, sim);
+        if (!job)
+        {
+            fprintf(stderr, "arrowExport: out of memory for export %lu\n", exporter->exportCount);
+            return false;
+        }
+
+        job->exportIndex = exporter->exportCount++;
+
+        {
+            std::lock_guard<std::mutex> lock(exporter->mutex);
+            exporter->pendingJob = job;
+        }
+        exporter->wake.notify_one();
+
+        return true;
+    }
+
+
+    /// @brief Writes the pending export, closes the stream (if any) and destroys the exporter
+    /// @param exporter The exporter
+    void destroyArrowExporter(ArrowExporter *exporter)
+    {
+        {
+            std::lock_guard<std::mutex> lock(exporter->mutex);
+            exporter->isStopping = true;
+        }
+        exporter->wake.notify_one();
+        exporter->writer.join();
+
+        if (exporter->droppedCount)
+        {
+            fprintf(stderr, "arrowExport: %lu exports dropped while the writer was busy\n", exporter->droppedCount);
+        }
+
+        if (exporter->streamWriter)
+        {
+            checkArrowStatus(exporter->streamWriter->Close());
+            checkArrowStatus(exporter->streamFile->Close());
+        }
+
+        delete exporter;
+    }
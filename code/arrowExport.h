@@ -0,0 +1,36 @@
+/* *****************************************************************
+    * FILE INFORMATION *
+   ***************************************************************** */
+
+/// @brief Apache Arrow IPC export of simulation state, for pandas/DuckDB/pyarrow consumers
+/// @author Marc S. Ressl, Ian A. Dib, Luciano S. Cordero
+/// @copyright Copyright (c) 2022-2023
+
+
+/* *****************************************************************
+    * HEADER CONFIGURATION *
+   ***************************************************************** */
+
+    #ifndef ARROWEXPORT_H
+    #define ARROWEXPORT_H
+
+
+    //* NECESSARY HEADERS
+
+    #include "orbitalSim.h"
+
+
+    //* STRUCTURES
+
+    /// @brief Arrow exporter. Opaque: Arrow types (C++17) stay inside arrowExport.cpp
+    struct ArrowExporter;
+
+
+    //* PUBLIC FUNCTIONS PROTOTYPES
+
+    ArrowExporter *constructArrowExporter(const char *path);
+    bool exportArrowSnapshot(ArrowExporter *exporter, OrbitalSim *sim);
+    void destroyArrowExporter(ArrowExporter *exporter);
+
+
+    #endif // ARROWEXPORT_H
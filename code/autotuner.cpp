@@ -0,0 +1,306 @@
+/* *****************************************************************
+    * FILE INFORMATION *
+   ***************************************************************** */
+
+/// @brief Runtime autotuner for the asteroid kernel, thread count, chunk size and tile size.
+        // Every candidate is timed on short trial steps of the actual scenario, whose asteroids
+        // are restored afterwards, and the fastest one is cached per machine and scenario
+/// @author Marc S. Ressl, Ian A. Dib, Luciano S. Cordero
+/// @copyright Copyright (c) 2022-2023
+
+
+/* *****************************************************************
+    * FILE CONFIGURATION *
+   ***************************************************************** */
+
+    //* NECESSARY LIBRARIES
+
+    #include <stdio.h>
+    #include <stdlib.h>
+    #include <string.h>
+    #include <string>
+    #include <vector>
+
+    #ifndef _WIN32
+    #include <unistd.h>
+    #endif
+
+
+    //* NECESSARY HEADERS
+
+    #include "autotuner.h"
+    #include "metrics.h"
+
+
+    //* CONSTANTS
+
+    static const char *kernelNames[ASTEROID_KERNEL_NUM] = {"fused", "tiled"};
+
+    static const int chunkSizes[] = {1024, 4096, 16384};
+    static const int tileSizes[] = {16, 64, ASTEROID_MAX_TILE_SIZE};
+
+    #define AUTOTUNER_KEY_LENGTH 256
+
+
+    //* PRIVATE FUNCTIONS PROTOTYPES
+
+    static void getTuningKey(OrbitalSim *sim, char *key, size_t size);
+    static uint64_t timeTuning(OrbitalSim *sim, Asteroid *initialAsteroids);
+    static void saveOrbitalSimTuning(OrbitalSim *sim, uint64_t stepNanoseconds);
+
+
+/* *****************************************************************
+    * LOGIC MODULES *
+   ***************************************************************** */
+
+    //* TUNING CACHE
+
+    /// @brief Builds the cache key: host name and hardware threads, then the scenario
+    /// @param sim The orbital simulation
+    /// @param key Destination string (no spaces)
+    /// @param size Size of the destination string
+    static void getTuningKey(OrbitalSim *sim, char *key, size_t size)
+    {
+        char host[64] = "unknown";
+
+        #ifdef _WIN32
+        const char *computerName = getenv("COMPUTERNAME");
+        if (computerName)
+        {
+            snprintf(host, sizeof(host), "%s", computerName);
+        }
+        #else
+        if (gethostname(host, sizeof(host)) != 0)
+        {
+            snprintf(host, sizeof(host), "unknown");
+        }
+        host[sizeof(host) - 1] = '\0';
+        #endif
+
+        for (char *c = host; *c; c++)
+        {
+            if (*c == ' ')
+            {
+                *c = '_';
+            }
+        }
+
+        snprintf(key, size, "%s/%d/b%d-a%d-s%d%d%d%d-c%d", host, getHardwareThreadCount(),
+                sim->bodyCount, sim->asteroidCount, SOLAR_SYSTEM, ALPHA_CENTAURI, BLACKHOLE, MASIVE_JUPITER,
+                CHAOS_INDICATORS);
+    }
+
+
+    /// @brief Loads the cached tuning of this machine and scenario
+    /// @param sim The orbital simulation
+    /// @return Whether a valid cached tuning was found
+    bool loadOrbitalSimTuning(OrbitalSim *sim)
+    {
+        FILE *file = fopen(AUTOTUNER_FILE, "r");
+        if (!file)
+        {
+            return false;
+        }
+
+        char key[AUTOTUNER_KEY_LENGTH];
+        getTuningKey(sim, key, sizeof(key));
+
+        char line[512];
+        char lineKey[AUTOTUNER_KEY_LENGTH];
+        int kernel, threadCount, chunkSize, tileSize;
+        bool isLoaded = false;
+
+        while (!isLoaded && fgets(line, sizeof(line), file))
+        {
+            if ((sscanf(line, "%255s %d %d %d %d", lineKey, &kernel, &threadCount, &chunkSize, &tileSize) == 5) &&
+                (strcmp(lineKey, key) == 0) &&
+                (kernel >= 0) && (kernel < ASTEROID_KERNEL_NUM) &&
+                (threadCount >= 1) && (threadCount <= getWorkerPoolSize(sim->workers)) &&
+                (chunkSize >= 1) && (tileSize >= 1) && (tileSize <= ASTEROID_MAX_TILE_SIZE))
+            {
+                sim->tuning.kernel = (AsteroidKernel)kernel;
+                sim->tuning.threadCount = threadCount;
+                sim->tuning.chunkSize = chunkSize;
+                sim->tuning.tileSize = tileSize;
+                isLoaded = true;
+            }
+        }
+
+        fclose(file);
+
+        return isLoaded;
+    }
+
+
+    /// @brief Stores the current tuning, replacing the line of this machine and scenario
+    /// @param sim The orbital simulation
+    /// @param stepNanoseconds Measured asteroid step time, kept for reference [ns]
+    static void saveOrbitalSimTuning(OrbitalSim *sim, uint64_t stepNanoseconds)
+    {
+        char key[AUTOTUNER_KEY_LENGTH];
+        getTuningKey(sim, key, sizeof(key));
+
+        std::vector<std::string> lines;
+        char line[512];
+        char lineKey[AUTOTUNER_KEY_LENGTH];
+
+        FILE *file = fopen(AUTOTUNER_FILE, "r");
+        if (file)
+        {
+            while (fgets(line, sizeof(line), file))
+            {
+                if ((sscanf(line, "%255s", lineKey) != 1) || (strcmp(lineKey, key) != 0))
+                {
+                    lines.push_back(line);
+                }
+            }
+
+            fclose(file);
+        }
+
+        snprintf(line, sizeof(line), "%s %d %d %d %d %llu\n", key, (int)sim->tuning.kernel,
+                sim->tuning.threadCount, sim->tuning.chunkSize, sim->tuning.tileSize,
+                (unsigned long long)stepNanoseconds);
+        lines.push_back(line);
+
+        file = fopen(AUTOTUNER_FILE, "w");
+        if (!file)
+        {
+            fprintf(stderr, "autotuner: could not write %s\n", AUTOTUNER_FILE);
+            return;
+        }
+
+        for (size_t i = 0; i < lines.size(); i++)
+        {
+            fputs(lines[i].c_str(), file);
+        }
+
+        fclose(file);
+    }
+
+
+    //* TRIALS
+
+    /// @brief Times the asteroid step with the current tuning
+    /// @param sim The orbital simulation
+    /// @param initialAsteroids Asteroids to start every trial from
+    /// @return Fastest trial step [ns]
+    static uint64_t timeTuning(OrbitalSim *sim, Asteroid *initialAsteroids)
+    {
+        float timeStep = sim->timeStep / sim->substeps;
+        uint64_t bestTime = UINT64_MAX;
+
+        memcpy(sim->asteroids, initialAsteroids, sim->asteroidCount * sizeof(Asteroid));
+
+        // Warm-up: wakes the workers and brings the asteroids into cache
+        updateAsteroids(sim, timeStep);
+
+        for (int i = 0; i < AUTOTUNER_TRIAL_STEPS; i++)
+        {
+            uint64_t startTime = getMetricsTime();
+            updateAsteroids(sim, timeStep);
+            uint64_t stepTime = getMetricsTime() - startTime;
+
+            if (stepTime < bestTime)
+            {
+                bestTime = stepTime;
+            }
+        }
+
+        return bestTime;
+    }
+
+
+    /// @brief Times every candidate configuration on the actual scenario, keeps the fastest and
+            // caches it. The simulation state is left as it was
+    /// @param sim The orbital simulation
+    void autotuneOrbitalSim(OrbitalSim *sim)
+    {
+        Asteroid *initialAsteroids = new Asteroid[sim->asteroidCount];
+        memcpy(initialAsteroids, sim->asteroids, sim->asteroidCount * sizeof(Asteroid));
+
+        // Trials also advance the chaos indicators, which are only put back at the end
+        AsteroidTangent *initialTangents = NULL;
+        if (sim->tangents)
+        {
+            initialTangents = new AsteroidTangent[sim->asteroidCount];
+            memcpy(initialTangents, sim->tangents, sim->asteroidCount * sizeof(AsteroidTangent));
+        }
+
+        OrbitalSimTuning bestTuning = sim->tuning;
+        uint64_t bestTime = UINT64_MAX;
+        int maxThreadCount = getWorkerPoolSize(sim->workers);
+
+        // The variational kernel replaces both, so only the threads and chunks are tuned for it
+        int kernelCount = sim->tangents ? 1 : ASTEROID_KERNEL_NUM;
+
+        for (int kernel = 0; kernel < kernelCount; kernel++)
+        {
+            int tileCount = (kernel == ASTEROID_KERNEL_TILED) ? (int)(sizeof(tileSizes) / sizeof(tileSizes[0])) : 1;
+
+            for (int tile = 0; tile < tileCount; tile++)
+            {
+                // Powers of two, then every hardware thread
+                for (int threadCount = 1; threadCount <= maxThreadCount;
+                    threadCount = ((threadCount * 2 > maxThreadCount) && (threadCount < maxThreadCount)) ?
+                                    maxThreadCount : threadCount * 2)
+                {
+                    for (size_t chunk = 0; chunk < sizeof(chunkSizes) / sizeof(chunkSizes[0]); chunk++)
+                    {
+                        // Larger chunks than the whole belt all behave the same
+                        if ((chunk > 0) && (chunkSizes[chunk - 1] >= sim->asteroidCount))
+                        {
+                            break;
+                        }
+
+                        sim->tuning.kernel = (AsteroidKernel)kernel;
+                        sim->tuning.threadCount = threadCount;
+                        sim->tuning.chunkSize = chunkSizes[chunk];
+                        sim->tuning.tileSize = tileSizes[(kernel == ASTEROID_KERNEL_TILED) ? tile : 1];
+
+                        uint64_t time = timeTuning(sim, initialAsteroids);
+                        if (time < bestTime)
+                        {
+                            bestTime = time;
+                            bestTuning = sim->tuning;
+                        }
+                    }
+                }
+            }
+        }
+
+        memcpy(sim->asteroids, initialAsteroids, sim->asteroidCount * sizeof(Asteroid));
+        delete[] initialAsteroids;
+
+        if (initialTangents)
+        {
+            memcpy(sim->tangents, initialTangents, sim->asteroidCount * sizeof(AsteroidTangent));
+            delete[] initialTangents;
+        }
+
+        sim->tuning = bestTuning;
+        saveOrbitalSimTuning(sim, bestTime);
+
+        if (sim->tangents)
+        {
+            printf("autotuner: variational kernel, %d threads, chunks of %d (%.1f us per asteroid step)\n",
+                    sim->tuning.threadCount, sim->tuning.chunkSize, bestTime * 1E-3);
+        }
+        else
+        {
+            printf("autotuner: %s kernel, %d threads, chunks of %d, tiles of %d (%.1f us per asteroid step)\n",
+                    kernelNames[sim->tuning.kernel], sim->tuning.threadCount, sim->tuning.chunkSize,
+                    sim->tuning.tileSize, bestTime * 1E-3);
+        }
+    }
+
+
+    /// @brief Loads the cached tuning of this machine and scenario, or autotunes if there is none
+    /// @param sim The orbital simulation
+    void tuneOrbitalSim(OrbitalSim *sim)
+    {
+        if (!loadOrbitalSimTuning(sim))
+        {
+            autotuneOrbitalSim(sim);
+        }
+    }
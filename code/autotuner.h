@@ -0,0 +1,42 @@
+/* *****************************************************************
+    * FILE INFORMATION *
+   ***************************************************************** */
+
+/// @brief Runtime autotuner for the asteroid kernel, thread count, chunk size and tile size
+/// @author Marc S. Ressl, Ian A. Dib, Luciano S. Cordero
+/// @copyright Copyright (c) 2022-2023
+
+
+/* *****************************************************************
+    * HEADER CONFIGURATION *
+   ***************************************************************** */
+
+    #ifndef AUTOTUNER_H
+    #define AUTOTUNER_H
+
+
+    //* NECESSARY HEADERS
+
+    #include "orbitalSim.h"
+
+
+    //* CONFIGURATION
+
+    // Tune at startup (or load the cached choice). Press T in orbitalsim to tune again
+    #define AUTOTUNER 1
+
+    // Cached choices, one line per machine and scenario
+    #define AUTOTUNER_FILE "orbitalsim-tuning.txt"
+
+    // Timed steps per configuration, after one warm-up step
+    #define AUTOTUNER_TRIAL_STEPS 4
+
+
+    //* PUBLIC FUNCTIONS PROTOTYPES
+
+    void tuneOrbitalSim(OrbitalSim *sim);
+    bool loadOrbitalSimTuning(OrbitalSim *sim);
+    void autotuneOrbitalSim(OrbitalSim *sim);
+
+
+    #endif // AUTOTUNER_H
@@ -0,0 +1,177 @@
+/* *****************************************************************
+    * FILE INFORMATION *
+   ***************************************************************** */
+   
+/// @brief Headless orbital simulation engine: integrates without a window and publishes
+        // snapshots to a shared-memory ring for orbitalsim_view.
+        // Usage: orbitalsim_engine [arrow stream (.arrows) or file prefix]
+/// @author Marc S. Ressl, Ian A. Dib, Luciano S. Cordero
+/// @copyright Copyright (c) 2022-2023
+
+
+/* *****************************************************************
+    * FILE CONFIGURATION *
+   ***************************************************************** */
+
+    //* NECESSARY LIBRARIES
+
+    #include <stdio.h>
+    #include <signal.h>
+    #include <chrono>
+
+
+    //* NECESSARY HEADERS
+
+    #include "orbitalSim.h"
+    #include "snapshot.h"
+    #include "snapshotRing.h"
+    #include "metrics.h"
+    #include "autotuner.h"
+
+    #ifdef ORBITALSIM_ARROW
+    #include "arrowExport.h"
+    #endif
+
+
+    //* CONSTANTS
+
+    #define SECONDS_PER_DAY 86400
+
+    // Snapshots published per second of wall time, independent of the integration rate
+    #define ENGINE_PUBLISH_RATE 60
+
+    // Steps between Arrow exports (140 steps are 50 simulated days)
+    #define ENGINE_ARROW_EXPORT_INTERVAL 140
+
+
+    //* GLOBAL VARIABLES
+
+    volatile sig_atomic_t isEngineRunning = 1;
+
+
+/* *****************************************************************
+    * MAIN LOGIC *
+   ***************************************************************** */
+
+    /// @brief Stops the integration loop on SIGINT/SIGTERM, so the ring gets unlinked
+    /// @param signalNumber The received signal
+    void stopEngine(int signalNumber)
+    {
+        (void)signalNumber;
+        isEngineRunning = 0;
+    }
+
+
+    int main(int argc, char **argv)
+    {
+        // Reference integration step: 50 simulated days every 140 steps
+        int fps = 140;
+        float timeMultiplier = 50 * SECONDS_PER_DAY;
+        float timeStep = timeMultiplier / fps;
+
+
+        //* SIMULATION AND RING SETUP
+
+        OrbitalSim *sim = constructOrbitalSim(timeStep);
+
+        Snapshot *snapshot = constructSnapshot(sim);
+        SnapshotRing *ring = createSnapshotRing(snapshot->size);
+
+        if (!ring)
+        {
+            fprintf(stderr, "orbitalsim_engine: could not create shared memory %s\n", SNAPSHOT_RING_NAME);
+            destroySnapshot(snapshot);
+            destroyOrbitalSim(sim);
+            return 1;
+        }
+
+        #ifdef ORBITALSIM_ARROW
+        ArrowExporter *arrowExporter = (argc > 1) ? constructArrowExporter(argv[1]) : NULL;
+
+        if ((argc > 1) && !arrowExporter)
+        {
+            fprintf(stderr, "orbitalsim_engine: could not open Arrow export %s\n", argv[1]);
+            destroySnapshotRing(ring);
+            destroySnapshot(snapshot);
+            destroyOrbitalSim(sim);
+            return 1;
+        }
+        #else
+        if (argc > 1)
+        {
+            fprintf(stderr, "orbitalsim_engine: built without Apache Arrow, ignoring %s\n", argv[1]);
+        }
+        #endif
+
+        if (METRICS_ENDPOINT)
+        {
+            registerOrbitalSimMetrics(sim);
+            startMetricsServer(METRICS_PORT);
+        }
+
+        signal(SIGINT, stopEngine);
+        signal(SIGTERM, stopEngine);
+
+        printf("orbitalsim_engine: publishing %d bodies and %d asteroids on %s\n",
+                sim->bodyCount, sim->asteroidCapacity, SNAPSHOT_RING_NAME);
+
+
+        //* SIMULATION UPDATE AND PUBLISHING
+
+        // Viewers never slow the integrator down: publishing only copies into the ring
+        std::chrono::steady_clock::duration publishPeriod =
+            std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                std::chrono::duration<double>(1.0 / ENGINE_PUBLISH_RATE));
+        std::chrono::steady_clock::time_point nextPublish = std::chrono::steady_clock::now();
+
+        unsigned long step = 0;
+
+        // Tuning waits for the whole belt: the asteroids are generated in the background
+        bool isTuned = !AUTOTUNER;
+
+        while (isEngineRunning)
+        {
+            updateOrbitalSim(sim);
+            step++;
+
+            if (!isTuned && (sim->asteroidCount == sim->asteroidCapacity))
+            {
+                tuneOrbitalSim(sim);
+                isTuned = true;
+            }
+
+            #ifdef ORBITALSIM_ARROW
+            // Only copies the state: the elements are computed and written on the exporter's thread
+            if (arrowExporter && (step % ENGINE_ARROW_EXPORT_INTERVAL == 0))
+            {
+                exportArrowSnapshot(arrowExporter, sim);
+            }
+            #endif
+
+            std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+            if (now >= nextPublish)
+            {
+                packSnapshot(snapshot, sim);
+                publishSnapshot(ring, snapshot);
+                nextPublish = now + publishPeriod;
+            }
+        }
+
+
+        //* SIMULATION STOP AND CLEANUP
+
+        stopMetricsServer();
+
+        #ifdef ORBITALSIM_ARROW
+        if (arrowExporter)
+        {
+            destroyArrowExporter(arrowExporter);
+        }
+        #endif
+
+        destroySnapshotRing(ring);
+        destroySnapshot(snapshot);
+        destroyOrbitalSim(sim);
+
+        return 0;
+    }
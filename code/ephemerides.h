@@ -2,7 +2,10 @@
     * FILE INFORMATION *
    ***************************************************************** */
    
-/// @brief Ephemerides for orbital simulation
+/// @brief Ephemerides for orbital simulation: a catalog of scenarios, every one a constexpr
+        // table of initial states. Derived values (unit conversions, gravitational parameters and
+        // circular velocities) are computed by the compiler, and the tables have internal
+        // linkage, so the header can be included by any number of translation units
 /// @author Marc S. Ressl
 /// @copyright Copyright (c) 2022-2023
 
@@ -19,12 +22,21 @@
     // Graphic interface & vector math libraries
     #include "raylib.h"
     #include "raymath.h"
+
+
+    //* NECESSARY HEADERS
+
+    #include "orbitalSim.h"
     
 
     //* CONSTANTS & STRUCTURES
 
-    #define SOLARSYSTEM_BODYNUM (sizeof(solarSystem) / sizeof(EphemeridesBody))
-    #define ALPHACENTAURISYSTEM_BODYNUM (sizeof(alphaCentauriSystem) / sizeof(EphemeridesBody))
+    #define EPHEMERIDES_ASTRONOMICAL_UNIT 1.495978707E11    // [m]
+    #define EPHEMERIDES_SOLAR_MASS 1988500E24               // [kg]
+    #define EPHEMERIDES_SOLAR_RADIUS 695700E3               // [m]
+    #define EPHEMERIDES_EARTH_MASS 5.97219E24               // [kg]
+    #define EPHEMERIDES_EARTH_RADIUS 6371.01E3              // [m]
+    #define EPHEMERIDES_KILOMETER 1E3                       // [m]
 
     struct EphemeridesBody
     {
@@ -37,11 +49,108 @@
     };
 
 
-    //* GLOBAL VARIABLES
+    /// @brief Scenario of the catalog: a table of bodies, included when its flag is set
+    struct EphemeridesScenario
+    {
+        const char *name;
+        const EphemeridesBody *bodies;
+        int bodyCount;
+        bool isEnabled;
+    };
+
+
+    /// @brief Moon of a solar system planet
+    struct EphemeridesMoon
+    {
+        const char *name;
+        const EphemeridesBody *planet;
+        float mass;       // [kg]
+        float radius;     // [m]
+        Color color;      // Raylib color
+        Vector3 position; // Relative to the planet [m]
+        Vector3 velocity; // Relative to the planet [m/s]
+    };
+
+
+    //* COMPILE-TIME HELPERS
+
+    /// @brief Number of elements of an array
+    template <typename T, int N>
+    constexpr int getEphemeridesCount(const T (&)[N])
+    {
+        return N;
+    }
+
+
+    /// @brief Square root by Newton's method, usable in constant expressions (C++11 constexpr
+            // allows one return statement, so iterations recurse). From a guess of at least the
+            // root, every iteration at least halves the distance to it until it converges quadratically
+    /// @param x Radicand, non-negative
+    /// @param guess Current approximation
+    /// @param iterations Iterations left
+    constexpr double getEphemeridesSqrt(double x, double guess, int iterations)
+    {
+        return ((iterations == 0) || (guess == 0)) ? guess :
+                getEphemeridesSqrt(x, 0.5 * (guess + x / guess), iterations - 1);
+    }
+
+
+    /// @brief Square root, exact to double precision for any radicand below 1E38
+    constexpr double getEphemeridesSqrt(double x)
+    {
+        return getEphemeridesSqrt(x, (x > 1) ? x : 1, 140);
+    }
+
+
+    /// @brief Gravitational parameter mu = G * m [m^3/s^2]
+    /// @param mass [kg]
+    constexpr double getEphemeridesGravitationalParameter(double mass)
+    {
+        return (double)GRAVITATIONAL_CONSTANT * mass;
+    }
+
+
+    /// @brief Speed of a circular orbit around a center, the two-body problem reduced to one
+    /// @param centerMass [kg]
+    /// @param mass Orbiting body mass [kg]
+    /// @param radius Orbit radius [m]
+    /// @return [m/s]
+    constexpr double getEphemeridesCircularSpeed(double centerMass, double mass, double radius)
+    {
+        return getEphemeridesSqrt(getEphemeridesGravitationalParameter(centerMass + mass) / radius);
+    }
+
+
+    /// @brief Position on a circular orbit in the ecliptic plane (simulation xz), at one of four
+            // phases 90 degrees apart, so the bodies of a system do not start lined up
+    /// @param center Center position [m]
+    /// @param radius Orbit radius [m]
+    /// @param phase Quarter turns from the x axis
+    constexpr Vector3 getEphemeridesCircularPosition(Vector3 center, double radius, int phase)
+    {
+        return {center.x + (float)(((phase % 4) == 0) ? radius : (((phase % 4) == 2) ? -radius : 0)),
+                center.y,
+                center.z + (float)(((phase % 4) == 1) ? -radius : (((phase % 4) == 3) ? radius : 0))};
+    }
+
+
+    /// @brief Velocity on a circular orbit, prograde like the planets (angular momentum along -y)
+    /// @param centerVelocity Center velocity [m/s]
+    /// @param speed Orbital speed [m/s]
+    /// @param phase Quarter turns from the x axis, as in getEphemeridesCircularPosition
+    constexpr Vector3 getEphemeridesCircularVelocity(Vector3 centerVelocity, double speed, int phase)
+    {
+        return {centerVelocity.x + (float)(((phase % 4) == 1) ? speed : (((phase % 4) == 3) ? -speed : 0)),
+                centerVelocity.y,
+                centerVelocity.z + (float)(((phase % 4) == 0) ? speed : (((phase % 4) == 2) ? -speed : 0))};
+    }
+
+
+    //* SCENARIOS
 
     /// @brief Solay system ephermerides for 2022-01-01T00:00:00Z
     /// @cite https://ssd.jpl.nasa.gov/horizons/app.html#/
-    EphemeridesBody solarSystem[] = 
+    static constexpr EphemeridesBody solarSystem[] = 
     {
         {
             "Sol",
@@ -120,7 +229,7 @@
 
     /// @brief Alpha Centauri system ephermerides for 2022-01-01T00:00:00Z
     /// @cite https://ssd.jpl.nasa.gov/horizons/app.html#/
-    EphemeridesBody alphaCentauriSystem[] = 
+    static constexpr EphemeridesBody alphaCentauriSystem[] = 
     {
         {
             "Alfa Centauri A",
@@ -141,4 +250,100 @@
     };
 
 
+    /// @brief TRAPPIST-1 and its seven planets, on circular orbits around the star at the origin
+    /// @cite https://doi.org/10.3847/PSJ/abd022
+    #define TRAPPIST_MASS (0.0898 * EPHEMERIDES_SOLAR_MASS)
+    #define TRAPPIST_PLANET(name, semiMajorAxis, planetMass, planetRadius, color, phase) \
+        { \
+            name, \
+            (float)((planetMass) * EPHEMERIDES_EARTH_MASS), \
+            (float)((planetRadius) * EPHEMERIDES_EARTH_RADIUS), \
+            color, \
+            getEphemeridesCircularPosition({0, 0, 0}, (semiMajorAxis) * EPHEMERIDES_ASTRONOMICAL_UNIT, phase), \
+            getEphemeridesCircularVelocity({0, 0, 0}, getEphemeridesCircularSpeed(TRAPPIST_MASS, \
+                (planetMass) * EPHEMERIDES_EARTH_MASS, (semiMajorAxis) * EPHEMERIDES_ASTRONOMICAL_UNIT), phase), \
+        }
+
+    static constexpr EphemeridesBody trappistSystem[] =
+    {
+        {
+            "TRAPPIST-1",
+            (float)TRAPPIST_MASS,
+            (float)(0.1192 * EPHEMERIDES_SOLAR_RADIUS),
+            RED,
+            {0, 0, 0},
+            {0, 0, 0},
+        },
+        TRAPPIST_PLANET("TRAPPIST-1b", 0.01154, 1.374, 1.116, ORANGE, 0),
+        TRAPPIST_PLANET("TRAPPIST-1c", 0.01580, 1.308, 1.097, BEIGE, 1),
+        TRAPPIST_PLANET("TRAPPIST-1d", 0.02227, 0.388, 0.788, SKYBLUE, 2),
+        TRAPPIST_PLANET("TRAPPIST-1e", 0.02925, 0.692, 0.920, BLUE, 3),
+        TRAPPIST_PLANET("TRAPPIST-1f", 0.03849, 1.039, 1.045, DARKBLUE, 0),
+        TRAPPIST_PLANET("TRAPPIST-1g", 0.04683, 1.321, 1.129, LIGHTGRAY, 1),
+        TRAPPIST_PLANET("TRAPPIST-1h", 0.06189, 0.326, 0.755, GRAY, 2),
+    };
+
+
+    /// @brief Moons on circular orbits around solar system planets, with their state relative
+            // to the planet. The simulation integrates them in their planet's frame
+    /// @cite https://ssd.jpl.nasa.gov/sats/phys_par/
+    #define PLANETARY_MOON(name, planet, semiMajorAxis, moonMass, moonRadius, color, phase) \
+        { \
+            name, \
+            &(planet), \
+            (float)(moonMass), \
+            (float)((moonRadius) * EPHEMERIDES_KILOMETER), \
+            color, \
+            getEphemeridesCircularPosition({0, 0, 0}, (semiMajorAxis) * EPHEMERIDES_KILOMETER, phase), \
+            getEphemeridesCircularVelocity({0, 0, 0}, getEphemeridesCircularSpeed( \
+                (planet).mass, moonMass, (semiMajorAxis) * EPHEMERIDES_KILOMETER), phase), \
+        }
+
+    // Moons of the same planet go together
+    static constexpr EphemeridesMoon planetaryMoons[] =
+    {
+        PLANETARY_MOON("Luna", solarSystem[3], 384400, 7.342E22, 1737.4, LIGHTGRAY, 0),
+        PLANETARY_MOON("Io", solarSystem[5], 421700, 8.931938E22, 1821.6, YELLOW, 0),
+        PLANETARY_MOON("Europa", solarSystem[5], 671034, 4.799844E22, 1560.8, RAYWHITE, 1),
+        PLANETARY_MOON("Ganimedes", solarSystem[5], 1070412, 1.4819E23, 2634.1, GRAY, 2),
+        PLANETARY_MOON("Calisto", solarSystem[5], 1882709, 1.075938E23, 2410.3, DARKGRAY, 3),
+        PLANETARY_MOON("Titan", solarSystem[6], 1221870, 1.3452E23, 2574.7, ORANGE, 0),
+    };
+
+
+    //* CATALOG
+
+    /// @brief Every scenario, in the order its bodies are added
+    static constexpr EphemeridesScenario ephemeridesScenarios[] =
+    {
+        {"Sistema solar", solarSystem, getEphemeridesCount(solarSystem), SOLAR_SYSTEM != 0},
+        {"Alfa Centauri", alphaCentauriSystem, getEphemeridesCount(alphaCentauriSystem), ALPHA_CENTAURI != 0},
+        {"TRAPPIST-1", trappistSystem, getEphemeridesCount(trappistSystem), TRAPPIST_1 != 0},
+    };
+
+
+    /// @brief Bodies of the enabled scenarios, from the given one on
+    constexpr int getEphemeridesBodyCount(int scenario = 0)
+    {
+        return (scenario >= getEphemeridesCount(ephemeridesScenarios)) ? 0 :
+                (ephemeridesScenarios[scenario].isEnabled ? ephemeridesScenarios[scenario].bodyCount : 0) +
+                getEphemeridesBodyCount(scenario + 1);
+    }
+
+
+    /// @brief Moons in the simulation: they need the solar system, for their planets
+    constexpr int getEphemeridesMoonCount()
+    {
+        return (MOON_SYSTEMS && SOLAR_SYSTEM) ? getEphemeridesCount(planetaryMoons) : 0;
+    }
+
+
+    // Sanity checks of the compile-time arithmetic: Earth's circular speed is about 29.8 km/s
+    static_assert((getEphemeridesSqrt(2.0) > 1.4142135) && (getEphemeridesSqrt(2.0) < 1.4142136),
+                    "getEphemeridesSqrt does not converge");
+    static_assert((getEphemeridesCircularSpeed(EPHEMERIDES_SOLAR_MASS, 0, EPHEMERIDES_ASTRONOMICAL_UNIT) > 29700) &&
+                    (getEphemeridesCircularSpeed(EPHEMERIDES_SOLAR_MASS, 0, EPHEMERIDES_ASTRONOMICAL_UNIT) < 29900),
+                    "Wrong circular speed");
+
+
     #endif // EPHEMERIDES_H
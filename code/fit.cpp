@@ -0,0 +1,746 @@
+/* *****************************************************************
+    * FILE INFORMATION *
+   ***************************************************************** */
+
+/// @brief Orbit fitting: adjusts the initial state vectors of many objects at once so that the
+        // headless simulation best reproduces their observed sky positions (least squares on
+        // right ascension and declination, by Gauss-Newton). Every object is integrated together
+        // with six clones, each with one state component nudged, so the partials come from finite
+        // differences: as test particles in the same batched asteroid step, or, for significant
+        // bodies, as massive bodies in simulations of their own.
+        // Usage: orbitalsim_fit --objects objects.csv --observations observations.csv [--iterations n]
+        // Objects: one "name" or "name,x,y,z,vx,vy,vz" line per object (simulation frame at the
+        // ephemerides epoch, [m] and [m/s]). A bare name takes the ephemerides seed of that body.
+        // Observations: "name,time_days,ra_deg,dec_deg" lines, as seen from SKY_OBSERVER and
+        // referred to the J2000 equator, with times in days since the ephemerides epoch.
+        // Prints the fitted states as an objects CSV, and ephemerides.h-style seeds to stderr
+/// @author Marc S. Ressl, Ian A. Dib, Luciano S. Cordero
+/// @copyright Copyright (c) 2022-2023
+
+
+/* *****************************************************************
+    * FILE CONFIGURATION *
+   ***************************************************************** */
+
+    //* NECESSARY LIBRARIES
+
+    // Enables M_PI #define in Windows
+    #define _USE_MATH_DEFINES
+
+    #include <stdio.h>
+    #include <stdlib.h>
+    #include <string.h>
+    #include <math.h>
+    #include <algorithm>
+    #include <vector>
+
+
+    //* NECESSARY HEADERS
+
+    #include "orbitalSim.h"
+    #include "skyPositions.h"
+    #include "workerPool.h"
+
+
+    //* CONSTANTS
+
+    #define SECONDS_PER_DAY 86400
+    #define DEGREES_PER_RADIAN 57.29577951308232
+    #define ARCSECONDS_PER_RADIAN 206264.80624709636
+
+    // Longest integration step [s]. Steps are shortened to land on every observation time
+    #define FIT_TIME_STEP (SECONDS_PER_DAY / 8.0F)
+
+    // Defaults: Gauss-Newton iterations, and the relative rms improvement below which an
+    // object is taken as converged
+    #define FIT_ITERATIONS 10
+    #define FIT_CONVERGENCE 1E-2
+
+    // Times a step that made the residual worse is halved before the object is taken as
+    // converged at its best state. Near the float noise floor, steps stop helping
+    #define FIT_BACKTRACKS 2
+
+    // Finite difference nudge, relative to the length of the position or velocity. Large enough
+    // to stand well above the float rounding of the integration, small enough to stay linear
+    #define FIT_PERTURBATION 1E-4
+
+    // Simulated clones per object: the nominal state and one per nudged state component
+    #define FIT_PARAMETERS 6
+    #define FIT_CLONES (FIT_PARAMETERS + 1)
+
+
+    //* STRUCTURES
+
+    /// @brief Object whose initial state is fitted
+    struct FitObject
+    {
+        char name[64];
+        double state[FIT_PARAMETERS];           // Position [m] and velocity [m/s] at the epoch
+        double previousState[FIT_PARAMETERS];   // Before the last Gauss-Newton step
+        double stepSize[FIT_PARAMETERS];        // Last Gauss-Newton step
+        double perturbation[FIT_PARAMETERS];    // Finite difference nudge of every component
+
+        int observationCount;
+        int iterationCount;
+        int backtrackCount;                     // Halvings of the last step
+        double rms;                             // Residual of the best state [rad]
+        bool isConverged;
+
+        // Normal equations of the last evaluation, in units of the nudges
+        double normal[FIT_PARAMETERS][FIT_PARAMETERS];
+        double rhs[FIT_PARAMETERS];
+        double residualSqr;
+    };
+
+
+    /// @brief Observed sky position of an object
+    struct FitObservation
+    {
+        double time;                // Since the ephemerides epoch [s]
+        int object;
+        double rightAscension;      // [rad]
+        double declination;         // [rad]
+    };
+
+
+/* *****************************************************************
+    * LOGIC MODULES *
+   ***************************************************************** */
+
+    //* INPUT
+
+    /// @brief Finds an object by name
+    /// @param objects The objects
+    /// @param name Name of the object
+    /// @return Its index, or -1 if there is none
+    int findFitObject(const std::vector<FitObject> &objects, const char *name)
+    {
+        for (size_t i = 0; i < objects.size(); i++)
+        {
+            if (strcmp(objects[i].name, name) == 0)
+            {
+                return (int)i;
+            }
+        }
+
+        return -1;
+    }
+
+
+    /// @brief Finds a significant body by name
+    /// @param sim The orbital simulation
+    /// @param name Name of the body
+    /// @return Its index, or -1 if there is none
+    int findFitBody(OrbitalSim *sim, const char *name)
+    {
+        for (int i = 0; i < sim->bodyCount; i++)
+        {
+            if (strcmp(sim->bodies[i].name, name) == 0)
+            {
+                return i;
+            }
+        }
+
+        return -1;
+    }
+
+
+    /// @brief Loads the objects file. Bare names take the seed of that significant body
+    /// @param filename Objects CSV (the header, written by this tool, is skipped)
+    /// @param objects Destination objects
+    /// @return Whether every line named a known body or gave a full state
+    bool loadFitObjects(const char *filename, std::vector<FitObject> &objects)
+    {
+        FILE *file = fopen(filename, "r");
+        if (!file)
+        {
+            fprintf(stderr, "orbitalsim_fit: could not open %s\n", filename);
+            return false;
+        }
+
+        // Only to read the ephemerides seeds
+        OrbitalSim *seeds = constructOrbitalSim(FIT_TIME_STEP, 0);
+
+        char line[512];
+        bool isValid = true;
+
+        while (fgets(line, sizeof(line), file))
+        {
+            FitObject object = {};
+            double *state = object.state;
+            int fieldCount = sscanf(line, " %63[^,\r\n],%lf,%lf,%lf,%lf,%lf,%lf", object.name,
+                                    &state[0], &state[1], &state[2], &state[3], &state[4], &state[5]);
+
+            if ((fieldCount <= 0) || (strcmp(object.name, "name") == 0))
+            {
+                continue;
+            }
+
+            if (fieldCount == 1)
+            {
+                int body = findFitBody(seeds, object.name);
+                if (body < 0)
+                {
+                    fprintf(stderr, "orbitalsim_fit: %s is no significant body, and has no state\n", object.name);
+                    isValid = false;
+                    break;
+                }
+
+                Vector3 position = seeds->bodies[body].position;
+                Vector3 velocity = seeds->bodies[body].velocity;
+                double seed[FIT_PARAMETERS] = {position.x, position.y, position.z,
+                                                velocity.x, velocity.y, velocity.z};
+                memcpy(state, seed, sizeof(seed));
+            }
+
+            else if (fieldCount != 1 + FIT_PARAMETERS)
+            {
+                fprintf(stderr, "orbitalsim_fit: incomplete state for %s\n", object.name);
+                isValid = false;
+                break;
+            }
+
+            int body = findFitBody(seeds, object.name);
+            if ((body >= 0) && (body < seeds->moonCount))
+            {
+                fprintf(stderr, "orbitalsim_fit: %s is a moon, integrated in its planet's frame, and cannot be fitted\n",
+                        object.name);
+                isValid = false;
+                break;
+            }
+
+            if (!strcmp(object.name, SKY_OBSERVER) || !strcmp(object.name, SKY_ILLUMINATOR))
+            {
+                fprintf(stderr, "orbitalsim_fit: %s is the observer or illuminator, and cannot be fitted\n",
+                        object.name);
+                isValid = false;
+                break;
+            }
+
+            if (findFitObject(objects, object.name) >= 0)
+            {
+                fprintf(stderr, "orbitalsim_fit: %s is listed twice\n", object.name);
+                isValid = false;
+                break;
+            }
+
+            objects.push_back(object);
+        }
+
+        destroyOrbitalSim(seeds);
+        fclose(file);
+
+        return isValid && !objects.empty();
+    }
+
+
+    /// @brief Loads the observations file, sorted by time. Observations of objects that are not
+            // fitted are skipped
+    /// @param filename Observations CSV (lines that do not parse, like the header, are skipped)
+    /// @param objects The objects
+    /// @param observations Destination observations
+    /// @return Whether at least one observation was read
+    bool loadFitObservations(const char *filename, std::vector<FitObject> &objects,
+                            std::vector<FitObservation> &observations)
+    {
+        FILE *file = fopen(filename, "r");
+        if (!file)
+        {
+            fprintf(stderr, "orbitalsim_fit: could not open %s\n", filename);
+            return false;
+        }
+
+        char line[256];
+        char name[64];
+        double time, rightAscension, declination;
+        int skippedCount = 0;
+
+        while (fgets(line, sizeof(line), file))
+        {
+            if (sscanf(line, " %63[^,],%lf,%lf,%lf", name, &time, &rightAscension, &declination) != 4)
+            {
+                continue;
+            }
+
+            int object = findFitObject(objects, name);
+
+            // The simulation only runs forward from the epoch
+            if ((object < 0) || (time < 0))
+            {
+                skippedCount++;
+                continue;
+            }
+
+            observations.push_back({time * SECONDS_PER_DAY, object, rightAscension / DEGREES_PER_RADIAN,
+                                    declination / DEGREES_PER_RADIAN});
+            objects[object].observationCount++;
+        }
+
+        fclose(file);
+
+        if (skippedCount)
+        {
+            fprintf(stderr, "orbitalsim_fit: skipped %d observations of unknown objects or before the epoch\n",
+                    skippedCount);
+        }
+
+        std::stable_sort(observations.begin(), observations.end(),
+                        [](const FitObservation &a, const FitObservation &b) { return a.time < b.time; });
+
+        return !observations.empty();
+    }
+
+
+    //* LEAST SQUARES
+
+    /// @brief Wraps an angle difference to [-pi, pi]
+    /// @param angle Angle difference [rad]
+    /// @return The wrapped difference [rad]
+    double wrapAngle(double angle)
+    {
+        return angle - 2.0 * M_PI * floor((angle + M_PI) / (2.0 * M_PI));
+    }
+
+
+    /// @brief Solves the normal equations by Gaussian elimination with partial pivoting
+    /// @param normal Normal matrix, overwritten
+    /// @param rhs Right-hand side, overwritten
+    /// @param solution Destination solution
+    /// @return Whether the matrix was regular
+    bool solveFitEquations(double normal[FIT_PARAMETERS][FIT_PARAMETERS], double rhs[FIT_PARAMETERS],
+                            double solution[FIT_PARAMETERS])
+    {
+        double scale = 0;
+        for (int i = 0; i < FIT_PARAMETERS; i++)
+        {
+            scale = fmax(scale, fabs(normal[i][i]));
+        }
+
+        for (int column = 0; column < FIT_PARAMETERS; column++)
+        {
+            int pivot = column;
+            for (int row = column + 1; row < FIT_PARAMETERS; row++)
+            {
+                if (fabs(normal[row][column]) > fabs(normal[pivot][column]))
+                {
+                    pivot = row;
+                }
+            }
+
+            // Some combination of the state is not constrained by the observations
+            if (!(fabs(normal[pivot][column]) > 1E-14 * scale))
+            {
+                return false;
+            }
+
+            for (int i = 0; i < FIT_PARAMETERS; i++)
+            {
+                std::swap(normal[column][i], normal[pivot][i]);
+            }
+            std::swap(rhs[column], rhs[pivot]);
+
+            for (int row = column + 1; row < FIT_PARAMETERS; row++)
+            {
+                double factor = normal[row][column] / normal[column][column];
+
+                for (int i = column; i < FIT_PARAMETERS; i++)
+                {
+                    normal[row][i] -= factor * normal[column][i];
+                }
+                rhs[row] -= factor * rhs[column];
+            }
+        }
+
+        for (int row = FIT_PARAMETERS - 1; row >= 0; row--)
+        {
+            double sum = rhs[row];
+            for (int i = row + 1; i < FIT_PARAMETERS; i++)
+            {
+                sum -= normal[row][i] * solution[i];
+            }
+
+            solution[row] = sum / normal[row][row];
+        }
+
+        return true;
+    }
+
+
+    /// @brief Gets the state of an object for a clone
+    /// @param object The object
+    /// @param clone 0 for the nominal state, k for the one with component k - 1 nudged
+    /// @param position Where to store the position [m]
+    /// @param velocity Where to store the velocity [m/s]
+    void getFitCloneState(const FitObject &object, int clone, Vector3 *position, Vector3 *velocity)
+    {
+        double state[FIT_PARAMETERS];
+        memcpy(state, object.state, sizeof(state));
+
+        if (clone > 0)
+        {
+            state[clone - 1] += object.perturbation[clone - 1];
+        }
+
+        *position = {(float)state[0], (float)state[1], (float)state[2]};
+        *velocity = {(float)state[3], (float)state[4], (float)state[5]};
+    }
+
+
+    /// @brief Integrates every object and its clones through the observations, and accumulates
+            // the residuals and normal equations of every object. Test particles are clones in
+            // the asteroids of one simulation. A fitted significant body stays massive, so the
+            // Sun's reflex and the observer's orbit follow it: each of its nudged states gets a
+            // simulation of its own, stepped along with the main one
+    /// @param objects The objects
+    /// @param observations The observations, sorted by time
+    void evaluateFit(std::vector<FitObject> &objects, const std::vector<FitObservation> &observations)
+    {
+        OrbitalSim *sim = constructOrbitalSim(FIT_TIME_STEP, (int)objects.size() * FIT_CLONES);
+        sim->tuning.kernel = ASTEROID_KERNEL_TILED;
+        sim->tuning.threadCount = getHardwareThreadCount();
+
+        std::vector<Asteroid> clones;
+        std::vector<int> bodies(objects.size());            // Significant body, or -1
+        std::vector<int> slots(objects.size(), -1);         // First clone in the asteroids
+        std::vector<OrbitalSim *> bodySims(objects.size() * FIT_PARAMETERS, NULL);
+
+        for (size_t i = 0; i < objects.size(); i++)
+        {
+            FitObject &object = objects[i];
+            bodies[i] = findFitBody(sim, object.name);
+
+            if (bodies[i] >= 0)
+            {
+                Vector3 position, velocity;
+                getFitCloneState(object, 0, &position, &velocity);
+                setOrbitalSimBody(sim, bodies[i], position, velocity);
+            }
+
+            else
+            {
+                slots[i] = (int)clones.size();
+
+                for (int clone = 0; clone < FIT_CLONES; clone++)
+                {
+                    Asteroid asteroid;
+                    getFitCloneState(object, clone, &asteroid.position, &asteroid.velocity);
+                    clones.push_back(asteroid);
+                }
+            }
+
+            memset(object.normal, 0, sizeof(object.normal));
+            memset(object.rhs, 0, sizeof(object.rhs));
+            object.residualSqr = 0;
+        }
+
+        setOrbitalSimAsteroids(sim, clones.data(), (int)clones.size());
+
+        // Every fitted body at its nominal state, but the nudged one
+        for (size_t i = 0; i < objects.size(); i++)
+        {
+            for (int k = 0; (bodies[i] >= 0) && (k < FIT_PARAMETERS); k++)
+            {
+                OrbitalSim *bodySim = constructOrbitalSim(FIT_TIME_STEP, 0);
+
+                for (size_t j = 0; j < objects.size(); j++)
+                {
+                    if (bodies[j] >= 0)
+                    {
+                        Vector3 position, velocity;
+                        getFitCloneState(objects[j], (j == i) ? k + 1 : 0, &position, &velocity);
+                        setOrbitalSimBody(bodySim, bodies[j], position, velocity);
+                    }
+                }
+
+                bodySims[i * FIT_PARAMETERS + k] = bodySim;
+            }
+        }
+
+        int observerIndex = findFitBody(sim, SKY_OBSERVER);
+        int illuminatorIndex = findFitBody(sim, SKY_ILLUMINATOR);
+
+        // Kept apart from sim->time, whose float loses whole seconds within a year
+        double time = 0;
+
+        for (size_t i = 0; i < observations.size(); i++)
+        {
+            const FitObservation &observation = observations[i];
+
+            while (observation.time - time > 1.0)
+            {
+                sim->timeStep = (float)fmin(FIT_TIME_STEP, observation.time - time);
+                updateOrbitalSim(sim);
+
+                for (size_t j = 0; j < bodySims.size(); j++)
+                {
+                    if (bodySims[j])
+                    {
+                        bodySims[j]->timeStep = sim->timeStep;
+                        updateOrbitalSim(bodySims[j]);
+                    }
+                }
+
+                time += sim->timeStep;
+            }
+
+            // What is left is under a second
+            float remainder = (float)(observation.time - time);
+
+            FitObject &object = objects[observation.object];
+            int body = bodies[observation.object];
+            double rightAscensions[FIT_CLONES];
+            double declinations[FIT_CLONES];
+
+            for (int clone = 0; clone < FIT_CLONES; clone++)
+            {
+                // A body's clone is seen from its own simulation, whose observer it pulls on
+                OrbitalSim *cloneSim = ((body >= 0) && (clone > 0)) ?
+                                        bodySims[observation.object * FIT_PARAMETERS + clone - 1] : sim;
+                OrbitalBody *observer = &cloneSim->bodies[observerIndex];
+                Vector3 observerPosition = Vector3Add(observer->position, Vector3Scale(observer->velocity, remainder));
+                Vector3 illuminatorPosition = cloneSim->bodies[illuminatorIndex].position;
+
+                Vector3 position, velocity;
+                if (body >= 0)
+                {
+                    position = cloneSim->bodies[body].position;
+                    velocity = cloneSim->bodies[body].velocity;
+                }
+
+                else
+                {
+                    Asteroid *asteroid = &sim->asteroids[slots[observation.object] + clone];
+                    position = asteroid->position;
+                    velocity = asteroid->velocity;
+                }
+
+                position = Vector3Add(position, Vector3Scale(velocity, remainder));
+                SkyPosition sky = calculateSkyPosition(position, velocity, observerPosition, illuminatorPosition);
+
+                rightAscensions[clone] = sky.rightAscension;
+                declinations[clone] = sky.declination;
+            }
+
+            // Residuals and partials on the sky plane: right ascension shrinks towards the poles
+            double cosDeclination = cos(observation.declination);
+            double residuals[2] = {wrapAngle(observation.rightAscension - rightAscensions[0]) * cosDeclination,
+                                    observation.declination - declinations[0]};
+            double partials[2][FIT_PARAMETERS];
+
+            for (int k = 0; k < FIT_PARAMETERS; k++)
+            {
+                partials[0][k] = wrapAngle(rightAscensions[k + 1] - rightAscensions[0]) * cosDeclination;
+                partials[1][k] = declinations[k + 1] - declinations[0];
+            }
+
+            for (int axis = 0; axis < 2; axis++)
+            {
+                object.residualSqr += residuals[axis] * residuals[axis];
+
+                for (int k = 0; k < FIT_PARAMETERS; k++)
+                {
+                    object.rhs[k] += partials[axis][k] * residuals[axis];
+
+                    for (int l = 0; l < FIT_PARAMETERS; l++)
+                    {
+                        object.normal[k][l] += partials[axis][k] * partials[axis][l];
+                    }
+                }
+            }
+        }
+
+        for (size_t i = 0; i < bodySims.size(); i++)
+        {
+            if (bodySims[i])
+            {
+                destroyOrbitalSim(bodySims[i]);
+            }
+        }
+
+        destroyOrbitalSim(sim);
+    }
+
+
+    /// @brief Takes one Gauss-Newton step for every object that has not converged. A step that
+            // made the residual worse is undone and retried at half the length, FIT_BACKTRACKS
+            // times at most
+    /// @param objects The objects, just evaluated
+    /// @param isLast Whether no more evaluations follow: objects are left at their best state
+    /// @return Number of objects that took a step
+    int stepFit(std::vector<FitObject> &objects, bool isLast)
+    {
+        int steppedCount = 0;
+
+        for (size_t i = 0; i < objects.size(); i++)
+        {
+            FitObject &object = objects[i];
+
+            if (object.isConverged)
+            {
+                continue;
+            }
+
+            double rms = sqrt(object.residualSqr / (2 * object.observationCount));
+
+            if ((object.iterationCount > 0) && !(rms <= object.rms))
+            {
+                bool isRetrying = !isLast && (object.backtrackCount < FIT_BACKTRACKS);
+
+                for (int k = 0; k < FIT_PARAMETERS; k++)
+                {
+                    object.stepSize[k] *= 0.5;
+                    object.state[k] = object.previousState[k] + (isRetrying ? object.stepSize[k] : 0);
+                }
+
+                object.backtrackCount++;
+                object.isConverged = !isRetrying;
+                steppedCount += isRetrying;
+                continue;
+            }
+
+            bool isImproving = (object.iterationCount == 0) || (object.rms - rms > FIT_CONVERGENCE * rms);
+            object.rms = rms;
+
+            if (!isImproving || isLast)
+            {
+                object.isConverged = !isImproving;
+                continue;
+            }
+
+            double solution[FIT_PARAMETERS];
+            if (!solveFitEquations(object.normal, object.rhs, solution))
+            {
+                fprintf(stderr, "orbitalsim_fit: the observations of %s do not constrain its state\n", object.name);
+                object.isConverged = true;
+                continue;
+            }
+
+            for (int k = 0; k < FIT_PARAMETERS; k++)
+            {
+                object.previousState[k] = object.state[k];
+                object.stepSize[k] = solution[k] * object.perturbation[k];
+                object.state[k] += object.stepSize[k];
+            }
+
+            object.iterationCount++;
+            object.backtrackCount = 0;
+            steppedCount++;
+        }
+
+        return steppedCount;
+    }
+
+
+    //* OUTPUT
+
+    /// @brief Prints the fitted states as an objects CSV, and a report with ephemerides.h seeds
+    /// @param objects The fitted objects
+    void printFitObjects(const std::vector<FitObject> &objects)
+    {
+        printf("name,x,y,z,vx,vy,vz,rms_arcsec,observations\n");
+
+        for (size_t i = 0; i < objects.size(); i++)
+        {
+            const FitObject &object = objects[i];
+            const double *state = object.state;
+
+            printf("%s,%.15E,%.15E,%.15E,%.15E,%.15E,%.15E,%.4f,%d\n", object.name, state[0], state[1], state[2],
+                    state[3], state[4], state[5], object.rms * ARCSECONDS_PER_RADIAN, object.observationCount);
+
+            fprintf(stderr, "orbitalsim_fit: %s: rms %.4f arcsec over %d observations, %d iterations%s\n",
+                    object.name, object.rms * ARCSECONDS_PER_RADIAN, object.observationCount,
+                    object.iterationCount, object.isConverged ? "" : " (not converged)");
+            fprintf(stderr, "            {%.15EF, %.15EF, %.15EF},\n", state[0], state[1], state[2]);
+            fprintf(stderr, "            {%.15EF, %.15EF, %.15EF},\n", state[3], state[4], state[5]);
+        }
+    }
+
+
+/* *****************************************************************
+    * MAIN LOGIC *
+   ***************************************************************** */
+
+    int main(int argc, char **argv)
+    {
+        const char *objectsFilename = NULL;
+        const char *observationsFilename = NULL;
+        int iterationCount = FIT_ITERATIONS;
+
+        for (int i = 1; i < argc; i++)
+        {
+            if ((strcmp(argv[i], "--objects") == 0) && (i + 1 < argc))
+            {
+                objectsFilename = argv[++i];
+            }
+
+            else if ((strcmp(argv[i], "--observations") == 0) && (i + 1 < argc))
+            {
+                observationsFilename = argv[++i];
+            }
+
+            else if ((strcmp(argv[i], "--iterations") == 0) && (i + 1 < argc))
+            {
+                iterationCount = atoi(argv[++i]);
+            }
+
+            else
+            {
+                objectsFilename = NULL;
+                break;
+            }
+        }
+
+        if (!objectsFilename || !observationsFilename || (iterationCount <= 0))
+        {
+            fprintf(stderr, "usage: orbitalsim_fit --objects objects.csv --observations observations.csv "
+                            "[--iterations n]\n");
+            return 1;
+        }
+
+        std::vector<FitObject> objects;
+        std::vector<FitObservation> observations;
+
+        if (!loadFitObjects(objectsFilename, objects) ||
+            !loadFitObservations(observationsFilename, objects, observations))
+        {
+            return 1;
+        }
+
+        for (size_t i = 0; i < objects.size(); i++)
+        {
+            FitObject &object = objects[i];
+            double positionLength = sqrt(object.state[0] * object.state[0] + object.state[1] * object.state[1] +
+                                        object.state[2] * object.state[2]);
+            double velocityLength = sqrt(object.state[3] * object.state[3] + object.state[4] * object.state[4] +
+                                        object.state[5] * object.state[5]);
+
+            for (int k = 0; k < 3; k++)
+            {
+                object.perturbation[k] = FIT_PERTURBATION * fmax(positionLength, 1.0);
+                object.perturbation[k + 3] = FIT_PERTURBATION * fmax(velocityLength, 1.0);
+            }
+
+            // Two values per observation for six unknowns
+            if (2 * object.observationCount < FIT_PARAMETERS)
+            {
+                fprintf(stderr, "orbitalsim_fit: %s needs at least 3 observations, has %d\n", object.name,
+                        object.observationCount);
+                object.isConverged = true;
+                object.rms = NAN;
+            }
+        }
+
+        for (int iteration = 0; iteration < iterationCount; iteration++)
+        {
+            evaluateFit(objects, observations);
+
+            if (!stepFit(objects, iteration + 1 == iterationCount))
+            {
+                break;
+            }
+        }
+
+        printFitObjects(objects);
+
+        return 0;
+    }
@@ -0,0 +1,122 @@
+/* *****************************************************************
+    * FILE INFORMATION *
+   ***************************************************************** */
+
+/// @brief Frame-time spike flight recorder: keeps the last seconds of per-frame records in a
+        // fixed-size ring and dumps them to disk when a frame exceeds its budget
+/// @author Marc S. Ressl, Ian A. Dib, Luciano S. Cordero
+/// @copyright Copyright (c) 2022-2023
+
+
+/* *****************************************************************
+    * FILE CONFIGURATION *
+   ***************************************************************** */
+
+    //* NECESSARY LIBRARIES
+
+    #include <stdio.h>
+    #include <time.h>
+
+
+    //* NECESSARY HEADERS
+
+    #include "flightRecorder.h"
+
+
+    //* PRIVATE FUNCTIONS PROTOTYPES
+
+    static void dumpFlightRecords(FlightRecorder *recorder);
+
+
+/* *****************************************************************
+    * LOGIC MODULES *
+   ***************************************************************** */
+
+    //* FLIGHT RECORDER MANAGEMENT
+
+    /// @brief Constructs a flight recorder. All memory is allocated here, recording never allocates
+    /// @param fps Target frames per second
+    /// @param budget Spike threshold, in target frame periods
+    /// @return The flight recorder
+    FlightRecorder *constructFlightRecorder(int fps, float budget)
+    {
+        FlightRecorder *recorder = new FlightRecorder;
+
+        recorder->capacity = fps * FLIGHT_RECORDER_SECONDS;
+        recorder->records = new FlightRecord[recorder->capacity];
+        recorder->next = 0;
+        recorder->count = 0;
+        recorder->frameBudget = budget / fps;
+        recorder->lastDumpTime = -FLIGHT_RECORDER_SECONDS;
+        recorder->dumpCount = 0;
+
+        time_t now = time(NULL);
+        strftime(recorder->session, sizeof(recorder->session), "%Y%m%d-%H%M%S", localtime(&now));
+
+        return recorder;
+    }
+
+
+    /// @brief Destroys a flight recorder
+    /// @param recorder The flight recorder
+    void destroyFlightRecorder(FlightRecorder *recorder)
+    {
+        delete[] recorder->records;
+        delete recorder;
+    }
+
+
+    //* RECORDING
+
+    /// @brief Writes the recorded history, oldest frame first, as CSV
+    /// @param recorder The flight recorder
+    static void dumpFlightRecords(FlightRecorder *recorder)
+    {
+        char fileName[64];
+        snprintf(fileName, sizeof(fileName), FLIGHT_RECORDER_FILE_FORMAT, recorder->session, recorder->dumpCount);
+
+        FILE *file = fopen(fileName, "w");
+        if (!file)
+        {
+            return;
+        }
+
+        fprintf(file, "time,frame_time,step_time,force_time,render_time,bodies,asteroids,steps,spike\n");
+
+        int first = (recorder->next - recorder->count + recorder->capacity) % recorder->capacity;
+
+        for (int i = 0; i < recorder->count; i++)
+        {
+            FlightRecord *record = &recorder->records[(first + i) % recorder->capacity];
+
+            fprintf(file, "%.6f,%.6f,%.6f,%.6f,%.6f,%d,%d,%d,%d\n", record->time, record->frameTime,
+                    record->stepTime, record->forceTime, record->renderTime, record->bodyCount,
+                    record->asteroidCount, record->steps, record->frameTime > recorder->frameBudget);
+        }
+
+        fclose(file);
+        recorder->dumpCount++;
+    }
+
+
+    /// @brief Records a frame and dumps the history if the frame is a spike. Dumps are at least
+            // one history length apart, so a long stutter (or the dump itself) is not dumped twice
+    /// @param recorder The flight recorder
+    /// @param record The frame record
+    void recordFlightFrame(FlightRecorder *recorder, FlightRecord record)
+    {
+        recorder->records[recorder->next] = record;
+        recorder->next = (recorder->next + 1) % recorder->capacity;
+
+        if (recorder->count < recorder->capacity)
+        {
+            recorder->count++;
+        }
+
+        if ((record.frameTime > recorder->frameBudget) &&
+            (record.time - recorder->lastDumpTime >= FLIGHT_RECORDER_SECONDS))
+        {
+            dumpFlightRecords(recorder);
+            recorder->lastDumpTime = record.time;
+        }
+    }
@@ -0,0 +1,71 @@
+/* *****************************************************************
+    * FILE INFORMATION *
+   ***************************************************************** */
+
+/// @brief Frame-time spike flight recorder: keeps the last seconds of per-frame records in a
+        // fixed-size ring and dumps them to disk when a frame exceeds its budget
+/// @author Marc S. Ressl, Ian A. Dib, Luciano S. Cordero
+/// @copyright Copyright (c) 2022-2023
+
+
+/* *****************************************************************
+    * HEADER CONFIGURATION *
+   ***************************************************************** */
+
+    #ifndef FLIGHTRECORDER_H
+    #define FLIGHTRECORDER_H
+
+
+    //* CONFIGURATION
+
+    #define FLIGHT_RECORDER 1
+
+    // History dumped on a spike [s]
+    #define FLIGHT_RECORDER_SECONDS 10
+
+    // A frame is a spike when it takes longer than this many target frame periods
+    #define FLIGHT_RECORDER_BUDGET 2.0F
+
+    // Dump file name, from the session's start time and the dump number, so a new session does
+    // not overwrite the dumps of the previous one
+    #define FLIGHT_RECORDER_FILE_FORMAT "orbitalsim-spike-%s-%03u.csv"
+
+
+    //* CONSTANTS & STRUCTURES
+
+    /// @brief Per-frame record
+    struct FlightRecord
+    {
+        double time;            // Wall time since the recorder was constructed [s]
+        float frameTime;        // [s]
+        float stepTime;         // Simulation steps of the frame [s]
+        float forceTime;        // Force calculation of the last step [s]
+        float renderTime;       // [s]
+        int bodyCount;
+        int asteroidCount;
+        int steps;              // Simulation steps taken during the frame
+    };
+
+
+    /// @brief Flight recorder
+    struct FlightRecorder
+    {
+        FlightRecord *records;
+        int capacity;
+        int next;               // Slot of the next record
+        int count;              // Valid records
+        float frameBudget;      // [s]
+        double lastDumpTime;    // [s]
+        unsigned int dumpCount;
+        char session[16];       // Start time, as YYYYMMDD-HHMMSS
+    };
+
+
+    //* PUBLIC FUNCTIONS PROTOTYPES
+
+    FlightRecorder *constructFlightRecorder(int fps, float budget);
+    void destroyFlightRecorder(FlightRecorder *recorder);
+    void recordFlightFrame(FlightRecorder *recorder, FlightRecord record);
+
+
+    #endif // FLIGHTRECORDER_H
@@ -13,14 +13,29 @@
 
     //* NECESSARY HEADERS
 
-    #include "OrbitalSim.h"
-    #include "View.h"
+    #include <algorithm>
+
+    #include "orbitalSim.h"
+    #include "view.h"
+    #include "snapshot.h"
+    #include "metrics.h"
+    #include "flightRecorder.h"
+    #include "autotuner.h"
+    #include "qualityGovernor.h"
 
 
     //* CONSTANTS
 
     #define SECONDS_PER_DAY 86400
 
+    // Physics steps per second of wall time. Frames in between are interpolated by the view
+    #define PHYSICS_RATE 30
+
+    // Most physics steps per frame: after a slow frame (like a tuning run) the simulation
+    // falls behind the wall clock instead of trying to catch up. The quality governor may
+    // lower it further
+    #define PHYSICS_MAX_STEPS 4
+
     
 /* *****************************************************************
     * MAIN LOGIC *
@@ -34,25 +49,134 @@
         // Simulation speed: 50 days per simulation second
         float timeMultiplier = 50 * SECONDS_PER_DAY;
 
-        // Time interval used to analyze data
-        float timeStep = timeMultiplier / fps;
+        // Time interval used to analyze data: one step per physics tick
+        float timeStep = timeMultiplier / PHYSICS_RATE;
 
 
         //* SIMULATION SETUP, UPDATE AND RENDERING
 
         OrbitalSim *sim = constructOrbitalSim(timeStep);
+
         View *view = constructView(fps);
 
+        // Quantized copies of the two latest simulation states consumed by the render path
+        Snapshot *snapshot = constructSnapshot(sim);
+        Snapshot *previousSnapshot = constructSnapshot(sim);
+        packSnapshot(snapshot, sim);
+        packSnapshot(previousSnapshot, sim);
+
+        if (METRICS_ENDPOINT)
+        {
+            registerOrbitalSimMetrics(sim);
+            startMetricsServer(METRICS_PORT);
+        }
+
+        // Always-on history of frame times, dumped to disk on spikes
+        FlightRecorder *recorder = FLIGHT_RECORDER ? constructFlightRecorder(fps, FLIGHT_RECORDER_BUDGET) : NULL;
+        uint64_t startTime = getMetricsTime();
+        uint64_t frameStart = startTime;
+
+        // Fixed physics ticks: wall time not yet simulated [ns]
+        uint64_t physicsPeriod = (uint64_t)(1E9 / PHYSICS_RATE);
+        uint64_t physicsBacklog = 0;
+        uint64_t physicsClock = startTime;
+
+        // Trades quality for speed when frames run over the target period
+        QualityGovernor *governor = QUALITY_GOVERNOR ? constructQualityGovernor(fps, PHYSICS_MAX_STEPS) : NULL;
+        int physicsSteps = PHYSICS_MAX_STEPS;
+
+        // Tuning waits for the whole belt: the asteroids are generated in the background
+        bool isTuned = !AUTOTUNER;
+
         while (isViewRendering(view))
         {
-            updateOrbitalSim(sim);
-            renderView(view, sim);
+            // Tune again on demand, ignoring the cached choice
+            if (AUTOTUNER && IsKeyPressed(KEY_T))
+            {
+                autotuneOrbitalSim(sim);
+            }
+
+            uint64_t now = getMetricsTime();
+            physicsBacklog += now - physicsClock;
+            physicsClock = now;
+
+            uint64_t stepTime = 0;
+            int stepCount = 0;
+            for (; (stepCount < physicsSteps) && (physicsBacklog >= physicsPeriod); stepCount++)
+            {
+                uint64_t stepStart = getMetricsTime();
+                updateOrbitalSim(sim);
+                stepTime += getMetricsTime() - stepStart;
+
+                if (!isTuned && (sim->asteroidCount == sim->asteroidCapacity))
+                {
+                    tuneOrbitalSim(sim);
+                    isTuned = true;
+                }
+
+                std::swap(snapshot, previousSnapshot);
+                packSnapshot(snapshot, sim);
+                physicsBacklog -= physicsPeriod;
+            }
+
+            if (physicsBacklog >= physicsPeriod)
+            {
+                physicsBacklog %= physicsPeriod;
+            }
+
+            // Frames are presented one tick behind the physics, between the two latest steps
+            float fraction = (float)physicsBacklog / physicsPeriod;
+            renderView(view, snapshot, previousSnapshot,
+                        previousSnapshot->time + fraction * (snapshot->time - previousSnapshot->time));
+
+            if (governor)
+            {
+                float renderTime = metrics.phases[METRICS_PHASE_RENDER].lastNanoseconds.load() * 1E-9F;
+                updateQualityGovernor(governor, stepTime * 1E-9F + renderTime, GetFrameTime());
+
+                view->renderDistance = governor->renderDistance;
+                view->asteroidStride = governor->asteroidStride;
+                physicsSteps = governor->physicsSteps;
+            }
+
+            if (recorder)
+            {
+                uint64_t frameEnd = getMetricsTime();
+                FlightRecord record;
+
+                record.time = (frameEnd - startTime) * 1E-9;
+                record.frameTime = (frameEnd - frameStart) * 1E-9F;
+                record.stepTime = stepTime * 1E-9F;
+                record.forceTime = (metrics.phases[METRICS_PHASE_SIGNIFICANT_BODIES].lastNanoseconds.load() +
+                                    metrics.phases[METRICS_PHASE_ASTEROIDS].lastNanoseconds.load()) * 1E-9F;
+                record.renderTime = metrics.phases[METRICS_PHASE_RENDER].lastNanoseconds.load() * 1E-9F;
+                record.bodyCount = sim->bodyCount;
+                record.asteroidCount = sim->asteroidCount;
+                record.steps = stepCount;
+
+                recordFlightFrame(recorder, record);
+                frameStart = frameEnd;
+            }
         }
 
 
         //* SIMULATION STOP AND CLEANUP
 
+        stopMetricsServer();
+
+        if (recorder)
+        {
+            destroyFlightRecorder(recorder);
+        }
+
+        if (governor)
+        {
+            destroyQualityGovernor(governor);
+        }
+
         destroyView(view);
+        destroySnapshot(snapshot);
+        destroySnapshot(previousSnapshot);
         destroyOrbitalSim(sim);
 
         return 0;
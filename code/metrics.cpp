@@ -0,0 +1,370 @@
+/* *****************************************************************
+    * FILE INFORMATION *
+   ***************************************************************** */
+
+/// @brief Lock-free performance counters and a localhost Prometheus metrics endpoint
+/// @author Marc S. Ressl, Ian A. Dib, Luciano S. Cordero
+/// @copyright Copyright (c) 2022-2023
+
+
+/* *****************************************************************
+    * FILE CONFIGURATION *
+   ***************************************************************** */
+
+    //* NECESSARY LIBRARIES
+
+    #include <stdio.h>
+    #include <string.h>
+    #include <chrono>
+    #include <string>
+    #include <thread>
+
+    #ifdef _WIN32
+    #include <winsock2.h>
+    #include <ws2tcpip.h>
+    typedef SOCKET MetricsSocket;
+    #define closeMetricsSocket closesocket
+    #else
+    #include <arpa/inet.h>
+    #include <netinet/in.h>
+    #include <sys/select.h>
+    #include <sys/socket.h>
+    #include <unistd.h>
+    typedef int MetricsSocket;
+    #define INVALID_SOCKET (-1)
+    #define closeMetricsSocket close
+    #endif
+
+
+    //* NECESSARY HEADERS
+
+    #include "metrics.h"
+
+
+    //* CONSTANTS
+
+    // Upper bounds of the latency histogram buckets [s], the last bucket is +Inf
+    static const double histogramBounds[METRICS_HISTOGRAM_BUCKETS - 1] =
+    {
+        1E-6, 5E-6, 1E-5, 5E-5, 1E-4, 5E-4, 1E-3, 5E-3, 1E-2, 5E-2, 1E-1, 1.0
+    };
+
+    static const char *phaseNames[METRICS_PHASE_NUM] =
+    {
+        "significant_bodies", "asteroids", "integration", "sky_positions", "render"
+    };
+
+    // The server wakes up at least this often to update rates and check for shutdown [s]
+    #define METRICS_SAMPLE_PERIOD 1
+
+
+    //* GLOBAL VARIABLES
+
+    Metrics metrics;
+
+    static std::thread metricsServerThread;
+    static std::atomic<bool> isMetricsServerRunning(false);
+    static MetricsSocket metricsServerSocket = INVALID_SOCKET;
+
+    // Rates, updated by the server thread once per sample period
+    static double stepsPerSecond;
+    static double interactionsPerSecond;
+
+
+    //* PRIVATE FUNCTIONS PROTOTYPES
+
+    static void updateMetricsRates(uint64_t *lastSteps, uint64_t *lastInteractions, uint64_t *lastTime);
+    static std::string formatMetrics();
+    static void serveMetricsClient(MetricsSocket client);
+    static void runMetricsServer();
+
+
+/* *****************************************************************
+    * LOGIC MODULES *
+   ***************************************************************** */
+
+    //* COUNTERS
+
+    /// @brief Gets a monotonic timestamp for phase timing
+    /// @return Time [ns]
+    uint64_t getMetricsTime()
+    {
+        return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+
+    /// @brief Records the duration of a phase, from startTime until now
+    /// @param phase The phase
+    /// @param startTime Timestamp taken with getMetricsTime when the phase started [ns]
+    void recordMetricsPhase(MetricsPhase phase, uint64_t startTime)
+    {
+        uint64_t duration = getMetricsTime() - startTime;
+        double seconds = duration * 1E-9;
+
+        int bucket = 0;
+        while ((bucket < METRICS_HISTOGRAM_BUCKETS - 1) && (seconds > histogramBounds[bucket]))
+        {
+            bucket++;
+        }
+
+        MetricsHistogram *histogram = &metrics.phases[phase];
+        histogram->buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+        histogram->count.fetch_add(1, std::memory_order_relaxed);
+        histogram->sumNanoseconds.fetch_add(duration, std::memory_order_relaxed);
+        histogram->lastNanoseconds.store(duration, std::memory_order_relaxed);
+    }
+
+
+    //* PROMETHEUS TEXT FORMAT
+
+    /// @brief Updates the per-second rates from the counters
+    /// @param lastSteps Steps at the previous sample
+    /// @param lastInteractions Interactions at the previous sample
+    /// @param lastTime Time of the previous sample [ns]
+    static void updateMetricsRates(uint64_t *lastSteps, uint64_t *lastInteractions, uint64_t *lastTime)
+    {
+        uint64_t now = getMetricsTime();
+        uint64_t steps = metrics.steps.load(std::memory_order_relaxed);
+        uint64_t interactions = metrics.interactions.load(std::memory_order_relaxed);
+        double elapsed = (now - *lastTime) * 1E-9;
+
+        if (elapsed >= METRICS_SAMPLE_PERIOD)
+        {
+            stepsPerSecond = (steps - *lastSteps) / elapsed;
+            interactionsPerSecond = (interactions - *lastInteractions) / elapsed;
+
+            *lastSteps = steps;
+            *lastInteractions = interactions;
+            *lastTime = now;
+        }
+    }
+
+
+    /// @brief Formats every metric in the Prometheus text exposition format
+    /// @return The metrics text
+    /// @cite https://prometheus.io/docs/instrumenting/exposition_formats/
+    static std::string formatMetrics()
+    {
+        std::string text;
+        char line[512];
+
+        snprintf(line, sizeof(line),
+                "# TYPE orbitalsim_steps_total counter\norbitalsim_steps_total %llu\n"
+                "# TYPE orbitalsim_interactions_total counter\norbitalsim_interactions_total %llu\n"
+                "# TYPE orbitalsim_frames_total counter\norbitalsim_frames_total %llu\n"
+                "# TYPE orbitalsim_rollbacks_total counter\norbitalsim_rollbacks_total %llu\n",
+                (unsigned long long)metrics.steps.load(),
+                (unsigned long long)metrics.interactions.load(),
+                (unsigned long long)metrics.frames.load(),
+                (unsigned long long)metrics.rollbacks.load());
+        text += line;
+
+        snprintf(line, sizeof(line),
+                "# TYPE orbitalsim_steps_per_second gauge\norbitalsim_steps_per_second %g\n"
+                "# TYPE orbitalsim_interactions_per_second gauge\norbitalsim_interactions_per_second %g\n",
+                stepsPerSecond, interactionsPerSecond);
+        text += line;
+
+        snprintf(line, sizeof(line),
+                "# TYPE orbitalsim_energy_drift gauge\norbitalsim_energy_drift %g\n"
+                "# TYPE orbitalsim_frame_time_seconds gauge\norbitalsim_frame_time_seconds %g\n"
+                "# TYPE orbitalsim_substeps gauge\norbitalsim_substeps %d\n"
+                "# TYPE orbitalsim_load_imbalance gauge\norbitalsim_load_imbalance %g\n",
+                metrics.energyDrift.load(), metrics.frameTime.load(), metrics.substeps.load(),
+                metrics.loadImbalance.load());
+        text += line;
+
+        text += "# TYPE orbitalsim_bodies gauge\n";
+        int groupCount = metrics.groupCount.load();
+        for (int i = 0; (i < groupCount) && (i < METRICS_MAX_GROUPS); i++)
+        {
+            const char *name = metrics.groupNames[i].load();
+            snprintf(line, sizeof(line), "orbitalsim_bodies{group=\"%s\"} %d\n",
+                    name ? name : "", metrics.bodiesByGroup[i].load());
+            text += line;
+        }
+
+        text += "# TYPE orbitalsim_phase_duration_seconds histogram\n";
+        for (int phase = 0; phase < METRICS_PHASE_NUM; phase++)
+        {
+            MetricsHistogram *histogram = &metrics.phases[phase];
+            uint64_t cumulative = 0;
+
+            for (int bucket = 0; bucket < METRICS_HISTOGRAM_BUCKETS; bucket++)
+            {
+                cumulative += histogram->buckets[bucket].load(std::memory_order_relaxed);
+
+                if (bucket < METRICS_HISTOGRAM_BUCKETS - 1)
+                {
+                    snprintf(line, sizeof(line), "orbitalsim_phase_duration_seconds_bucket{phase=\"%s\",le=\"%g\"} %llu\n",
+                            phaseNames[phase], histogramBounds[bucket], (unsigned long long)cumulative);
+                }
+
+                else
+                {
+                    snprintf(line, sizeof(line), "orbitalsim_phase_duration_seconds_bucket{phase=\"%s\",le=\"+Inf\"} %llu\n",
+                            phaseNames[phase], (unsigned long long)cumulative);
+                }
+
+                text += line;
+            }
+
+            snprintf(line, sizeof(line),
+                    "orbitalsim_phase_duration_seconds_sum{phase=\"%s\"} %g\n"
+                    "orbitalsim_phase_duration_seconds_count{phase=\"%s\"} %llu\n",
+                    phaseNames[phase], histogram->sumNanoseconds.load() * 1E-9,
+                    phaseNames[phase], (unsigned long long)cumulative);
+            text += line;
+        }
+
+        return text;
+    }
+
+
+    //* METRICS SERVER
+
+    /// @brief Answers one scrape. Any request gets the metrics (HTTP/1.0, connection closed after)
+    /// @param client The accepted connection
+    static void serveMetricsClient(MetricsSocket client)
+    {
+        // This is the only server thread: a client that sends nothing, or stops reading, must
+        // not hold it (and stopMetricsServer) for longer than a sample period
+        #ifdef _WIN32
+        DWORD sendTimeout = METRICS_SAMPLE_PERIOD * 1000;
+        #else
+        struct timeval sendTimeout = {METRICS_SAMPLE_PERIOD, 0};
+        #endif
+        setsockopt(client, SOL_SOCKET, SO_SNDTIMEO, (const char *)&sendTimeout, sizeof(sendTimeout));
+
+        fd_set readSet;
+        FD_ZERO(&readSet);
+        FD_SET(client, &readSet);
+        struct timeval timeout = {METRICS_SAMPLE_PERIOD, 0};
+
+        // The request itself is not needed, but reading it avoids resetting the connection
+        if (select((int)client + 1, &readSet, NULL, NULL, &timeout) <= 0)
+        {
+            closeMetricsSocket(client);
+            return;
+        }
+
+        char request[1024];
+        recv(client, request, sizeof(request), 0);
+
+        std::string body = formatMetrics();
+        char header[128];
+        snprintf(header, sizeof(header),
+                "HTTP/1.0 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\nContent-Length: %u\r\n\r\n",
+                (unsigned)body.size());
+
+        std::string response = header + body;
+        size_t sent = 0;
+
+        while (sent < response.size())
+        {
+            int result = send(client, response.c_str() + sent, (int)(response.size() - sent), 0);
+            if (result <= 0)
+            {
+                break;
+            }
+
+            sent += result;
+        }
+
+        closeMetricsSocket(client);
+    }
+
+
+    /// @brief Server thread: answers scrapes and samples the rates
+    static void runMetricsServer()
+    {
+        uint64_t lastSteps = 0;
+        uint64_t lastInteractions = 0;
+        uint64_t lastTime = getMetricsTime();
+
+        while (isMetricsServerRunning.load())
+        {
+            fd_set readSet;
+            FD_ZERO(&readSet);
+            FD_SET(metricsServerSocket, &readSet);
+
+            struct timeval timeout = {METRICS_SAMPLE_PERIOD, 0};
+            int ready = select((int)metricsServerSocket + 1, &readSet, NULL, NULL, &timeout);
+
+            updateMetricsRates(&lastSteps, &lastInteractions, &lastTime);
+
+            if (ready > 0)
+            {
+                MetricsSocket client = accept(metricsServerSocket, NULL, NULL);
+                if (client != INVALID_SOCKET)
+                {
+                    serveMetricsClient(client);
+                }
+            }
+        }
+    }
+
+
+    /// @brief Starts the metrics server on a background thread, listening on localhost only
+    /// @param port TCP port
+    /// @return Whether the server could listen on the port
+    bool startMetricsServer(int port)
+    {
+        #ifdef _WIN32
+        WSADATA wsaData;
+        if (WSAStartup(MAKEWORD(2, 2), &wsaData) != 0)
+        {
+            return false;
+        }
+        #endif
+
+        metricsServerSocket = socket(AF_INET, SOCK_STREAM, 0);
+        if (metricsServerSocket == INVALID_SOCKET)
+        {
+            return false;
+        }
+
+        int reuseAddress = 1;
+        setsockopt(metricsServerSocket, SOL_SOCKET, SO_REUSEADDR, (const char *)&reuseAddress, sizeof(reuseAddress));
+
+        struct sockaddr_in address;
+        memset(&address, 0, sizeof(address));
+        address.sin_family = AF_INET;
+        address.sin_port = htons((unsigned short)port);
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+        if ((bind(metricsServerSocket, (struct sockaddr *)&address, sizeof(address)) != 0) ||
+            (listen(metricsServerSocket, 4) != 0))
+        {
+            fprintf(stderr, "metrics: could not listen on 127.0.0.1:%d\n", port);
+            closeMetricsSocket(metricsServerSocket);
+            metricsServerSocket = INVALID_SOCKET;
+            return false;
+        }
+
+        isMetricsServerRunning.store(true);
+        metricsServerThread = std::thread(runMetricsServer);
+
+        return true;
+    }
+
+
+    /// @brief Stops the metrics server (returns within one sample period)
+    void stopMetricsServer()
+    {
+        if (!isMetricsServerRunning.load())
+        {
+            return;
+        }
+
+        isMetricsServerRunning.store(false);
+        metricsServerThread.join();
+
+        closeMetricsSocket(metricsServerSocket);
+        metricsServerSocket = INVALID_SOCKET;
+
+        #ifdef _WIN32
+        WSACleanup();
+        #endif
+    }
@@ -0,0 +1,96 @@
+/* *****************************************************************
+    * FILE INFORMATION *
+   ***************************************************************** */
+
+/// @brief Lock-free performance counters and a localhost Prometheus metrics endpoint
+/// @author Marc S. Ressl, Ian A. Dib, Luciano S. Cordero
+/// @copyright Copyright (c) 2022-2023
+
+
+/* *****************************************************************
+    * HEADER CONFIGURATION *
+   ***************************************************************** */
+
+    #ifndef METRICS_H
+    #define METRICS_H
+
+
+    //* NECESSARY LIBRARIES
+
+    // No raylib here: metrics.cpp includes the socket headers, which clash with raylib on Windows
+    #include <stdint.h>
+    #include <atomic>
+
+
+    //* CONFIGURATION
+
+    // Serve metrics on http://127.0.0.1:METRICS_PORT/metrics
+    #define METRICS_ENDPOINT 1
+    #define METRICS_PORT 9477
+
+
+    //* CONSTANTS & STRUCTURES
+
+    // Histogram buckets (upper bounds in metrics.cpp) plus +Inf
+    #define METRICS_HISTOGRAM_BUCKETS 13
+
+    // Significant bodies plus, at most, this many asteroid groups
+    #define METRICS_MAX_GROUPS 8
+
+    /// @brief Timed phases of a simulation step and of a rendered frame
+    enum MetricsPhase
+    {
+        METRICS_PHASE_SIGNIFICANT_BODIES,
+        METRICS_PHASE_ASTEROIDS,
+        METRICS_PHASE_INTEGRATION,
+        METRICS_PHASE_SKY_POSITIONS,
+        METRICS_PHASE_RENDER,
+        METRICS_PHASE_NUM
+    };
+
+
+    /// @brief Latency histogram (non-cumulative buckets)
+    struct MetricsHistogram
+    {
+        std::atomic<uint64_t> buckets[METRICS_HISTOGRAM_BUCKETS];
+        std::atomic<uint64_t> count;
+        std::atomic<uint64_t> sumNanoseconds;
+        std::atomic<uint64_t> lastNanoseconds;              // Latest observation
+    };
+
+
+    /// @brief Counters written by the simulation and the view, read by the metrics server
+    struct Metrics
+    {
+        std::atomic<uint64_t> steps;
+        std::atomic<uint64_t> interactions;                 // Gravitational pairs evaluated
+        std::atomic<uint64_t> frames;
+        std::atomic<uint64_t> rollbacks;                    // Instability watchdog rollbacks
+        MetricsHistogram phases[METRICS_PHASE_NUM];
+
+        std::atomic<int> groupCount;
+        std::atomic<const char *> groupNames[METRICS_MAX_GROUPS];
+        std::atomic<int> bodiesByGroup[METRICS_MAX_GROUPS];
+
+        std::atomic<double> initialEnergy;                  // [J]
+        std::atomic<double> energyDrift;                    // |E - E0| / |E0|
+        std::atomic<double> frameTime;                      // Last rendered frame [s]
+        std::atomic<int> substeps;                          // Integration steps per timeStep
+        std::atomic<double> loadImbalance;                  // Busiest asteroid thread over the mean
+    };
+
+
+    //* GLOBAL VARIABLES
+
+    extern Metrics metrics;
+
+
+    //* PUBLIC FUNCTIONS PROTOTYPES
+
+    uint64_t getMetricsTime();
+    void recordMetricsPhase(MetricsPhase phase, uint64_t startTime);
+    bool startMetricsServer(int port);
+    void stopMetricsServer();
+
+
+    #endif // METRICS_H
@@ -0,0 +1,178 @@
+/* *****************************************************************
+    * FILE INFORMATION *
+   ***************************************************************** */
+
+/// @brief Keplerian orbital elements from state vectors
+/// @author Marc S. Ressl, Ian A. Dib, Luciano S. Cordero
+/// @copyright Copyright (c) 2022-2023
+
+
+/* *****************************************************************
+    * FILE CONFIGURATION *
+   ***************************************************************** */
+
+    //* NECESSARY LIBRARIES
+
+    // Enables M_PI #define in Windows
+    #define _USE_MATH_DEFINES
+
+    #include <math.h>
+
+
+    //* NECESSARY HEADERS
+
+    #include "orbitalElements.h"
+
+
+    //* CONSTANTS
+
+    // Below this, orbits are treated as circular or equatorial
+    #define ORBITAL_ELEMENTS_EPSILON 1E-9
+
+
+    //* PRIVATE FUNCTIONS PROTOTYPES
+
+    static void toEcliptic(Vector3 vector, double *ecliptic);
+    static double dot(const double *a, const double *b);
+    static double angleBetween(const double *a, const double *b);
+
+
+/* *****************************************************************
+    * LOGIC MODULES *
+   ***************************************************************** */
+
+    //* VECTOR HELPERS
+
+    /// @brief Converts a simulation vector to ecliptic coordinates (swaps y and z back)
+    /// @param vector Simulation vector
+    /// @param ecliptic Resulting ecliptic vector (3 doubles)
+    static void toEcliptic(Vector3 vector, double *ecliptic)
+    {
+        ecliptic[0] = vector.x;
+        ecliptic[1] = vector.z;
+        ecliptic[2] = vector.y;
+    }
+
+    static double dot(const double *a, const double *b)
+    {
+        return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+    }
+
+    /// @brief Angle between two vectors, clamped against rounding outside [-1, 1]
+    static double angleBetween(const double *a, const double *b)
+    {
+        double cosine = dot(a, b) / sqrt(dot(a, a) * dot(b, b));
+        return acos(fmax(-1.0, fmin(1.0, cosine)));
+    }
+
+
+    //* ORBITAL ELEMENTS
+
+    /// @brief Calculates the osculating orbital elements of a body around a center
+    /// @param relativePosition Body position relative to the center [m]
+    /// @param relativeVelocity Body velocity relative to the center [m/s]
+    /// @param gravitationalParameter mu = G * M of the center [m^3/s^2]
+    /// @return The orbital elements
+    /// @cite https://en.wikipedia.org/wiki/Orbital_elements
+    OrbitalElements calculateOrbitalElements(Vector3 relativePosition, Vector3 relativeVelocity,
+                                            double gravitationalParameter)
+    {
+        OrbitalElements elements = {0, 0, 0, 0, 0, 0};
+
+        double r[3], v[3];
+        toEcliptic(relativePosition, r);
+        toEcliptic(relativeVelocity, v);
+
+        double mu = gravitationalParameter;
+        double distance = sqrt(dot(r, r));
+        double speedSquared = dot(v, v);
+
+        if ((distance <= 0) || (mu <= 0))
+        {
+            return elements;
+        }
+
+        // Specific angular momentum h = r x v and ascending node vector n = k x h
+        double h[3] = {r[1] * v[2] - r[2] * v[1], r[2] * v[0] - r[0] * v[2], r[0] * v[1] - r[1] * v[0]};
+        double n[3] = {-h[1], h[0], 0};
+        double hLength = sqrt(dot(h, h));
+        double nLength = sqrt(dot(n, n));
+
+        // Eccentricity vector e = ((v^2 - mu / r) r - (r . v) v) / mu
+        double radialVelocity = dot(r, v);
+        double e[3];
+        for (int k = 0; k < 3; k++)
+        {
+            e[k] = ((speedSquared - mu / distance) * r[k] - radialVelocity * v[k]) / mu;
+        }
+
+        elements.eccentricity = sqrt(dot(e, e));
+
+        // Vis-viva: a = -mu / (2 * energy)
+        double energy = speedSquared / 2 - mu / distance;
+        elements.semiMajorAxis = (fabs(energy) > 0) ? -mu / (2 * energy) : INFINITY;
+
+        if (hLength > 0)
+        {
+            elements.inclination = acos(fmax(-1.0, fmin(1.0, h[2] / hLength)));
+        }
+
+        bool isEquatorial = nLength <= ORBITAL_ELEMENTS_EPSILON * hLength;
+        bool isCircular = elements.eccentricity <= ORBITAL_ELEMENTS_EPSILON;
+
+        if (!isEquatorial)
+        {
+            elements.ascendingNode = atan2(n[1], n[0]);
+            if (elements.ascendingNode < 0)
+            {
+                elements.ascendingNode += 2 * M_PI;
+            }
+        }
+
+        // Argument of periapsis, measured from the node (or the x axis for equatorial orbits)
+        if (!isCircular)
+        {
+            if (!isEquatorial)
+            {
+                elements.argumentOfPeriapsis = angleBetween(n, e);
+                if (e[2] < 0)
+                {
+                    elements.argumentOfPeriapsis = 2 * M_PI - elements.argumentOfPeriapsis;
+                }
+            }
+
+            else
+            {
+                elements.argumentOfPeriapsis = atan2(e[1], e[0]);
+                if (h[2] < 0)
+                {
+                    elements.argumentOfPeriapsis = -elements.argumentOfPeriapsis;
+                }
+                if (elements.argumentOfPeriapsis < 0)
+                {
+                    elements.argumentOfPeriapsis += 2 * M_PI;
+                }
+            }
+
+            elements.trueAnomaly = angleBetween(e, r);
+            if (radialVelocity < 0)
+            {
+                elements.trueAnomaly = 2 * M_PI - elements.trueAnomaly;
+            }
+        }
+
+        // Circular orbits: the true anomaly is the argument of latitude
+        else
+        {
+            double reference[3] = {1, 0, 0};
+            double *origin = isEquatorial ? reference : n;
+
+            elements.trueAnomaly = angleBetween(origin, r);
+            if ((isEquatorial ? r[1] * h[2] : r[2]) < 0)
+            {
+                elements.trueAnomaly = 2 * M_PI - elements.trueAnomaly;
+            }
+        }
+
+        return elements;
+    }
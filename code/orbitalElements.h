@@ -0,0 +1,44 @@
+/* *****************************************************************
+    * FILE INFORMATION *
+   ***************************************************************** */
+
+/// @brief Keplerian orbital elements from state vectors
+/// @author Marc S. Ressl, Ian A. Dib, Luciano S. Cordero
+/// @copyright Copyright (c) 2022-2023
+
+
+/* *****************************************************************
+    * HEADER CONFIGURATION *
+   ***************************************************************** */
+
+    #ifndef ORBITALELEMENTS_H
+    #define ORBITALELEMENTS_H
+
+
+    //* NECESSARY LIBRARIES
+
+    #include <raylib.h>
+
+
+    //* CONSTANTS & STRUCTURES
+
+    /// @brief Keplerian orbital elements, referred to the ecliptic. Simulation vectors are
+            // ecliptic J2000 with the y and z axes swapped (y is the ecliptic pole)
+    struct OrbitalElements
+    {
+        double semiMajorAxis;           // [m], negative for hyperbolic orbits
+        double eccentricity;
+        double inclination;             // [rad]
+        double ascendingNode;           // Longitude of the ascending node [rad]
+        double argumentOfPeriapsis;     // [rad]
+        double trueAnomaly;             // [rad]
+    };
+
+
+    //* PUBLIC FUNCTIONS PROTOTYPES
+
+    OrbitalElements calculateOrbitalElements(Vector3 relativePosition, Vector3 relativeVelocity,
+                                            double gravitationalParameter);
+
+
+    #endif // ORBITALELEMENTS_H
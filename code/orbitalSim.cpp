@@ -13,14 +13,19 @@
 
     //* NECESSARY LIBRARIES
 
+    #include <stdio.h>
     #include <stdlib.h>
+    #include <string.h>
     #include <math.h>
+    #include <atomic>
+    #include <thread>
    
    
     //* NECESSARY HEADERS
 
-    #include "OrbitalSim.h"
+    #include "orbitalSim.h"
     #include "ephemerides.h"
+    #include "metrics.h"
 
     
     //* CONSTANTS
@@ -30,9 +35,32 @@
     // Enables M_PI #define in Windows
     #define _USE_MATH_DEFINES
 
-    #define GRAVITATIONAL_CONSTANT (6.6743E-11L)
     #define ASTEROIDS_MEAN_RADIUS 4E11F
 
+    // Nested substeps of a moon system are capped, so a moon thrown at its planet cannot stall
+    // the step (the watchdog catches the blow-up instead)
+    #define MOON_MAX_SUBSTEPS 4096
+
+
+    //* STRUCTURES
+
+    /// @brief Counter-based random stream of an asteroid
+    struct AsteroidRandom
+    {
+        uint64_t key;
+        uint64_t counter;
+    };
+
+    struct AsteroidGenerator
+    {
+        std::thread thread;
+        std::atomic<int> generatedCount;        // Asteroids [0, generatedCount) are ready
+        std::atomic<bool> isStopping;
+        int groupEnds[ASTEROID_GROUPNUM];       // End of every group once fully generated
+        int groupCounts[ASTEROID_GROUPNUM];     // Size of every group once fully generated
+        float centerMass;                       // [kg]
+    };
+
 
 /* *****************************************************************
     * LOGIC MODULES *
@@ -40,67 +68,103 @@
 
     //* ASTEROID CONFIGURATION
 
-    /// @brief Gets a uniform random value in a range
+    /// @brief SplitMix64 finalizer: a bijective mix of a 64-bit counter
+    /// @cite https://prng.di.unimi.it/splitmix64.c
+    uint64_t mixRandomBits(uint64_t x)
+    {
+        x += 0x9E3779B97F4A7C15ULL;
+        x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+        return x ^ (x >> 31);
+    }
+
+    /// @brief Gets a uniform random value in a range, never at its ends
+    /// @param random Random stream
     /// @param min Minimum value
     /// @param max Maximum value
     /// @return The random value
-    float getRandomFloat(float min, float max)
+    float getRandomFloat(AsteroidRandom *random, float min, float max)
     {
-        return min + (max - min) * rand() / (float)RAND_MAX;
+        uint64_t bits = mixRandomBits(random->key + 0x9E3779B97F4A7C15ULL * random->counter++);
+        float x = ((bits >> 40) + 0.5F) * (1.0F / 16777216.0F);
+
+        return min + (max - min) * x;
+    }
+
+    /// @brief Configures the asteroid groups: 70% of the asteroids between Mars and Jupiter,
+            // 20% around Jupiter's orbit and the remaining 10% in any region
+    /// @param sim The orbital simulation
+    void configureAsteroidGroups(OrbitalSim *sim)
+    {
+        const char *names[ASTEROID_GROUPNUM] = {"Main belt asteroid", "Jupiter asteroid", "Asteroid"};
+        Color colors[ASTEROID_GROUPNUM] = {GRAY, DARKGRAY, LIGHTGRAY};
+        int counts[ASTEROID_GROUPNUM] = {sim->asteroidCapacity * 7 / 10, sim->asteroidCapacity * 2 / 10, 0};
+        counts[ASTEROID_GROUPNUM - 1] = sim->asteroidCapacity - counts[0] - counts[1];
+
+        int startIndex = 0;
+
+        for (int i = 0; i < ASTEROID_GROUPNUM; i++)
+        {
+            AsteroidGroup *group = &sim->asteroidGroups[i];
+            group->name = names[i];
+            group->mass = 1E12F;
+            group->radius = 2E3F;
+            group->color = colors[i];
+            group->startIndex = startIndex;
+            group->count = counts[i];
+            startIndex += counts[i];
+        }
     }
 
     /// @brief Configures an asteroid
-    /// @param body An orbital body
+    /// @param asteroid An asteroid
+    /// @param index Index of the asteroid, which keys its random stream
+    /// @param groupIndex The asteroid group (region of the belt) the asteroid belongs to
     /// @param centerMass The mass of the most massive object in the star system
     /// @cite https://academia-lab.com/enciclopedia/cinturon-de-asteroides/
-    void configureAsteroid(OrbitalBody *body, float centerMass) 
+    void configureAsteroid(Asteroid *asteroid, int index, int groupIndex, float centerMass)
     {
+        AsteroidRandom stream = {mixRandomBits(ASTEROID_SEED ^ mixRandomBits((uint64_t)index)), 0};
+        AsteroidRandom *random = &stream;
+
         // Logit distribution
-        float x = getRandomFloat(0, 1);
+        float x = getRandomFloat(random, 0, 1);
         float l = logf(x) - logf(1 - x) + 1;
 
-        // Generate a random number to determine the region of the asteroid
-        float regionSelector = getRandomFloat(0, 1);
-
         // Define radius based on region
         float r;
 
-        // Supposing 70% of asteroids are between Mars and Jupiter
-        if (regionSelector < 0.7)
+        // Asteroids between Mars and Jupiter
+        if (groupIndex == 0)
         {
             // Radius of (Distance to Mars; Distance to Jupiter)
-            r = getRandomFloat(2.28E11F, 7.79E11F);
-            body->color = GRAY;
+            r = getRandomFloat(random, 2.28E11F, 7.79E11F);
         }
 
-        // Supposing 20% of asteroids are around Jupiter
-        else if (regionSelector >= 0.7 && regionSelector < 0.9)
+        // Asteroids around Jupiter
+        else if (groupIndex == 1)
         {
             // Radius of ±20% from Jupiter's orbit
             float jupiterDistance = 7.79E11F;        
-            r = jupiterDistance * getRandomFloat(0.8F, 1.2F);
-            body->color = DARKGRAY;
+            r = jupiterDistance * getRandomFloat(random, 0.8F, 1.2F);
         }
 
-        // Spawining the remaining 10% of asteroids in any region
+        // Asteroids in any region
         else
         {
             // Original logit distribution for radius
             r = ASTEROIDS_MEAN_RADIUS * sqrtf(fabsf(l));
-            body->color = LIGHTGRAY;
         }
 
         /// @cite https://mathworld.wolfram.com/DiskPointPicking.html
-        float phi = getRandomFloat(0, 2.0F * (float)M_PI);
+        float phi = getRandomFloat(random, 0, 2.0F * (float)M_PI);
 
         /// @cite https://en.wikipedia.org/wiki/Circular_orbit#Velocity
-        float v = sqrtf(GRAVITATIONAL_CONSTANT * centerMass / r) * getRandomFloat(0.6F, 1.2F);
-        float vy = getRandomFloat(-1E2F, 1E2F);
+        float v = sqrtf(GRAVITATIONAL_CONSTANT * centerMass / r) * getRandomFloat(random, 0.6F, 1.2F);
+        float vy = getRandomFloat(random, -1E2F, 1E2F);
 
-        body->mass = 1E12F;
-        body->radius = 2E3F;
-        body->position = {r * cosf(phi), vy, r * sinf(phi)};
-        body->velocity = {-v * sinf(phi), 0, v * cosf(phi)};
+        asteroid->position = {r * cosf(phi), vy, r * sinf(phi)};
+        asteroid->velocity = {-v * sinf(phi), 0, v * cosf(phi)};
     }
 
 
@@ -139,11 +203,34 @@
     }
 
 
+    /// @brief Calculates the gravitational acceleration a body suffers due to another body
+    /// @param position Position of the attracted body
+    /// @param targetPosition Position of the attracting body
+    /// @param targetMass Mass of the attracting body
+    /// @return Acceleration vector
+    Vector3 calculateGravitationalAcceleration(Vector3 position, Vector3 targetPosition, float targetMass)
+    {
+        Vector3 direction = Vector3Subtract(targetPosition, position);
+        float distance = Vector3Length(direction);
+
+        // Same singularity guard as calculateGravitationalForce
+        if (distance < 1.0f)
+        {
+            return {0, 0, 0};
+        }
+
+        // a = F / m1 = G * m2 / r^2, so the attracted body's mass cancels out
+        float accelerationMagnitude = GRAVITATIONAL_CONSTANT * targetMass / (distance * distance);
+
+        return Vector3Scale(direction, accelerationMagnitude / distance);
+    }
+
+
     /// @brief Calculates the acceleration of a group of bodies due to the gravitational force from another group
     /// @param sim The orbital simulation
-    /// @param accelerations Array to store the resulting accelerations for each body
-    /// @param sourceStartIndex Starting index of the group of bodies whose accelerations will be calculated
-    /// @param sourceEndIndex Ending index (exclusive) of the source bodies group
+    /// @param accelerations Array to store the resulting accelerations, indexed from startIndex
+    /// @param startIndex Starting index of the group of bodies whose accelerations will be calculated
+    /// @param endIndex Ending index (exclusive) of the group of bodies whose accelerations will be calculated
     /// @param targetStartIndex Starting index of the group of bodies that influence the source bodies' accelerations
     /// @param targetEndIndex Ending index (exclusive) of the target bodies group
     void calculateAccelerations(OrbitalSim* sim, Vector3* accelerations, int startIndex, int endIndex, 
@@ -159,7 +246,7 @@
                                                             sim->bodies[j].mass);    
 
                 // Calculate accelerations using Newton's second law, a = F / m
-                accelerations[i] = Vector3Add(accelerations[i],
+                accelerations[i - startIndex] = Vector3Add(accelerations[i - startIndex],
                                     Vector3Scale(force, 1.0f / sim->bodies[i].mass));
             }
         }
@@ -167,13 +254,756 @@
         return;
     }
 
+
+    /// @brief Flags infinities and NaNs (all exponent bits set). Works on the bit pattern, so
+            // it is branch-free and still correct under -ffast-math
+    /// @param value A value
+    /// @return 1 if the value is not finite, 0 otherwise
+    inline uint32_t isNonFinite(float value)
+    {
+        uint32_t bits;
+        memcpy(&bits, &value, sizeof(bits));
+
+        return (bits & 0x7F800000U) == 0x7F800000U;
+    }
+
+
+    /// @brief Flags a vector with any non-finite component
+    /// @param vector A vector
+    /// @return 1 if any component is not finite, 0 otherwise
+    inline uint32_t isNonFinite(Vector3 vector)
+    {
+        return isNonFinite(vector.x) | isNonFinite(vector.y) | isNonFinite(vector.z);
+    }
+
+
+    /// @brief Advances a group of asteroids one timestep, drift-kick-drift, with the significant
+            // bodies at t(n+1/2). Asteroids are test particles (they do not attract other bodies), so
+            // each acceleration is kicked into the asteroid right after being computed and no
+            // intermediate accelerations array is written and read back
+    /// @param sim The orbital simulation
+    /// @param startIndex Starting index of the group of asteroids
+    /// @param endIndex Ending index (exclusive) of the group of asteroids
+    /// @param timeStep Integration step [s]
+    /// @return Whether every updated asteroid is finite (checked while still in registers)
+    bool updateTestParticles(OrbitalSim *sim, int startIndex, int endIndex, float timeStep)
+    {
+        float halfStep = 0.5F * timeStep;
+        uint32_t nonFinite = 0;
+
+        for (int i = startIndex; i < endIndex; i++)
+        {
+            Asteroid *asteroid = &sim->asteroids[i];
+            Vector3 acceleration = {0, 0, 0};
+
+            // x(n+1/2) = x(n) + v(n) * dt/2
+            Vector3 position = Vector3Add(asteroid->position, Vector3Scale(asteroid->velocity, halfStep));
+
+            // Moons are left out: they are a small part of their planet's mass, and would need
+            // the nested substeps to be followed
+            for (int j = sim->moonCount; j < sim->bodyCount; j++)
+            {
+                acceleration = Vector3Add(acceleration,
+                                calculateGravitationalAcceleration(position,
+                                                                    sim->bodies[j].position,
+                                                                    sim->bodies[j].mass));
+            }
+
+            // v(n+1) = v(n) + a(n+1/2) * dt
+            Vector3 velocity = Vector3Add(asteroid->velocity, Vector3Scale(acceleration, timeStep));
+
+            // x(n+1) = x(n+1/2) + v(n+1) * dt/2
+            position = Vector3Add(position, Vector3Scale(velocity, halfStep));
+            asteroid->velocity = velocity;
+            asteroid->position = position;
+
+            // A non-finite velocity always reaches the position, so checking it is enough
+            nonFinite |= isNonFinite(position);
+        }
+
+        return !nonFinite;
+    }
+
+    
+    /// @brief Advances a group of asteroids one timestep as updateTestParticles, applying one body
+            // at a time to a tile of asteroids. The body's position and mass stay in registers while the inner loop runs
+            // over independent asteroids, which the compiler can vectorize
+    /// @param sim The orbital simulation
+    /// @param startIndex Starting index of the group of asteroids
+    /// @param endIndex Ending index (exclusive) of the group of asteroids
+    /// @param timeStep Integration step [s]
+    /// @param tileSize Asteroids per tile, at most ASTEROID_MAX_TILE_SIZE
+    /// @return Whether every updated asteroid is finite
+    bool updateTestParticlesTiled(OrbitalSim *sim, int startIndex, int endIndex, float timeStep, int tileSize)
+    {
+        Vector3 accelerations[ASTEROID_MAX_TILE_SIZE];
+        float halfStep = 0.5F * timeStep;
+        uint32_t nonFinite = 0;
+
+        for (int tileStart = startIndex; tileStart < endIndex; tileStart += tileSize)
+        {
+            int tileEnd = (tileStart + tileSize < endIndex) ? tileStart + tileSize : endIndex;
+            Asteroid *tile = &sim->asteroids[tileStart];
+            int count = tileEnd - tileStart;
+
+            for (int i = 0; i < count; i++)
+            {
+                // x(n+1/2) = x(n) + v(n) * dt/2
+                tile[i].position = Vector3Add(tile[i].position, Vector3Scale(tile[i].velocity, halfStep));
+                accelerations[i] = {0, 0, 0};
+            }
+
+            for (int j = sim->moonCount; j < sim->bodyCount; j++)
+            {
+                Vector3 bodyPosition = sim->bodies[j].position;
+                float bodyMass = sim->bodies[j].mass;
+
+                for (int i = 0; i < count; i++)
+                {
+                    accelerations[i] = Vector3Add(accelerations[i],
+                                        calculateGravitationalAcceleration(tile[i].position, bodyPosition, bodyMass));
+                }
+            }
+
+            for (int i = 0; i < count; i++)
+            {
+                // v(n+1) = v(n) + a(n+1/2) * dt
+                Vector3 velocity = Vector3Add(tile[i].velocity, Vector3Scale(accelerations[i], timeStep));
+
+                // x(n+1) = x(n+1/2) + v(n+1) * dt/2
+                Vector3 position = Vector3Add(tile[i].position, Vector3Scale(velocity, halfStep));
+                tile[i].velocity = velocity;
+                tile[i].position = position;
+
+                nonFinite |= isNonFinite(position);
+            }
+        }
+
+        return !nonFinite;
+    }
+
+
+    /// @brief Advances the running sums of an asteroid's chaos indicators after a step, and
+            // rescales its tangent when it grows too long for a float
+    /// @param tangent The asteroid's tangent, already advanced
+    /// @param timeStep Integration step [s]
+    void updateChaosIndicators(AsteroidTangent *tangent, float timeStep)
+    {
+        // d ln|dx| / dt, the rate the deviation grows at. Only the position deviation is
+        // measured: meters and meters per second cannot be added into one length
+        double lengthSqr = Vector3LengthSqr(tangent->position);
+        double growthRate = Vector3DotProduct(tangent->position, tangent->velocity) / lengthSqr;
+
+        tangent->time += timeStep;
+        tangent->megnoSum += 2.0 * growthRate * tangent->time * timeStep;
+        tangent->megnoMeanSum += tangent->megnoSum / tangent->time * timeStep;
+
+        // The indicators only depend on the direction of the tangent, so it can be rescaled
+        if (lengthSqr > CHAOS_RENORMALIZATION)
+        {
+            float scale = 1.0F / sqrtf((float)lengthSqr);
+            tangent->position = Vector3Scale(tangent->position, scale);
+            tangent->velocity = Vector3Scale(tangent->velocity, scale);
+            tangent->logScale += 0.5 * log(lengthSqr);
+        }
+    }
+
+
+    /// @brief Advances a group of asteroids and their tangents one timestep. The variational
+            // equations need the same direction and distance to every body as the acceleration,
+            // so they are computed in the same sweep. Asteroids end up as in updateTestParticles
+    /// @param sim The orbital simulation
+    /// @param startIndex Starting index of the group of asteroids
+    /// @param endIndex Ending index (exclusive) of the group of asteroids
+    /// @param timeStep Integration step [s]
+    /// @return Whether every updated asteroid is finite
+    bool updateTestParticlesVariational(OrbitalSim *sim, int startIndex, int endIndex, float timeStep)
+    {
+        float halfStep = 0.5F * timeStep;
+        uint32_t nonFinite = 0;
+
+        for (int i = startIndex; i < endIndex; i++)
+        {
+            Asteroid *asteroid = &sim->asteroids[i];
+            AsteroidTangent *tangent = &sim->tangents[i];
+
+            // x(n+1/2) = x(n) + v(n) * dt/2, and the same half drift for the tangent
+            Vector3 position = Vector3Add(asteroid->position, Vector3Scale(asteroid->velocity, halfStep));
+            Vector3 deltaPosition = Vector3Add(tangent->position, Vector3Scale(tangent->velocity, halfStep));
+            Vector3 acceleration = {0, 0, 0};
+            Vector3 deltaAcceleration = {0, 0, 0};
+
+            for (int j = sim->moonCount; j < sim->bodyCount; j++)
+            {
+                Vector3 direction = Vector3Subtract(sim->bodies[j].position, position);
+                float distance = Vector3Length(direction);
+
+                // Same singularity guard as calculateGravitationalForce
+                if (distance < 1.0f)
+                {
+                    continue;
+                }
+
+                // Same operations as calculateGravitationalAcceleration
+                float accelerationMagnitude = GRAVITATIONAL_CONSTANT * sim->bodies[j].mass / (distance * distance);
+                float inverseCube = accelerationMagnitude / distance;
+                acceleration = Vector3Add(acceleration, Vector3Scale(direction, inverseCube));
+
+                // Jacobian of the acceleration times the deviation: G * m / r^3 * (3 * d * (d . dx) / r^2 - dx)
+                float projection = 3.0F * Vector3DotProduct(direction, deltaPosition) / (distance * distance);
+                deltaAcceleration = Vector3Add(deltaAcceleration,
+                                    Vector3Scale(Vector3Subtract(Vector3Scale(direction, projection), deltaPosition),
+                                                inverseCube));
+            }
+
+            // v(n+1) = v(n) + a(n+1/2) * dt
+            Vector3 velocity = Vector3Add(asteroid->velocity, Vector3Scale(acceleration, timeStep));
+
+            // x(n+1) = x(n+1/2) + v(n+1) * dt/2
+            position = Vector3Add(position, Vector3Scale(velocity, halfStep));
+            asteroid->velocity = velocity;
+            asteroid->position = position;
+
+            // The tangent takes the same kick and drift
+            tangent->velocity = Vector3Add(tangent->velocity, Vector3Scale(deltaAcceleration, timeStep));
+            tangent->position = Vector3Add(deltaPosition, Vector3Scale(tangent->velocity, halfStep));
+            updateChaosIndicators(tangent, timeStep);
+
+            nonFinite |= isNonFinite(position);
+        }
+
+        return !nonFinite;
+    }
+
+
+    /// @brief Gets the chaos indicators of an asteroid
+    /// @param sim The orbital simulation, with CHAOS_INDICATORS enabled
+    /// @param index Index of the asteroid
+    /// @return Its indicators, NaN if they are not computed or the asteroid has not moved yet
+    ChaosIndicators getChaosIndicators(OrbitalSim *sim, int index)
+    {
+        if (!sim->tangents || (sim->tangents[index].time <= 0))
+        {
+            return {NAN, NAN};
+        }
+
+        AsteroidTangent *tangent = &sim->tangents[index];
+        double logLength = tangent->logScale + 0.5 * log(Vector3LengthSqr(tangent->position));
+
+        return {(float)(tangent->megnoMeanSum / tangent->time), (float)(logLength / tangent->time)};
+    }
+
+
+    /// @brief Arguments of the parallel asteroid step
+    struct AsteroidStepContext
+    {
+        OrbitalSim *sim;
+        float timeStep;
+        std::atomic<uint32_t> nonFinite;
+    };
+
+
+    /// @brief Worker task: advances one chunk of asteroids with the tuned kernel
+    /// @param context An AsteroidStepContext
+    /// @param startIndex Starting index of the chunk
+    /// @param endIndex Ending index (exclusive) of the chunk
+    void updateAsteroidChunk(void *context, int startIndex, int endIndex)
+    {
+        AsteroidStepContext *step = (AsteroidStepContext *)context;
+        OrbitalSim *sim = step->sim;
+        bool isFinite;
+
+        // The variational equations are only fused into the per-asteroid kernel
+        if (sim->tangents)
+        {
+            isFinite = updateTestParticlesVariational(sim, startIndex, endIndex, step->timeStep);
+        }
+
+        else if (sim->tuning.kernel == ASTEROID_KERNEL_TILED)
+        {
+            isFinite = updateTestParticlesTiled(sim, startIndex, endIndex, step->timeStep, sim->tuning.tileSize);
+        }
+
+        else
+        {
+            isFinite = updateTestParticles(sim, startIndex, endIndex, step->timeStep);
+        }
+
+        if (!isFinite)
+        {
+            step->nonFinite.store(1, std::memory_order_relaxed);
+        }
+    }
+
+
+    /// @brief Advances every asteroid one timestep, with the kernel, threads and chunks set in sim->tuning
+    /// @param sim The orbital simulation
+    /// @param timeStep Integration step [s]
+    /// @return Whether every updated asteroid is finite
+    bool updateAsteroids(OrbitalSim *sim, float timeStep)
+    {
+        AsteroidStepContext step;
+        step.sim = sim;
+        step.timeStep = timeStep;
+        step.nonFinite.store(0);
+
+        // Chunk costs are not uniform (close-encounter branches, cores shared with the renderer
+        // or other processes), so the split follows the costs measured on the previous step
+        runWorkerPool(sim->workers, sim->tuning.threadCount, sim->asteroidCount, sim->tuning.chunkSize,
+                        updateAsteroidChunk, &step, sim->asteroidSchedule);
+        if (sim->hasMetrics)
+        {
+            metrics.loadImbalance.store(getWorkerScheduleImbalance(sim->asteroidSchedule), std::memory_order_relaxed);
+        }
+
+        return !step.nonFinite.load();
+    }
+
     
+    /// @brief Calculates the total energy of the significant bodies (asteroids are test
+            // particles and do not take part in the system's energy)
+    /// @param sim The orbital simulation
+    /// @return Kinetic plus potential energy [J]
+    double calculateSignificantEnergy(OrbitalSim *sim)
+    {
+        double energy = 0;
+
+        for (int i = 0; i < sim->bodyCount; i++)
+        {
+            OrbitalBody *body = &sim->bodies[i];
+            energy += 0.5 * body->mass * Vector3LengthSqr(body->velocity);
+
+            for (int j = i + 1; j < sim->bodyCount; j++)
+            {
+                double distance = Vector3Distance(body->position, sim->bodies[j].position);
+
+                if (distance >= 1.0)
+                {
+                    energy -= GRAVITATIONAL_CONSTANT * body->mass * sim->bodies[j].mass / distance;
+                }
+            }
+        }
+
+        return energy;
+    }
+
+
+    //* MOON SYSTEMS
+
+    /// @brief Calculates the accelerations of the moons of a planet in the planet's frame: the
+            // planet's pull, the pull of its other moons and the tides of the heliocentric bodies
+            // (their pull on the moon minus their pull on the planet, which the frame follows)
+    /// @param sim The orbital simulation
+    /// @param startIndex First moon of the planet
+    /// @param endIndex Ending moon (exclusive) of the planet
+    /// @param tidalPositions Heliocentric body positions relative to the planet, from moonCount on [m]
+    /// @param tidalAccelerations Their pull on the planet, from moonCount on [m/s^2]
+    /// @param accelerations Array to store the resulting accelerations, indexed from startIndex
+    void calculateMoonAccelerations(OrbitalSim *sim, int startIndex, int endIndex,
+                                    const Vector3 *tidalPositions, const Vector3 *tidalAccelerations,
+                                    Vector3 *accelerations)
+    {
+        int planetIndex = sim->moons[startIndex].planetIndex;
+        float planetMass = sim->bodies[planetIndex].mass;
+        Vector3 origin = {0, 0, 0};
+
+        for (int i = startIndex; i < endIndex; i++)
+        {
+            Vector3 position = sim->moons[i].position;
+
+            // Two-body problem reduced to one: the planet also moves towards the moon
+            Vector3 acceleration = calculateGravitationalAcceleration(position, origin,
+                                                                        planetMass + sim->bodies[i].mass);
+
+            for (int j = startIndex; j < endIndex; j++)
+            {
+                if (j == i)
+                {
+                    continue;
+                }
+
+                // The other moon pulls on this one, and on the planet as well
+                Vector3 moonPosition = sim->moons[j].position;
+                acceleration = Vector3Add(acceleration,
+                                calculateGravitationalAcceleration(position, moonPosition, sim->bodies[j].mass));
+                acceleration = Vector3Subtract(acceleration,
+                                calculateGravitationalAcceleration(origin, moonPosition, sim->bodies[j].mass));
+            }
+
+            for (int j = sim->moonCount; j < sim->bodyCount; j++)
+            {
+                if (j == planetIndex)
+                {
+                    continue;
+                }
+
+                acceleration = Vector3Add(acceleration,
+                                calculateGravitationalAcceleration(position, tidalPositions[j], sim->bodies[j].mass));
+                acceleration = Vector3Subtract(acceleration, tidalAccelerations[j]);
+            }
+
+            accelerations[i - startIndex] = acceleration;
+        }
+    }
+
+
+    /// @brief Integrates every moon system over one step of the simulation, in its planet's frame
+            // and with its own substeps: as many as the fastest moon needs for MOON_STEPS_PER_ORBIT
+            // per orbit, drift-kick-drift as the rest. The heliocentric bodies stay at t(n+1/2)
+            // meanwhile, as for every other force of the step. The planets get the mean pull of
+            // their moons over the step, and the other heliocentric bodies the mean pull of every
+            // moon, at the same positions as the moon's tides, so momentum is conserved
+    /// @param sim The orbital simulation
+    /// @param accelerations Accelerations of the significant bodies at t(n+1/2), indexed by body
+    /// @param timeStep Integration step [s]
+    /// @return Whether every moon is finite
+    bool updateMoons(OrbitalSim *sim, Vector3 *accelerations, float timeStep)
+    {
+        Vector3 *tidalPositions = sim->tidalPositions;
+        Vector3 *tidalAccelerations = sim->tidalAccelerations;
+        Vector3 *tidalReactions = sim->tidalReactions;
+        Vector3 *moonAccelerations = sim->moonAccelerations;
+        uint64_t interactions = 0;
+        uint32_t nonFinite = 0;
+        Vector3 origin = {0, 0, 0};
+
+        // Moons of the same planet are consecutive
+        int endIndex;
+        for (int startIndex = 0; startIndex < sim->moonCount; startIndex = endIndex)
+        {
+            int planetIndex = sim->moons[startIndex].planetIndex;
+            OrbitalBody *planet = &sim->bodies[planetIndex];
+            float shortestPeriod = INFINITY;
+
+            for (endIndex = startIndex; (endIndex < sim->moonCount) &&
+                                        (sim->moons[endIndex].planetIndex == planetIndex); endIndex++)
+            {
+                // Period of the circular orbit at the moon's current distance
+                float distance = Vector3Length(sim->moons[endIndex].position);
+                float period = (float)(2 * M_PI * sqrt(distance * distance * distance /
+                                        (GRAVITATIONAL_CONSTANT * (planet->mass + sim->bodies[endIndex].mass))));
+                shortestPeriod = fminf(shortestPeriod, period);
+            }
+
+            for (int j = sim->moonCount; j < sim->bodyCount; j++)
+            {
+                tidalPositions[j] = Vector3Subtract(sim->bodies[j].position, planet->position);
+                tidalAccelerations[j] = calculateGravitationalAcceleration(origin, tidalPositions[j],
+                                                                            sim->bodies[j].mass);
+                tidalReactions[j] = {0, 0, 0};
+            }
+
+            // Written so that a NaN period falls back to one substep
+            float substepCount = ceilf(timeStep * MOON_STEPS_PER_ORBIT / shortestPeriod);
+            int substeps = (substepCount >= 1) ?
+                            ((substepCount < MOON_MAX_SUBSTEPS) ? (int)substepCount : MOON_MAX_SUBSTEPS) : 1;
+            float substep = timeStep / substeps;
+            float halfSubstep = 0.5F * substep;
+            Vector3 planetAcceleration = {0, 0, 0};
+
+            for (int step = 0; step < substeps; step++)
+            {
+                for (int i = startIndex; i < endIndex; i++)
+                {
+                    // x(n+1/2) = x(n) + v(n) * dt/2
+                    OrbitalMoon *moon = &sim->moons[i];
+                    moon->position = Vector3Add(moon->position, Vector3Scale(moon->velocity, halfSubstep));
+                }
+
+                calculateMoonAccelerations(sim, startIndex, endIndex, tidalPositions, tidalAccelerations,
+                                            moonAccelerations);
+
+                for (int i = startIndex; i < endIndex; i++)
+                {
+                    OrbitalMoon *moon = &sim->moons[i];
+
+                    // The planet's and the other bodies' share of the pull, at the same positions
+                    planetAcceleration = Vector3Add(planetAcceleration,
+                                            calculateGravitationalAcceleration(origin, moon->position,
+                                                                                sim->bodies[i].mass));
+
+                    for (int j = sim->moonCount; j < sim->bodyCount; j++)
+                    {
+                        if (j != planetIndex)
+                        {
+                            tidalReactions[j] = Vector3Add(tidalReactions[j],
+                                                calculateGravitationalAcceleration(tidalPositions[j], moon->position,
+                                                                                    sim->bodies[i].mass));
+                        }
+                    }
+
+                    // v(n+1) = v(n) + a(n+1/2) * dt
+                    moon->velocity = Vector3Add(moon->velocity, Vector3Scale(moonAccelerations[i - startIndex], substep));
+
+                    // x(n+1) = x(n+1/2) + v(n+1) * dt/2
+                    moon->position = Vector3Add(moon->position, Vector3Scale(moon->velocity, halfSubstep));
+                }
+            }
+
+            for (int i = startIndex; i < endIndex; i++)
+            {
+                nonFinite |= isNonFinite(sim->moons[i].position);
+            }
+
+            accelerations[planetIndex] = Vector3Add(accelerations[planetIndex],
+                                                    Vector3Scale(planetAcceleration, 1.0F / substeps));
+
+            for (int j = sim->moonCount; j < sim->bodyCount; j++)
+            {
+                accelerations[j] = Vector3Add(accelerations[j], Vector3Scale(tidalReactions[j], 1.0F / substeps));
+            }
+
+            int moonCount = endIndex - startIndex;
+            interactions += (uint64_t)substeps * moonCount * (moonCount + 2 * (sim->bodyCount - sim->moonCount));
+        }
+
+        if (sim->hasMetrics)
+        {
+            metrics.interactions.fetch_add(interactions, std::memory_order_relaxed);
+        }
+
+        return !nonFinite;
+    }
+
+
+    /// @brief Derives the heliocentric state of every moon from its planet's
+    /// @param sim The orbital simulation
+    void placeMoons(OrbitalSim *sim)
+    {
+        for (int i = 0; i < sim->moonCount; i++)
+        {
+            OrbitalBody *planet = &sim->bodies[sim->moons[i].planetIndex];
+
+            sim->bodies[i].position = Vector3Add(planet->position, sim->moons[i].position);
+            sim->bodies[i].velocity = Vector3Add(planet->velocity, sim->moons[i].velocity);
+        }
+    }
+
+
+    //* INSTABILITY WATCHDOG
+
+    /// @brief Copies the simulation state into the checkpoint
+    /// @param sim The orbital simulation
+    /// @param energy Current energy of the significant bodies [J]
+    void saveOrbitalCheckpoint(OrbitalSim *sim, double energy)
+    {
+        OrbitalCheckpoint *checkpoint = &sim->checkpoint;
+
+        memcpy(checkpoint->bodies, sim->bodies, sim->bodyCount * sizeof(OrbitalBody));
+        memcpy(checkpoint->moons, sim->moons, sim->moonCount * sizeof(OrbitalMoon));
+        memcpy(checkpoint->asteroids, sim->asteroids, sim->asteroidCount * sizeof(Asteroid));
+        if (sim->tangents)
+        {
+            memcpy(checkpoint->tangents, sim->tangents, sim->asteroidCount * sizeof(AsteroidTangent));
+        }
+        checkpoint->time = sim->time;
+        checkpoint->energy = energy;
+        checkpoint->updateCount = 0;
+    }
+
+
+    /// @brief Rolls the simulation back to the checkpoint
+    /// @param sim The orbital simulation
+    void restoreOrbitalCheckpoint(OrbitalSim *sim)
+    {
+        OrbitalCheckpoint *checkpoint = &sim->checkpoint;
+
+        memcpy(sim->bodies, checkpoint->bodies, sim->bodyCount * sizeof(OrbitalBody));
+        memcpy(sim->moons, checkpoint->moons, sim->moonCount * sizeof(OrbitalMoon));
+        memcpy(sim->asteroids, checkpoint->asteroids, sim->asteroidCount * sizeof(Asteroid));
+        if (sim->tangents)
+        {
+            memcpy(sim->tangents, checkpoint->tangents, sim->asteroidCount * sizeof(AsteroidTangent));
+        }
+        sim->time = checkpoint->time;
+    }
+
+
+    /// @brief Checks a state for blow-ups: non-finite values or an energy jump since the checkpoint
+    /// @param sim The orbital simulation
+    /// @param isFinite Whether every integrated value was finite
+    /// @param energy Current energy of the significant bodies [J]
+    /// @return Whether the state can be trusted
+    bool isOrbitalSimHealthy(OrbitalSim *sim, bool isFinite, double energy)
+    {
+        double reference = sim->checkpoint.energy;
+
+        // Written so that a NaN energy fails the check
+        return isFinite &&
+            (fabs(energy - reference) <= WATCHDOG_ENERGY_TOLERANCE * fabs(reference));
+    }
+
+
+    //* ASTEROID GENERATION
+
+    /// @brief Seeds the tangent of a new asteroid: a unit deviation along its position. Any
+            // direction works, since the fastest growing one takes over after a few steps
+    /// @param tangent The tangent
+    /// @param asteroid The configured asteroid
+    void seedAsteroidTangent(AsteroidTangent *tangent, Asteroid *asteroid)
+    {
+        tangent->position = Vector3Normalize(asteroid->position);
+        tangent->velocity = {0, 0, 0};
+        tangent->time = 0;
+        tangent->logScale = 0;
+        tangent->megnoSum = 0;
+        tangent->megnoMeanSum = 0;
+    }
+
+
+    /// @brief Configures the asteroids in batches, publishing every batch once it is written.
+            // The simulation only reads asteroids below the published count, and this only writes
+            // asteroids above it, so no lock is needed
+    /// @param sim The orbital simulation
+    void runAsteroidGenerator(OrbitalSim *sim)
+    {
+        AsteroidGenerator *generator = sim->generator;
+        int groupIndex = 0;
+
+        for (int batchStart = 0;
+            (batchStart < sim->asteroidCapacity) && !generator->isStopping.load(std::memory_order_relaxed);
+            batchStart += ASTEROID_GENERATION_BATCH)
+        {
+            int batchEnd = (batchStart + ASTEROID_GENERATION_BATCH < sim->asteroidCapacity) ?
+                            batchStart + ASTEROID_GENERATION_BATCH : sim->asteroidCapacity;
+
+            for (int i = batchStart; i < batchEnd; i++)
+            {
+                while (i >= generator->groupEnds[groupIndex])
+                {
+                    groupIndex++;
+                }
+
+                configureAsteroid(&sim->asteroids[i], i, groupIndex, generator->centerMass);
+
+                if (sim->tangents)
+                {
+                    seedAsteroidTangent(&sim->tangents[i], &sim->asteroids[i]);
+                }
+            }
+
+            generator->generatedCount.store(batchEnd, std::memory_order_release);
+        }
+    }
+
+
+    /// @brief Sets how many asteroids take part. Each group takes part with the intersection of
+            // its range and the first asteroidCount asteroids
+    /// @param sim The orbital simulation
+    /// @param asteroidCount Asteroids taking part
+    void setActiveAsteroidCount(OrbitalSim *sim, int asteroidCount)
+    {
+        AsteroidGenerator *generator = sim->generator;
+        sim->asteroidCount = asteroidCount;
+
+        for (int i = 0; i < ASTEROID_GROUPNUM; i++)
+        {
+            AsteroidGroup *group = &sim->asteroidGroups[i];
+            int count = asteroidCount - group->startIndex;
+            group->count = (count < 0) ? 0 : ((count > generator->groupCounts[i]) ? generator->groupCounts[i] : count);
+
+            if (sim->hasMetrics && (i + 1 < METRICS_MAX_GROUPS))
+            {
+                metrics.bodiesByGroup[i + 1].store(group->count);
+            }
+        }
+
+        // A rollback must not cross an insertion: the new asteroids have no earlier state
+        saveOrbitalCheckpoint(sim, calculateSignificantEnergy(sim));
+    }
+
+
+    /// @brief Lets the generated asteroids join the simulation
+    /// @param sim The orbital simulation
+    void syncAsteroidGenerator(OrbitalSim *sim)
+    {
+        AsteroidGenerator *generator = sim->generator;
+        int generatedCount = generator->generatedCount.load(std::memory_order_acquire);
+
+        if (generatedCount == sim->asteroidCount)
+        {
+            return;
+        }
+
+        setActiveAsteroidCount(sim, generatedCount);
+
+        if ((generatedCount == sim->asteroidCapacity) && generator->thread.joinable())
+        {
+            generator->thread.join();
+        }
+    }
+
+
+    /// @brief Waits for the generator and lets every asteroid join without advancing the
+            // simulation, for tools that need the whole belt at the initial state
+    /// @param sim The orbital simulation
+    void finishAsteroidGeneration(OrbitalSim *sim)
+    {
+        if (sim->generator->thread.joinable())
+        {
+            sim->generator->thread.join();
+        }
+
+        syncAsteroidGenerator(sim);
+    }
+
+
+    /// @brief Replaces the generated asteroids with given states, for tools that integrate their
+            // own test particles. Generation stops, and the given asteroids take part from now on
+    /// @param sim The orbital simulation
+    /// @param asteroids Asteroid states
+    /// @param asteroidCount Number of asteroids, at most sim->asteroidCapacity
+    void setOrbitalSimAsteroids(OrbitalSim *sim, const Asteroid *asteroids, int asteroidCount)
+    {
+        AsteroidGenerator *generator = sim->generator;
+        generator->isStopping.store(true);
+        if (generator->thread.joinable())
+        {
+            generator->thread.join();
+        }
+
+        if (asteroidCount > sim->asteroidCapacity)
+        {
+            asteroidCount = sim->asteroidCapacity;
+        }
+
+        memcpy(sim->asteroids, asteroids, asteroidCount * sizeof(Asteroid));
+
+        for (int i = 0; sim->tangents && (i < asteroidCount); i++)
+        {
+            seedAsteroidTangent(&sim->tangents[i], &sim->asteroids[i]);
+        }
+
+        // Later syncs find nothing new
+        generator->generatedCount.store(asteroidCount);
+        setActiveAsteroidCount(sim, asteroidCount);
+    }
+
+
+    /// @brief Sets the state of a significant body, for tools that fit it. Its moons keep their
+            // state relative to it
+    /// @param sim The orbital simulation
+    /// @param index Index of the body, past the moons
+    /// @param position Heliocentric position [m]
+    /// @param velocity Heliocentric velocity [m/s]
+    void setOrbitalSimBody(OrbitalSim *sim, int index, Vector3 position, Vector3 velocity)
+    {
+        sim->bodies[index].position = position;
+        sim->bodies[index].velocity = velocity;
+        placeMoons(sim);
+
+        // A rollback must not undo it, nor take its energy change for a blow-up
+        saveOrbitalCheckpoint(sim, calculateSignificantEnergy(sim));
+    }
+
+
     //* ORBITAL SIMULATION MANAGEMENT
 
     /// @brief Constructs an orbital simulation
     /// @param timeStep Time step for integration
+    /// @param asteroidCount Number of asteroids to generate
     /// @return The orbital simulation
-    OrbitalSim* constructOrbitalSim(float timeStep)
+    OrbitalSim* constructOrbitalSim(float timeStep, int asteroidCount)
     {
         // Allocate memory for the simulation structure
         OrbitalSim* sim = new OrbitalSim;
@@ -181,52 +1011,50 @@
         // Initialize fields
         sim->timeStep = timeStep;
         sim->time = 0.0f;
+        sim->substeps = 1;
+
+        // Serial fused kernel until the autotuner picks something faster
+        sim->tuning.kernel = ASTEROID_KERNEL_FUSED;
+        sim->tuning.threadCount = 1;
+        sim->tuning.chunkSize = 4096;
+        sim->tuning.tileSize = 64;
+        sim->workers = constructWorkerPool(getHardwareThreadCount());
+        sim->asteroidSchedule = constructWorkerSchedule();
 
-        // Total number of bodies in the simulation
-        sim->bodyCount = SOLARSYSTEM_BODYNUM * SOLAR_SYSTEM + ALPHACENTAURISYSTEM_BODYNUM * ALPHA_CENTAURI 
-                        + NUM_ASTEROIDS + BLACKHOLE;
+        // Total number of significant bodies in the simulation, moons included
+        sim->moonCount = getEphemeridesMoonCount();
+        sim->bodyCount = getEphemeridesBodyCount() + BLACKHOLE + sim->moonCount;
 
         int totalBodyNum = sim->bodyCount - 1;
 
         // Allocate memory for the bodies
         sim->bodies = new OrbitalBody[sim->bodyCount];
 
-        // Copy solar system bodies from ephemerides
-        if (SOLAR_SYSTEM)
+        // Copy the bodies of every enabled scenario from the ephemerides catalog
+        for (int i = 0; i < getEphemeridesCount(ephemeridesScenarios); i++)
         {
-            for (int i = 0; i < SOLARSYSTEM_BODYNUM; i++)
+            const EphemeridesScenario *scenario = &ephemeridesScenarios[i];
+
+            for (int j = 0; scenario->isEnabled && (j < scenario->bodyCount); j++)
             {
-                sim->bodies[totalBodyNum].velocity = solarSystem[i].velocity;
-                sim->bodies[totalBodyNum].position = solarSystem[i].position;
-                sim->bodies[totalBodyNum].color = solarSystem[i].color;
+                const EphemeridesBody *body = &scenario->bodies[j];
+
+                sim->bodies[totalBodyNum].velocity = body->velocity;
+                sim->bodies[totalBodyNum].position = body->position;
+                sim->bodies[totalBodyNum].color = body->color;
 
-                if (MASIVE_JUPITER && (i == 5))
+                if (MASIVE_JUPITER && (body == &solarSystem[5]))
                 {
-                    sim->bodies[totalBodyNum].mass = ((solarSystem[i].mass) * 1000.0);
+                    sim->bodies[totalBodyNum].mass = ((body->mass) * 1000.0);
                 }
 
                 else
                 {
-                    sim->bodies[totalBodyNum].mass = solarSystem[i].mass;
+                    sim->bodies[totalBodyNum].mass = body->mass;
                 }
 
-                sim->bodies[totalBodyNum].radius = solarSystem[i].radius;
-                sim->bodies[totalBodyNum].name = solarSystem[i].name;
-                totalBodyNum--;
-            }
-        }
-
-        // Copy Alpha Centauri system bodies from ephemerides
-        if (ALPHA_CENTAURI)
-        {
-            for (int j = 0; j < ALPHACENTAURISYSTEM_BODYNUM; j++)
-            {
-                sim->bodies[totalBodyNum].velocity = alphaCentauriSystem[j].velocity;
-                sim->bodies[totalBodyNum].position = alphaCentauriSystem[j].position;
-                sim->bodies[totalBodyNum].color = alphaCentauriSystem[j].color;
-                sim->bodies[totalBodyNum].mass = alphaCentauriSystem[j].mass;
-                sim->bodies[totalBodyNum].radius = alphaCentauriSystem[j].radius;
-                sim->bodies[totalBodyNum].name = alphaCentauriSystem[j].name;
+                sim->bodies[totalBodyNum].radius = body->radius;
+                sim->bodies[totalBodyNum].name = body->name;
                 totalBodyNum--;
             }
         }
@@ -244,59 +1072,329 @@
             totalBodyNum--;
         }
 
+        // Moons take the first indices. Their planets are found by name, as they were just copied;
+        // a moon whose planet is missing is left out
+        sim->moons = new OrbitalMoon[sim->moonCount];
+        int moonCount = 0;
+
+        for (int i = 0; i < sim->moonCount; i++)
+        {
+            const EphemeridesMoon *moon = &planetaryMoons[i];
+            int planetIndex = -1;
+
+            for (int j = sim->moonCount; j < sim->bodyCount; j++)
+            {
+                if (strcmp(sim->bodies[j].name, moon->planet->name) == 0)
+                {
+                    planetIndex = j;
+                }
+            }
+
+            if (planetIndex < 0)
+            {
+                fprintf(stderr, "orbitalSim: %s left out, its planet %s is not simulated\n",
+                        moon->name, moon->planet->name);
+                continue;
+            }
+
+            sim->bodies[moonCount].name = moon->name;
+            sim->bodies[moonCount].mass = moon->mass;
+            sim->bodies[moonCount].radius = moon->radius;
+            sim->bodies[moonCount].color = moon->color;
+            sim->moons[moonCount].planetIndex = planetIndex;
+            sim->moons[moonCount].position = moon->position;
+            sim->moons[moonCount].velocity = moon->velocity;
+            moonCount++;
+        }
+
+        // Close the gap of the left out moons, before the other bodies
+        if (moonCount < sim->moonCount)
+        {
+            int gap = sim->moonCount - moonCount;
+            memmove(&sim->bodies[moonCount], &sim->bodies[sim->moonCount],
+                    (sim->bodyCount - sim->moonCount) * sizeof(OrbitalBody));
+
+            for (int i = 0; i < moonCount; i++)
+            {
+                sim->moons[i].planetIndex -= gap;
+            }
+
+            sim->bodyCount -= gap;
+            sim->moonCount = moonCount;
+        }
+
+        // Moon scratch buffers
+        sim->tidalPositions = new Vector3[sim->bodyCount];
+        sim->tidalAccelerations = new Vector3[sim->bodyCount];
+        sim->tidalReactions = new Vector3[sim->bodyCount];
+        sim->moonAccelerations = new Vector3[sim->moonCount];
+
+        placeMoons(sim);
+
         // Sun's mass
         float centerMass = solarSystem[0].mass;
 
-        // Asteroids setup
-        for (int i = 0; i < NUM_ASTEROIDS; i++)
+        // Asteroids setup. None take part until the generator publishes them
+        sim->asteroidCapacity = asteroidCount;
+        sim->asteroidCount = 0;
+        sim->asteroids = new Asteroid[sim->asteroidCapacity];
+        sim->tangents = CHAOS_INDICATORS ? new AsteroidTangent[sim->asteroidCapacity] : NULL;
+        configureAsteroidGroups(sim);
+
+        sim->generator = new AsteroidGenerator;
+        sim->generator->generatedCount.store(0);
+        sim->generator->isStopping.store(false);
+        sim->generator->centerMass = centerMass;
+
+        for (int i = 0; i < ASTEROID_GROUPNUM; i++)
         {
-            OrbitalBody* body = &sim->bodies[totalBodyNum];
-            body->name = "Asteroid";
-            configureAsteroid(body, centerMass);
-            totalBodyNum--;
+            sim->generator->groupCounts[i] = sim->asteroidGroups[i].count;
+            sim->generator->groupEnds[i] = sim->asteroidGroups[i].startIndex + sim->asteroidGroups[i].count;
+            sim->asteroidGroups[i].count = 0;
         }
 
-            return sim;
+        // Only registerOrbitalSimMetrics publishes to the metrics endpoint
+        sim->hasMetrics = false;
+
+        // Watchdog checkpoint of the initial state
+        sim->checkpoint.bodies = new OrbitalBody[sim->bodyCount];
+        sim->checkpoint.moons = new OrbitalMoon[sim->moonCount];
+        sim->checkpoint.asteroids = new Asteroid[sim->asteroidCapacity];
+        sim->checkpoint.tangents = CHAOS_INDICATORS ? new AsteroidTangent[sim->asteroidCapacity] : NULL;
+        sim->checkpoint.healthyCount = 0;
+        sim->checkpoint.hasFailed = false;
+        saveOrbitalCheckpoint(sim, calculateSignificantEnergy(sim));
+
+        if (ASYNC_ASTEROID_GENERATION)
+        {
+            sim->generator->thread = std::thread(runAsteroidGenerator, sim);
         }
+
+        else
+        {
+            runAsteroidGenerator(sim);
+            syncAsteroidGenerator(sim);
+        }
+
+        return sim;
+    }
  
 
-    /// @brief Simulates a timestep
+    //* ORBITAL SIMULATION UPDATE
+
+    /// @brief Integrates one step of the whole simulation with a drift-kick-drift leapfrog: every
+            // body drifts half a step, takes the kick of the forces at t(n+1/2) and drifts the other
+            // half. Second order and symplectic with one force evaluation per step, so it stays
+            // accurate at the large steps of the interactive simulation
     /// @param sim The orbital simulation
-    void updateOrbitalSim(OrbitalSim *sim)
+    /// @param timeStep Integration step [s]
+    /// @return Whether every integrated value is finite
+    bool stepOrbitalSim(OrbitalSim *sim, float timeStep)
     {
-        // Temporary array to store accelerations
+        // Temporary array to store the accelerations of significant bodies
         Vector3 *accelerations = new Vector3[sim->bodyCount]();
+        float halfStep = 0.5F * timeStep;
+
+        // x(n+1/2) = x(n) + v(n) * dt/2
+        uint64_t phaseStart = getMetricsTime();
+        for (int i = sim->moonCount; i < sim->bodyCount; i++)
+        {
+            Vector3 positionChange = Vector3Scale(sim->bodies[i].velocity, halfStep);
+            sim->bodies[i].position = Vector3Add(sim->bodies[i].position, positionChange);
+        }
         
-        // Calculate accelerations due to the gravitational force between significant bodies
-        calculateAccelerations(sim, accelerations, 
-                                NUM_ASTEROIDS, sim->bodyCount, 
-                                NUM_ASTEROIDS, sim->bodyCount);
+        // Calculate accelerations due to the gravitational force between significant bodies.
+        // Moons are integrated apart, in their planet's frame, where they add their pull on it
+        calculateAccelerations(sim, accelerations + sim->moonCount, 
+                                sim->moonCount, sim->bodyCount, 
+                                sim->moonCount, sim->bodyCount);
+        bool areMoonsFinite = updateMoons(sim, accelerations, timeStep);
+        recordMetricsPhase(METRICS_PHASE_SIGNIFICANT_BODIES, phaseStart);
         
-        // Calculate accelerations due to the gravitational force between asteroids and significant bodies
-        calculateAccelerations(sim, accelerations, 
-                                0, NUM_ASTEROIDS - 1,
-                                NUM_ASTEROIDS, sim->bodyCount);
+        // Drift, kick and drift the asteroids in a single sweep.
+        // Must run before significant bodies move on, so every force uses positions at t(n+1/2)
+        phaseStart = getMetricsTime();
+        bool isFinite = updateAsteroids(sim, timeStep);
+        recordMetricsPhase(METRICS_PHASE_ASTEROIDS, phaseStart);
         
-        // Update velocities and positions using the corresponding current acceleration
-        for (int i = 0; i < sim->bodyCount; i++)
+        // Update velocities and positions of significant bodies using their current acceleration
+        phaseStart = getMetricsTime();
+        uint32_t nonFinite = 0;
+        for (int i = sim->moonCount; i < sim->bodyCount; i++)
         {
-            // Store the previous position before updating
-            sim->bodies[i].previousPosition = sim->bodies[i].position;
-            
-            // v(n+1) = v(n) + a(n) * dt
-            Vector3 velocityChange = Vector3Scale(accelerations[i], sim->timeStep);
+            // v(n+1) = v(n) + a(n+1/2) * dt
+            Vector3 velocityChange = Vector3Scale(accelerations[i], timeStep);
             sim->bodies[i].velocity = Vector3Add(sim->bodies[i].velocity, velocityChange);
             
-            // x(n+1) = x(n) + v(n+1) * dt
-            Vector3 positionChange = Vector3Scale(sim->bodies[i].velocity, sim->timeStep);
+            // x(n+1) = x(n+1/2) + v(n+1) * dt/2
+            Vector3 positionChange = Vector3Scale(sim->bodies[i].velocity, halfStep);
             sim->bodies[i].position = Vector3Add(sim->bodies[i].position, positionChange);
+
+            nonFinite |= isNonFinite(sim->bodies[i].position);
         }
+        placeMoons(sim);
+        recordMetricsPhase(METRICS_PHASE_INTEGRATION, phaseStart);
 
         // Clean up
         delete[] accelerations;
         
         // Update simulation time
-        sim->time += sim->timeStep;
+        sim->time += timeStep;
+
+        // Update metrics counters (updateMoons counts its own)
+        if (sim->hasMetrics)
+        {
+            uint64_t heliocentricCount = sim->bodyCount - sim->moonCount;
+            metrics.steps.fetch_add(1, std::memory_order_relaxed);
+            metrics.interactions.fetch_add(heliocentricCount * (heliocentricCount + sim->asteroidCount),
+                                            std::memory_order_relaxed);
+        }
+
+        return isFinite && areMoonsFinite && !nonFinite;
+    }
+
+
+    /// @brief Advances the simulation one timeStep, split into its current substeps
+    /// @param sim The orbital simulation
+    /// @return Whether every integrated value is finite
+    bool advanceOrbitalSim(OrbitalSim *sim)
+    {
+        float timeStep = sim->timeStep / sim->substeps;
+        bool isFinite = true;
+
+        // A blow-up the watchdog will roll back needs no more substeps. Otherwise the time
+        // must still reach the end of the step
+        bool canRollBack = WATCHDOG && !sim->checkpoint.hasFailed;
+
+        for (int i = 0; (i < sim->substeps) && (isFinite || !canRollBack); i++)
+        {
+            isFinite = stepOrbitalSim(sim, timeStep) && isFinite;
+        }
+
+        return isFinite;
+    }
+
+
+    /// @brief Simulates a timestep. With the watchdog enabled, a step that blows up is rolled
+            // back to the last checkpoint and replayed with half the step until it is healthy,
+            // replaying at most WATCHDOG_MAX_REPLAY_STEPS steps per update. At the substep limit
+            // the state is accepted, and a blow-up is reported once and no longer checked. The
+            // step is lengthened again after a healthy run
+    /// @param sim The orbital simulation
+    void updateOrbitalSim(OrbitalSim *sim)
+    {
+        syncAsteroidGenerator(sim);
+
+        bool isFinite = advanceOrbitalSim(sim);
+        double energy = calculateSignificantEnergy(sim);
+        OrbitalCheckpoint *checkpoint = &sim->checkpoint;
+
+        if (WATCHDOG && !checkpoint->hasFailed)
+        {
+            checkpoint->updateCount++;
+            int replaySteps = 0;
+
+            while (!isOrbitalSimHealthy(sim, isFinite, energy) && (sim->substeps < WATCHDOG_MAX_SUBSTEPS) &&
+                    (replaySteps < WATCHDOG_MAX_REPLAY_STEPS))
+            {
+                restoreOrbitalCheckpoint(sim);
+                sim->substeps *= 2;
+                checkpoint->healthyCount = 0;
+                if (sim->hasMetrics)
+                {
+                    metrics.rollbacks.fetch_add(1, std::memory_order_relaxed);
+                }
+
+                // Replay the updates since the checkpoint, stopping at the first unhealthy one.
+                // Past the replay budget the simulation stays behind, as after a slow frame
+                int replayCount = 0;
+                while ((replayCount < checkpoint->updateCount) && (replaySteps < WATCHDOG_MAX_REPLAY_STEPS))
+                {
+                    isFinite = advanceOrbitalSim(sim);
+                    energy = calculateSignificantEnergy(sim);
+                    replaySteps += sim->substeps;
+                    replayCount++;
+
+                    if (!isOrbitalSimHealthy(sim, isFinite, energy))
+                    {
+                        break;
+                    }
+                }
+
+                checkpoint->updateCount = replayCount;
+            }
+
+            if (!isOrbitalSimHealthy(sim, isFinite, energy) && (sim->substeps >= WATCHDOG_MAX_SUBSTEPS))
+            {
+                // Substep limit reached: the state is accepted instead of rolling back to the
+                // same checkpoint on every update from now on. A finite one is the new reference;
+                // after a blow-up the watchdog gives up, and says so
+                if (isFinite)
+                {
+                    saveOrbitalCheckpoint(sim, energy);
+                }
+
+                else
+                {
+                    fprintf(stderr, "orbitalSim: non-finite state at %d substeps (day %.1f), "
+                                    "the watchdog stops checking\n",
+                            sim->substeps, sim->time / SECONDS_PER_DAY);
+                    checkpoint->hasFailed = true;
+                    sim->substeps = 1;
+                }
+            }
+
+            // Otherwise, out of replay budget, the next update rolls back again
+            else if (isOrbitalSimHealthy(sim, isFinite, energy))
+            {
+                checkpoint->healthyCount++;
+
+                if ((checkpoint->healthyCount >= WATCHDOG_RELAX_INTERVAL) && (sim->substeps > 1))
+                {
+                    sim->substeps /= 2;
+                    checkpoint->healthyCount = 0;
+                }
+
+                if (checkpoint->updateCount >= WATCHDOG_CHECKPOINT_INTERVAL)
+                {
+                    saveOrbitalCheckpoint(sim, energy);
+                }
+            }
+        }
+
+        if (sim->hasMetrics)
+        {
+            metrics.substeps.store(sim->substeps, std::memory_order_relaxed);
+
+            double initialEnergy = metrics.initialEnergy.load(std::memory_order_relaxed);
+            if (initialEnergy != 0)
+            {
+                metrics.energyDrift.store(fabs((energy - initialEnergy) / initialEnergy),
+                                            std::memory_order_relaxed);
+            }
+        }
+    }
+
+
+    /// @brief Publishes a simulation on the metrics endpoint: bodies by group, reference energy
+            // and the per-step gauges and counters. Only the served simulation is registered, so
+            // the autotuner, fit and bench simulations leave the metrics alone
+    /// @param sim The orbital simulation
+    void registerOrbitalSimMetrics(OrbitalSim *sim)
+    {
+        metrics.groupNames[0].store("Significant bodies");
+        metrics.bodiesByGroup[0].store(sim->bodyCount);
+
+        for (int i = 0; (i < ASTEROID_GROUPNUM) && (i + 1 < METRICS_MAX_GROUPS); i++)
+        {
+            metrics.groupNames[i + 1].store(sim->asteroidGroups[i].name);
+            metrics.bodiesByGroup[i + 1].store(sim->asteroidGroups[i].count);
+            metrics.groupCount.store(i + 2);
+        }
+
+        metrics.initialEnergy.store(calculateSignificantEnergy(sim));
+        metrics.substeps.store(sim->substeps, std::memory_order_relaxed);
+        sim->hasMetrics = true;
     }
 
 
@@ -304,6 +1402,27 @@
     /// @param sim The orbital simulation
     void destroyOrbitalSim(OrbitalSim *sim)
     {
+        // The generator may still be writing asteroids
+        sim->generator->isStopping.store(true);
+        if (sim->generator->thread.joinable())
+        {
+            sim->generator->thread.join();
+        }
+
         delete[] sim->bodies;
+        delete[] sim->moons;
+        delete[] sim->tidalPositions;
+        delete[] sim->tidalAccelerations;
+        delete[] sim->tidalReactions;
+        delete[] sim->moonAccelerations;
+        delete[] sim->asteroids;
+        delete[] sim->tangents;
+        delete[] sim->checkpoint.bodies;
+        delete[] sim->checkpoint.moons;
+        delete[] sim->checkpoint.asteroids;
+        delete[] sim->checkpoint.tangents;
+        delete sim->generator;
+        destroyWorkerSchedule(sim->asteroidSchedule);
+        destroyWorkerPool(sim->workers);
         delete sim;
     }
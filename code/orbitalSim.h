@@ -0,0 +1,223 @@
+﻿/* *****************************************************************
+    * FILE INFORMATION *
+   ***************************************************************** */
+   
+/// @brief Orbital simulation
+/// @author Marc S. Ressl, Ian A. Dib, Luciano S. Cordero
+/// @copyright Copyright (c) 2022-2023
+
+
+/* *****************************************************************
+    * HEADER CONFIGURATION *
+   ***************************************************************** */
+
+   #ifndef ORBITALSIM_H
+   #define ORBITALSIM_H
+
+   //* NECESSARY LIBRARIES
+   #include <raylib.h>
+   #include <raymath.h>
+
+   //* NECESSARY HEADERS
+   #include "workerPool.h"
+
+    //* CONFIGURATION
+
+    // Enable/disable different simulations and configurations
+    #define SOLAR_SYSTEM 1
+    #define ALPHA_CENTAURI 0
+    #define TRAPPIST_1 0
+    #define BLACKHOLE 0
+    #define MASIVE_JUPITER 0
+
+    // Moon systems (Luna, the Galilean moons and Titan; needs SOLAR_SYSTEM). Moons are integrated
+    // in their planet's frame with nested substeps, short enough for their orbits of days, while
+    // the rest of the simulation keeps its step. Off by default (see the README for its cost)
+    #define MOON_SYSTEMS 0
+    #define MOON_STEPS_PER_ORBIT 128            // Nested substeps per orbit of a planet's fastest moon
+
+    // Number of asteroids to generate
+    #define NUM_ASTEROIDS 100
+
+    // Seed of the asteroid belt. Every asteroid draws from its own stream, so the belt only
+    // depends on the seed
+    #define ASTEROID_SEED 1
+
+    // Generate the asteroids on a background thread, so the window and the significant bodies
+    // come up at once. Batches join the simulation as they are ready
+    #define ASYNC_ASTEROID_GENERATION 1
+    #define ASTEROID_GENERATION_BATCH 4096
+
+    // Instability watchdog: on non-finite values or an energy jump, roll back to the last
+    // checkpoint and replay with the step halved (timeStep is split into substeps)
+    #define WATCHDOG 1
+    #define WATCHDOG_CHECKPOINT_INTERVAL 140    // Updates between checkpoints
+    #define WATCHDOG_ENERGY_TOLERANCE 1E-3      // Relative energy change allowed since the checkpoint
+    #define WATCHDOG_MAX_SUBSTEPS 64
+    #define WATCHDOG_RELAX_INTERVAL 1400        // Healthy updates before trying fewer substeps
+    #define WATCHDOG_MAX_REPLAY_STEPS 128       // Integration steps a single update may replay
+
+    // Largest tile of the tiled asteroid kernel (its accelerations live on the stack)
+    #define ASTEROID_MAX_TILE_SIZE 256
+
+    // Chaos indicators: integrate the variational equations of every asteroid with its state,
+    // in the same sweep over the bodies, to get its MEGNO and Lyapunov exponent
+    #define CHAOS_INDICATORS 0
+    #define CHAOS_RENORMALIZATION 1E20F         // Squared tangent length [m^2] that triggers a rescale
+
+
+    //* CONSTANTS & STRUCTURES
+   
+    #define GRAVITATIONAL_CONSTANT (6.6743E-11L)
+
+    // Number of asteroid groups (regions of the belt sharing their physical properties)
+    #define ASTEROID_GROUPNUM 3
+
+    /// @brief Orbital body definition, used for significant (attracting) bodies
+    struct OrbitalBody
+    {
+        const char *name;
+        float mass;                 // [kg]
+        float radius;               // [m]
+        Color color;                // Raylib color
+        Vector3 position;           // [m]
+        Vector3 velocity;           // [m/s]
+    };
+
+
+    /// @brief Asteroid definition: only the per-body hot data (24 bytes)
+    struct Asteroid
+    {
+        Vector3 position;           // [m]
+        Vector3 velocity;           // [m/s]
+    };
+
+
+    /// @brief Asteroid group definition: properties shared by every asteroid of the group
+    struct AsteroidGroup
+    {
+        const char *name;
+        float mass;                 // [kg]
+        float radius;               // [m]
+        Color color;                // Raylib color
+        int startIndex;             // First asteroid of the group
+        int count;                  // Number of asteroids of the group taking part
+    };
+
+
+    /// @brief Tangent vector of an asteroid and the running sums of its chaos indicators
+    struct AsteroidTangent
+    {
+        Vector3 position;           // Position deviation, rescaled to stay finite
+        Vector3 velocity;           // Velocity deviation, rescaled with the position
+        double time;                // Time since the tangent was seeded [s]
+        double logScale;            // Sum of the logs of every rescale
+        double megnoSum;            // t * Y(t), Y being the MEGNO
+        double megnoMeanSum;        // t * <Y>(t), its running mean
+    };
+
+
+    /// @brief Chaos indicators of an asteroid. MEGNO tends to 2 on regular orbits and grows
+            // without bound (as lyapunov * t / 2) on chaotic ones
+    struct ChaosIndicators
+    {
+        float megno;                // Running mean of the MEGNO, <Y>
+        float lyapunov;             // Largest Lyapunov exponent estimate [1/s]
+    };
+
+
+    /// @brief Moon state in its planet's frame. The moon is a significant body too, whose
+            // heliocentric state is the planet's plus this one
+    struct OrbitalMoon
+    {
+        int planetIndex;            // Significant body it orbits
+        Vector3 position;           // Relative to the planet [m]
+        Vector3 velocity;           // Relative to the planet [m/s]
+    };
+
+
+    // Opaque, defined in orbitalSim.cpp
+    struct AsteroidGenerator;
+
+
+    /// @brief Ways to compute the asteroid step, picked by the autotuner
+    enum AsteroidKernel
+    {
+        ASTEROID_KERNEL_FUSED,      // Each asteroid sums every body, then is kicked and drifted
+        ASTEROID_KERNEL_TILED,      // Each body is applied to a tile of asteroids before the next body
+        ASTEROID_KERNEL_NUM
+    };
+
+
+    /// @brief Execution settings of the asteroid step. They change speed, never results
+    struct OrbitalSimTuning
+    {
+        AsteroidKernel kernel;
+        int threadCount;            // Including the simulation thread
+        int chunkSize;              // Asteroids per work item
+        int tileSize;               // Asteroids per tile (tiled kernel)
+    };
+
+
+    /// @brief In-memory copy of the simulation state the watchdog rolls back to
+    struct OrbitalCheckpoint
+    {
+        float time;                 // [s]
+        double energy;              // Energy of the significant bodies [J]
+        OrbitalBody *bodies;
+        OrbitalMoon *moons;
+        Asteroid *asteroids;
+        AsteroidTangent *tangents;
+        int updateCount;            // Updates since the checkpoint was taken
+        int healthyCount;           // Consecutive healthy updates
+        bool hasFailed;             // Blew up at WATCHDOG_MAX_SUBSTEPS, no longer checked
+    };
+
+
+    /// @brief Orbital simulation definition
+    struct OrbitalSim
+    {
+        float timeStep;     // [s]
+        float time;         // Total elapsed time [s]
+        int substeps;       // Integration steps per timeStep, raised by the watchdog
+        int bodyCount;
+        OrbitalBody* bodies;
+        int moonCount;              // Significant bodies [0, moonCount) are moons
+        OrbitalMoon *moons;
+        Vector3 *tidalPositions;            // updateMoons scratch, by body
+        Vector3 *tidalAccelerations;        // updateMoons scratch, by body
+        Vector3 *tidalReactions;            // updateMoons scratch, by body
+        Vector3 *moonAccelerations;         // updateMoons scratch, by moon
+        int asteroidCount;          // Asteroids taking part, grows while they are generated
+        int asteroidCapacity;       // Asteroids once generation is done
+        Asteroid* asteroids;
+        AsteroidTangent *tangents;          // Only with CHAOS_INDICATORS, NULL otherwise
+        AsteroidGroup asteroidGroups[ASTEROID_GROUPNUM];
+        OrbitalCheckpoint checkpoint;
+        OrbitalSimTuning tuning;
+        WorkerPool *workers;
+        WorkerSchedule *asteroidSchedule;   // Chunk costs of the last asteroid step
+        AsteroidGenerator *generator;
+        bool hasMetrics;            // Served on the metrics endpoint, see registerOrbitalSimMetrics
+    };
+
+
+    //* PUBLIC FUNCTIONS PROTOTYPES
+
+    OrbitalSim *constructOrbitalSim(float timeStep, int asteroidCount = NUM_ASTEROIDS);
+    void registerOrbitalSimMetrics(OrbitalSim *sim);
+    void destroyOrbitalSim(OrbitalSim *sim);
+    void updateOrbitalSim(OrbitalSim *sim);
+    void finishAsteroidGeneration(OrbitalSim *sim);
+    void setOrbitalSimAsteroids(OrbitalSim *sim, const Asteroid *asteroids, int asteroidCount);
+    void setOrbitalSimBody(OrbitalSim *sim, int index, Vector3 position, Vector3 velocity);
+    bool updateAsteroids(OrbitalSim *sim, float timeStep);
+    ChaosIndicators getChaosIndicators(OrbitalSim *sim, int index);
+
+
+    #endif // ORBITALSIM_H
+
+
+
+
+
@@ -0,0 +1,173 @@
+/* *****************************************************************
+    * FILE INFORMATION *
+   ***************************************************************** */
+
+/// @brief Quality governor: watches the frame time against the target frame rate and trades
+        // render and physics quality for speed, one notch at a time and within set limits
+/// @author Marc S. Ressl, Ian A. Dib, Luciano S. Cordero
+/// @copyright Copyright (c) 2022-2023
+
+
+/* *****************************************************************
+    * FILE CONFIGURATION *
+   ***************************************************************** */
+
+    //* NECESSARY HEADERS
+
+    #include "qualityGovernor.h"
+
+
+    //* CONSTANTS
+
+    // Weight of the newest frame in the moving average
+    #define QUALITY_GOVERNOR_SMOOTHING 0.1F
+
+    // A frame this many periods long counts whole, as the GPU or the driver fell behind
+    #define QUALITY_GOVERNOR_OVERRUN 1.5F
+
+
+    //* PRIVATE FUNCTIONS PROTOTYPES
+
+    static bool lowerQuality(QualityGovernor *governor);
+    static bool raiseQuality(QualityGovernor *governor);
+
+
+/* *****************************************************************
+    * LOGIC MODULES *
+   ***************************************************************** */
+
+    //* NOTCHES
+
+    /// @brief Lowers the quality one notch: first fewer asteroid spheres, then fewer asteroids,
+            // then fewer physics steps per frame (the simulation then runs behind the wall clock)
+    /// @param governor The quality governor
+    /// @return Whether there was a notch left
+    static bool lowerQuality(QualityGovernor *governor)
+    {
+        if (governor->renderDistance > QUALITY_GOVERNOR_MIN_RENDER_DISTANCE)
+        {
+            governor->renderDistance *= 0.5F;
+            if (governor->renderDistance < QUALITY_GOVERNOR_MIN_RENDER_DISTANCE)
+            {
+                governor->renderDistance = QUALITY_GOVERNOR_MIN_RENDER_DISTANCE;
+            }
+        }
+
+        else if (governor->asteroidStride < QUALITY_GOVERNOR_MAX_ASTEROID_STRIDE)
+        {
+            governor->asteroidStride *= 2;
+        }
+
+        else if (governor->physicsSteps > QUALITY_GOVERNOR_MIN_PHYSICS_STEPS)
+        {
+            governor->physicsSteps--;
+        }
+
+        else
+        {
+            return false;
+        }
+
+        return true;
+    }
+
+
+    /// @brief Raises the quality one notch, undoing lowerQuality in reverse order
+    /// @param governor The quality governor
+    /// @return Whether there was a notch left
+    static bool raiseQuality(QualityGovernor *governor)
+    {
+        if (governor->physicsSteps < governor->maxPhysicsSteps)
+        {
+            governor->physicsSteps++;
+        }
+
+        else if (governor->asteroidStride > 1)
+        {
+            governor->asteroidStride /= 2;
+        }
+
+        else if (governor->renderDistance < QUALITY_GOVERNOR_MAX_RENDER_DISTANCE)
+        {
+            governor->renderDistance *= 2.0F;
+            if (governor->renderDistance > QUALITY_GOVERNOR_MAX_RENDER_DISTANCE)
+            {
+                governor->renderDistance = QUALITY_GOVERNOR_MAX_RENDER_DISTANCE;
+            }
+        }
+
+        else
+        {
+            return false;
+        }
+
+        return true;
+    }
+
+
+    //* QUALITY GOVERNOR MANAGEMENT
+
+    /// @brief Constructs a quality governor at the best quality
+    /// @param fps Target frames per second
+    /// @param maxPhysicsSteps Most physics steps per frame at the best quality
+    /// @return The quality governor
+    QualityGovernor *constructQualityGovernor(int fps, int maxPhysicsSteps)
+    {
+        QualityGovernor *governor = new QualityGovernor;
+
+        governor->frameBudget = 1.0F / fps;
+        governor->load = 0.0F;
+        governor->settleFrames = QUALITY_GOVERNOR_SETTLE_FRAMES;
+
+        governor->renderDistance = QUALITY_GOVERNOR_MAX_RENDER_DISTANCE;
+        governor->asteroidStride = 1;
+        governor->maxPhysicsSteps = (maxPhysicsSteps > QUALITY_GOVERNOR_MIN_PHYSICS_STEPS) ?
+                                    maxPhysicsSteps : QUALITY_GOVERNOR_MIN_PHYSICS_STEPS;
+        governor->physicsSteps = governor->maxPhysicsSteps;
+
+        return governor;
+    }
+
+
+    /// @brief Destroys a quality governor
+    /// @param governor The quality governor
+    void destroyQualityGovernor(QualityGovernor *governor)
+    {
+        delete governor;
+    }
+
+
+    /// @brief Feeds a frame to the governor, which may change the settings one notch
+    /// @param governor The quality governor
+    /// @param workTime Physics and render submission time of the frame, without the wait for
+            // the target frame rate [s]
+    /// @param frameTime Whole frame time [s]
+    void updateQualityGovernor(QualityGovernor *governor, float workTime, float frameTime)
+    {
+        // The frame time always includes the wait, so it only tells about overruns
+        float frameLoad = (frameTime > QUALITY_GOVERNOR_OVERRUN * governor->frameBudget) ? frameTime : workTime;
+        governor->load += QUALITY_GOVERNOR_SMOOTHING * (frameLoad - governor->load);
+
+        if (governor->settleFrames > 0)
+        {
+            governor->settleFrames--;
+            return;
+        }
+
+        bool isChanged = false;
+
+        if (governor->load > QUALITY_GOVERNOR_HIGH_LOAD * governor->frameBudget)
+        {
+            isChanged = lowerQuality(governor);
+        }
+
+        else if (governor->load < QUALITY_GOVERNOR_LOW_LOAD * governor->frameBudget)
+        {
+            isChanged = raiseQuality(governor);
+        }
+
+        if (isChanged)
+        {
+            governor->settleFrames = QUALITY_GOVERNOR_SETTLE_FRAMES;
+        }
+    }
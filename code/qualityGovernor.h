@@ -0,0 +1,65 @@
+/* *****************************************************************
+    * FILE INFORMATION *
+   ***************************************************************** */
+
+/// @brief Quality governor: watches the frame time against the target frame rate and trades
+        // render and physics quality for speed, one notch at a time and within set limits
+/// @author Marc S. Ressl, Ian A. Dib, Luciano S. Cordero
+/// @copyright Copyright (c) 2022-2023
+
+
+/* *****************************************************************
+    * HEADER CONFIGURATION *
+   ***************************************************************** */
+
+    #ifndef QUALITYGOVERNOR_H
+    #define QUALITYGOVERNOR_H
+
+
+    //* CONFIGURATION
+
+    #define QUALITY_GOVERNOR 1
+
+    // Camera distance below which asteroids are drawn as spheres: the best and worst settings
+    #define QUALITY_GOVERNOR_MAX_RENDER_DISTANCE 10.0F
+    #define QUALITY_GOVERNOR_MIN_RENDER_DISTANCE 1.25F
+
+    // Largest stride of the visible asteroids drawn (1 draws them all)
+    #define QUALITY_GOVERNOR_MAX_ASTEROID_STRIDE 16
+
+    // Fewest physics steps a frame may take when the simulation is behind the wall clock
+    #define QUALITY_GOVERNOR_MIN_PHYSICS_STEPS 1
+
+    // Quality drops above, and rises below, these fractions of the target frame period. A
+    // notch can halve or double the work, so both are more than a factor 2 apart
+    #define QUALITY_GOVERNOR_HIGH_LOAD 0.9F
+    #define QUALITY_GOVERNOR_LOW_LOAD 0.4F
+
+    // Frames after a change before the next one, so its effect shows in the average first
+    #define QUALITY_GOVERNOR_SETTLE_FRAMES 30
+
+
+    //* CONSTANTS & STRUCTURES
+
+    /// @brief Quality governor. The settings are read by the view and the main loop
+    struct QualityGovernor
+    {
+        float frameBudget;      // Target frame period [s]
+        float load;             // Moving average of the frame's work [s]
+        int settleFrames;       // Frames left before the next change
+
+        float renderDistance;   // Camera distance below which asteroids are spheres [display units]
+        int asteroidStride;     // Only every n-th asteroid is drawn
+        int physicsSteps;       // Most physics steps per frame
+        int maxPhysicsSteps;
+    };
+
+
+    //* PUBLIC FUNCTIONS PROTOTYPES
+
+    QualityGovernor *constructQualityGovernor(int fps, int maxPhysicsSteps);
+    void destroyQualityGovernor(QualityGovernor *governor);
+    void updateQualityGovernor(QualityGovernor *governor, float workTime, float frameTime);
+
+
+    #endif // QUALITYGOVERNOR_H
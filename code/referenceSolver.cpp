@@ -0,0 +1,301 @@
+/* *****************************************************************
+    * FILE INFORMATION *
+   ***************************************************************** */
+
+/// @brief Long double, direct-sum, small-step reference solver for a sampled subset of a
+        // simulation, and a checker of how far a fast simulation diverges from it.
+        // It follows calculateGravitationalForce: F = G * m1 * m2 / r^2 along the unit direction,
+        // zero below 1 m, a = F / m1, and the same drift-kick-drift leapfrog step
+/// @author Marc S. Ressl, Ian A. Dib, Luciano S. Cordero
+/// @copyright Copyright (c) 2022-2023
+
+
+/* *****************************************************************
+    * FILE CONFIGURATION *
+   ***************************************************************** */
+
+    //* NECESSARY LIBRARIES
+
+    #include <math.h>
+
+
+    //* NECESSARY HEADERS
+
+    #include "referenceSolver.h"
+
+
+    //* PRIVATE FUNCTIONS PROTOTYPES
+
+    static ReferenceVector toReferenceVector(Vector3 vector);
+    static long double getSystemState(OrbitalSim *sim, int index, ReferenceVector *position, ReferenceVector *velocity);
+    static ReferenceVector calculateReferenceForce(ReferenceVector position1, long double mass1,
+                                                    ReferenceVector position2, long double mass2);
+
+
+/* *****************************************************************
+    * LOGIC MODULES *
+   ***************************************************************** */
+
+    //* REFERENCE PHYSICS
+
+    static ReferenceVector toReferenceVector(Vector3 vector)
+    {
+        return {vector.x, vector.y, vector.z};
+    }
+
+
+    /// @brief Gets the state of the barycenter of a significant body and its moons. It is the one
+            // that follows the body's heliocentric orbit, while the body itself wobbles around it
+    /// @param sim The orbital simulation
+    /// @param index Index of the significant body
+    /// @param position Where to store the barycenter's position [m]
+    /// @param velocity Where to store the barycenter's velocity [m/s]
+    /// @return Mass of the body and its moons [kg]
+    static long double getSystemState(OrbitalSim *sim, int index, ReferenceVector *position, ReferenceVector *velocity)
+    {
+        OrbitalBody *body = &sim->bodies[index];
+        long double totalMass = body->mass;
+        *position = {body->position.x * totalMass, body->position.y * totalMass, body->position.z * totalMass};
+        *velocity = {body->velocity.x * totalMass, body->velocity.y * totalMass, body->velocity.z * totalMass};
+
+        for (int i = 0; i < sim->moonCount; i++)
+        {
+            if (sim->moons[i].planetIndex == index)
+            {
+                OrbitalBody *moon = &sim->bodies[i];
+                long double mass = moon->mass;
+
+                position->x += moon->position.x * mass;
+                position->y += moon->position.y * mass;
+                position->z += moon->position.z * mass;
+                velocity->x += moon->velocity.x * mass;
+                velocity->y += moon->velocity.y * mass;
+                velocity->z += moon->velocity.z * mass;
+                totalMass += mass;
+            }
+        }
+
+        *position = {position->x / totalMass, position->y / totalMass, position->z / totalMass};
+        *velocity = {velocity->x / totalMass, velocity->y / totalMass, velocity->z / totalMass};
+
+        return totalMass;
+    }
+
+
+    /// @brief calculateGravitationalForce in long double
+    /// @param position1 Position of the attracted body
+    /// @param mass1 Mass of the attracted body
+    /// @param position2 Position of the attracting body
+    /// @param mass2 Mass of the attracting body
+    /// @return Force on the first body [N]
+    static ReferenceVector calculateReferenceForce(ReferenceVector position1, long double mass1,
+                                                    ReferenceVector position2, long double mass2)
+    {
+        ReferenceVector direction = {position2.x - position1.x, position2.y - position1.y, position2.z - position1.z};
+        long double distance = sqrtl(direction.x * direction.x + direction.y * direction.y + direction.z * direction.z);
+
+        if (distance < 1.0L)
+        {
+            return {0, 0, 0};
+        }
+
+        long double forceMagnitude = GRAVITATIONAL_CONSTANT * mass1 * mass2 / (distance * distance);
+        long double scale = forceMagnitude / distance;
+
+        return {direction.x * scale, direction.y * scale, direction.z * scale};
+    }
+
+
+    //* REFERENCE SIMULATION MANAGEMENT
+
+    /// @brief Copies the heliocentric significant bodies and an evenly strided sample of asteroids.
+            // A planet with moons is followed as its system: from the barycenter and with the
+            // mass of the planet and its moons, which the other bodies feel in the simulation
+    /// @param sim The orbital simulation, with its asteroids generated
+    /// @param sampleCount Asteroids to follow (clamped to the simulation's)
+    /// @param substeps Reference steps per simulation timeStep
+    /// @return The reference simulation
+    ReferenceSim *constructReferenceSim(OrbitalSim *sim, int sampleCount, int substeps)
+    {
+        ReferenceSim *reference = new ReferenceSim;
+
+        if (sampleCount > sim->asteroidCount)
+        {
+            sampleCount = sim->asteroidCount;
+        }
+
+        reference->substeps = substeps;
+        reference->firstBody = sim->moonCount;
+        reference->bodyCount = sim->bodyCount - sim->moonCount;
+        reference->sampleCount = sampleCount;
+        reference->masses = new long double[reference->bodyCount];
+        reference->positions = new ReferenceVector[reference->bodyCount + sampleCount];
+        reference->velocities = new ReferenceVector[reference->bodyCount + sampleCount];
+        reference->sampleIndices = new int[sampleCount];
+        reference->sampleMasses = new long double[sampleCount];
+
+        for (int i = 0; i < reference->bodyCount; i++)
+        {
+            reference->masses[i] = getSystemState(sim, reference->firstBody + i, &reference->positions[i],
+                                                    &reference->velocities[i]);
+        }
+
+        for (int i = 0; i < sampleCount; i++)
+        {
+            int index = (int)((long long)i * sim->asteroidCount / sampleCount);
+            reference->sampleIndices[i] = index;
+            reference->positions[reference->bodyCount + i] = toReferenceVector(sim->asteroids[index].position);
+            reference->velocities[reference->bodyCount + i] = toReferenceVector(sim->asteroids[index].velocity);
+
+            for (int j = 0; j < ASTEROID_GROUPNUM; j++)
+            {
+                AsteroidGroup *group = &sim->asteroidGroups[j];
+
+                if ((index >= group->startIndex) && (index < group->startIndex + group->count))
+                {
+                    reference->sampleMasses[i] = group->mass;
+                }
+            }
+        }
+
+        return reference;
+    }
+
+
+    /// @brief Destroys a reference simulation
+    /// @param reference The reference simulation
+    void destroyReferenceSim(ReferenceSim *reference)
+    {
+        delete[] reference->masses;
+        delete[] reference->positions;
+        delete[] reference->velocities;
+        delete[] reference->sampleIndices;
+        delete[] reference->sampleMasses;
+        delete reference;
+    }
+
+
+    /// @brief Advances the reference one simulation timeStep, in reference->substeps steps of the
+            // same drift-kick-drift leapfrog as the simulation
+    /// @param reference The reference simulation
+    /// @param timeStep Simulation timeStep [s]
+    void updateReferenceSim(ReferenceSim *reference, float timeStep)
+    {
+        int totalCount = reference->bodyCount + reference->sampleCount;
+        long double step = (long double)timeStep / reference->substeps;
+        long double halfStep = step / 2;
+        ReferenceVector *accelerations = new ReferenceVector[totalCount];
+
+        for (int substep = 0; substep < reference->substeps; substep++)
+        {
+            // x(n+1/2) = x(n) + v(n) * dt/2
+            for (int i = 0; i < totalCount; i++)
+            {
+                reference->positions[i].x += reference->velocities[i].x * halfStep;
+                reference->positions[i].y += reference->velocities[i].y * halfStep;
+                reference->positions[i].z += reference->velocities[i].z * halfStep;
+            }
+
+            // Every acceleration uses the positions at t(n+1/2), as in updateOrbitalSim
+            for (int i = 0; i < totalCount; i++)
+            {
+                bool isSample = i >= reference->bodyCount;
+                long double mass = isSample ? reference->sampleMasses[i - reference->bodyCount] : reference->masses[i];
+                ReferenceVector force = {0, 0, 0};
+
+                for (int j = 0; j < reference->bodyCount; j++)
+                {
+                    if (j == i)
+                    {
+                        continue;
+                    }
+
+                    ReferenceVector pairForce = calculateReferenceForce(reference->positions[i], mass,
+                                                                        reference->positions[j], reference->masses[j]);
+                    force.x += pairForce.x;
+                    force.y += pairForce.y;
+                    force.z += pairForce.z;
+                }
+
+                accelerations[i] = {force.x / mass, force.y / mass, force.z / mass};
+            }
+
+            for (int i = 0; i < totalCount; i++)
+            {
+                // v(n+1) = v(n) + a(n+1/2) * dt
+                ReferenceVector *velocity = &reference->velocities[i];
+                velocity->x += accelerations[i].x * step;
+                velocity->y += accelerations[i].y * step;
+                velocity->z += accelerations[i].z * step;
+
+                // x(n+1) = x(n+1/2) + v(n+1) * dt/2
+                ReferenceVector *position = &reference->positions[i];
+                position->x += velocity->x * halfStep;
+                position->y += velocity->y * halfStep;
+                position->z += velocity->z * halfStep;
+            }
+        }
+
+        delete[] accelerations;
+    }
+
+
+    //* DIVERGENCE CHECK
+
+    /// @brief Measures how far the simulation has drifted from the reference, over the
+            // heliocentric significant bodies and the sampled asteroids
+    /// @param reference The reference simulation, advanced to the simulation's time
+    /// @param sim The orbital simulation
+    /// @return Largest divergences
+    ReferenceDivergence calculateReferenceDivergence(ReferenceSim *reference, OrbitalSim *sim)
+    {
+        ReferenceDivergence divergence = {0, 0, 0};
+        int totalCount = reference->bodyCount + reference->sampleCount;
+
+        for (int i = 0; i < totalCount; i++)
+        {
+            ReferenceVector position;
+            ReferenceVector velocity;
+
+            if (i >= reference->bodyCount)
+            {
+                Asteroid *asteroid = &sim->asteroids[reference->sampleIndices[i - reference->bodyCount]];
+                position = toReferenceVector(asteroid->position);
+                velocity = toReferenceVector(asteroid->velocity);
+            }
+
+            else
+            {
+                getSystemState(sim, reference->firstBody + i, &position, &velocity);
+            }
+
+            ReferenceVector referencePosition = reference->positions[i];
+            ReferenceVector referenceVelocity = reference->velocities[i];
+
+            long double dx = position.x - referencePosition.x;
+            long double dy = position.y - referencePosition.y;
+            long double dz = position.z - referencePosition.z;
+            double positionDivergence = (double)sqrtl(dx * dx + dy * dy + dz * dz);
+
+            long double dvx = velocity.x - referenceVelocity.x;
+            long double dvy = velocity.y - referenceVelocity.y;
+            long double dvz = velocity.z - referenceVelocity.z;
+            double velocityDivergence = (double)sqrtl(dvx * dvx + dvy * dvy + dvz * dvz);
+
+            double distance = (double)sqrtl(referencePosition.x * referencePosition.x +
+                                            referencePosition.y * referencePosition.y +
+                                            referencePosition.z * referencePosition.z);
+            double relativePosition = (distance >= 1.0) ? positionDivergence / distance : 0;
+
+            // Written so that NaN divergences propagate
+            divergence.position = (positionDivergence > divergence.position) || (positionDivergence != positionDivergence) ?
+                                    positionDivergence : divergence.position;
+            divergence.velocity = (velocityDivergence > divergence.velocity) || (velocityDivergence != velocityDivergence) ?
+                                    velocityDivergence : divergence.velocity;
+            divergence.relativePosition = (relativePosition > divergence.relativePosition) ||
+                                            (relativePosition != relativePosition) ?
+                                            relativePosition : divergence.relativePosition;
+        }
+
+        return divergence;
+    }
@@ -0,0 +1,66 @@
+/* *****************************************************************
+    * FILE INFORMATION *
+   ***************************************************************** */
+
+/// @brief Long double, direct-sum, small-step reference solver for a sampled subset of a
+        // simulation, and a checker of how far a fast simulation diverges from it
+/// @author Marc S. Ressl, Ian A. Dib, Luciano S. Cordero
+/// @copyright Copyright (c) 2022-2023
+
+
+/* *****************************************************************
+    * HEADER CONFIGURATION *
+   ***************************************************************** */
+
+    #ifndef REFERENCESOLVER_H
+    #define REFERENCESOLVER_H
+
+
+    //* NECESSARY HEADERS
+
+    #include "orbitalSim.h"
+
+
+    //* CONSTANTS & STRUCTURES
+
+    struct ReferenceVector
+    {
+        long double x, y, z;
+    };
+
+
+    /// @brief Reference state: every heliocentric significant body, plus sampled asteroids.
+            // Moons are left out, as they need their planet's frame at the simulation's step: a
+            // planet with moons is followed by the barycenter of its system
+    struct ReferenceSim
+    {
+        int substeps;                   // Reference steps per simulation timeStep
+        int firstBody;                  // Simulation index of the first body (the moons come before)
+        int bodyCount;
+        long double *masses;            // [kg]
+        ReferenceVector *positions;     // Bodies first, then sampled asteroids [m]
+        ReferenceVector *velocities;    // [m/s]
+        int sampleCount;
+        int *sampleIndices;             // Sampled asteroid indices in the simulation
+        long double *sampleMasses;      // [kg]
+    };
+
+
+    /// @brief Largest divergence of the compared bodies
+    struct ReferenceDivergence
+    {
+        double position;                // [m]
+        double velocity;                // [m/s]
+        double relativePosition;        // Position divergence over distance from the origin
+    };
+
+
+    //* PUBLIC FUNCTIONS PROTOTYPES
+
+    ReferenceSim *constructReferenceSim(OrbitalSim *sim, int sampleCount, int substeps);
+    void destroyReferenceSim(ReferenceSim *reference);
+    void updateReferenceSim(ReferenceSim *reference, float timeStep);
+    ReferenceDivergence calculateReferenceDivergence(ReferenceSim *reference, OrbitalSim *sim);
+
+
+    #endif // REFERENCESOLVER_H
@@ -0,0 +1,349 @@
+/* *****************************************************************
+    * FILE INFORMATION *
+   ***************************************************************** */
+
+/// @brief Render benchmark: replays a camera path over a frozen (or live) simulation for several
+        // asteroid counts and reports frame time percentiles, draw calls and estimated vertices as CSV.
+        // Usage: orbitalsim_renderbench [--asteroids 1000,10000,...] [--path file | --record file]
+        //                               [--frames n] [--live]
+        // For reproducible software rendering under Mesa: LIBGL_ALWAYS_SOFTWARE=1 (llvmpipe)
+/// @author Marc S. Ressl, Ian A. Dib, Luciano S. Cordero
+/// @copyright Copyright (c) 2022-2023
+
+
+/* *****************************************************************
+    * FILE CONFIGURATION *
+   ***************************************************************** */
+
+    //* NECESSARY LIBRARIES
+
+    #include <stdio.h>
+    #include <stdlib.h>
+    #include <string.h>
+    #include <math.h>
+    #include <algorithm>
+    #include <vector>
+
+
+    //* NECESSARY HEADERS
+
+    #include "orbitalSim.h"
+    #include "view.h"
+    #include "snapshot.h"
+    #include "metrics.h"
+
+
+    //* CONSTANTS
+
+    #define SECONDS_PER_DAY 86400
+
+    // Frames of the scripted path: two turns around the Sun, zooming in and out of the
+    // sphere rendering distance (10 display units) twice per turn
+    #define BENCH_PATH_FRAMES 600
+    #define BENCH_PATH_MIN_DISTANCE 4.0F
+    #define BENCH_PATH_MAX_DISTANCE 30.0F
+
+    // Frames rendered and discarded before timing (shader compilation, first uploads)
+    #define BENCH_WARMUP_FRAMES 10
+
+    #define BENCH_MAX_RUNS 16
+
+
+    //* STRUCTURES
+
+    /// @brief Camera pose of one frame
+    struct CameraPose
+    {
+        Vector3 position;
+        Vector3 target;
+    };
+
+
+/* *****************************************************************
+    * LOGIC MODULES *
+   ***************************************************************** */
+
+    //* CAMERA PATHS
+
+    /// @brief Builds the scripted camera path
+    /// @param frameCount Number of frames
+    /// @return The path
+    std::vector<CameraPose> makeScriptedPath(int frameCount)
+    {
+        std::vector<CameraPose> path(frameCount);
+        float middleDistance = 0.5F * (BENCH_PATH_MIN_DISTANCE + BENCH_PATH_MAX_DISTANCE);
+        float amplitude = 0.5F * (BENCH_PATH_MAX_DISTANCE - BENCH_PATH_MIN_DISTANCE);
+
+        for (int i = 0; i < frameCount; i++)
+        {
+            float angle = 4.0F * PI * i / frameCount;
+            float distance = middleDistance + amplitude * cosf(2.0F * angle);
+
+            path[i].position = {distance * cosf(angle), 0.5F * distance, distance * sinf(angle)};
+            path[i].target = {0.0F, 0.0F, 0.0F};
+        }
+
+        return path;
+    }
+
+
+    /// @brief Loads a camera path recorded with --record: one "px py pz tx ty tz" line per frame
+    /// @param filename Path file
+    /// @param path Destination path
+    /// @return Whether at least one pose was read
+    bool loadCameraPath(const char *filename, std::vector<CameraPose> &path)
+    {
+        FILE *file = fopen(filename, "r");
+        if (!file)
+        {
+            fprintf(stderr, "orbitalsim_renderbench: could not open %s\n", filename);
+            return false;
+        }
+
+        CameraPose pose;
+        while (fscanf(file, "%f %f %f %f %f %f", &pose.position.x, &pose.position.y, &pose.position.z,
+                        &pose.target.x, &pose.target.y, &pose.target.z) == 6)
+        {
+            path.push_back(pose);
+        }
+
+        fclose(file);
+
+        return !path.empty();
+    }
+
+
+    //* BENCHMARK
+
+    /// @brief Gets a percentile of sorted samples (nearest rank)
+    /// @param samples Sorted samples
+    /// @param percentile Percentile [0, 100]
+    /// @return The percentile
+    double getPercentile(const std::vector<double> &samples, double percentile)
+    {
+        size_t rank = (size_t)ceil(percentile / 100.0 * samples.size());
+
+        return samples[(rank > 0) ? rank - 1 : 0];
+    }
+
+
+    /// @brief Builds a simulation with every asteroid generated, at its initial state, so every
+            // run renders the same input whatever the generation speed
+    /// @param timeStep Integration step [s]
+    /// @param asteroidCount Number of asteroids
+    /// @return The orbital simulation
+    OrbitalSim *constructBenchSim(float timeStep, int asteroidCount)
+    {
+        OrbitalSim *sim = constructOrbitalSim(timeStep, asteroidCount);
+        finishAsteroidGeneration(sim);
+
+        return sim;
+    }
+
+
+    /// @brief Renders the camera path once and prints a CSV row
+    /// @param view The view
+    /// @param path Camera path
+    /// @param asteroidCount Number of asteroids
+    /// @param timeStep Integration step [s]
+    /// @param isLive Whether the simulation advances every frame (else it stays frozen)
+    /// @return Whether the window is still open
+    bool runRenderBench(View *view, const std::vector<CameraPose> &path, int asteroidCount,
+                        float timeStep, bool isLive)
+    {
+        OrbitalSim *sim = constructBenchSim(timeStep, asteroidCount);
+        Snapshot *snapshot = constructSnapshot(sim);
+        packSnapshot(snapshot, sim);
+
+        std::vector<double> frameTimes;
+        long drawCalls = 0;
+        long long vertices = 0;
+        int frameCount = (int)path.size();
+
+        for (int i = -BENCH_WARMUP_FRAMES; (i < frameCount) && isViewRendering(view); i++)
+        {
+            const CameraPose &pose = path[(i < 0) ? 0 : i];
+            view->camera.position = pose.position;
+            view->camera.target = pose.target;
+
+            if (isLive)
+            {
+                updateOrbitalSim(sim);
+                packSnapshot(snapshot, sim);
+            }
+
+            // Includes EndDrawing, so the frame time covers the GPU (or llvmpipe) work too
+            uint64_t frameStart = getMetricsTime();
+            renderView(view, snapshot);
+            uint64_t frameTime = getMetricsTime() - frameStart;
+
+            if (i >= 0)
+            {
+                frameTimes.push_back(frameTime * 1E-6);
+                drawCalls += view->stats.drawCalls;
+                vertices += view->stats.vertices;
+            }
+        }
+
+        bool isComplete = (int)frameTimes.size() == frameCount;
+
+        if (!frameTimes.empty())
+        {
+            double sum = 0;
+            for (size_t i = 0; i < frameTimes.size(); i++)
+            {
+                sum += frameTimes[i];
+            }
+
+            std::sort(frameTimes.begin(), frameTimes.end());
+            size_t frames = frameTimes.size();
+
+            printf("%d,%d,%u,%.3f,%.3f,%.3f,%.3f,%.3f,%ld,%lld\n", asteroidCount, isLive ? 1 : 0, (unsigned)frames,
+                    sum / frames, getPercentile(frameTimes, 50), getPercentile(frameTimes, 90),
+                    getPercentile(frameTimes, 99), frameTimes.back(),
+                    drawCalls / (long)frames, vertices / (long long)frames);
+            fflush(stdout);
+        }
+
+        destroySnapshot(snapshot);
+        destroyOrbitalSim(sim);
+
+        return isComplete;
+    }
+
+
+    /// @brief Lets the user fly over a frozen simulation and records the camera of every frame
+    /// @param view The view
+    /// @param filename Path file
+    /// @param asteroidCount Number of asteroids
+    /// @param timeStep Integration step [s]
+    /// @return Whether the path file could be written
+    bool recordCameraPath(View *view, const char *filename, int asteroidCount, float timeStep)
+    {
+        FILE *file = fopen(filename, "w");
+        if (!file)
+        {
+            fprintf(stderr, "orbitalsim_renderbench: could not write %s\n", filename);
+            return false;
+        }
+
+        OrbitalSim *sim = constructBenchSim(timeStep, asteroidCount);
+        Snapshot *snapshot = constructSnapshot(sim);
+        packSnapshot(snapshot, sim);
+
+        view->isFreeCamera = true;
+
+        while (isViewRendering(view))
+        {
+            renderView(view, snapshot);
+
+            Camera3D *camera = &view->camera;
+            fprintf(file, "%f %f %f %f %f %f\n", camera->position.x, camera->position.y, camera->position.z,
+                    camera->target.x, camera->target.y, camera->target.z);
+        }
+
+        fclose(file);
+        destroySnapshot(snapshot);
+        destroyOrbitalSim(sim);
+
+        return true;
+    }
+
+
+/* *****************************************************************
+    * MAIN LOGIC *
+   ***************************************************************** */
+
+    int main(int argc, char **argv)
+    {
+        // Reference integration step: 50 simulated days every 140 steps
+        int fps = 140;
+        float timeStep = 50 * SECONDS_PER_DAY / (float)fps;
+
+        int asteroidCounts[BENCH_MAX_RUNS] = {1000, 10000, 100000, 1000000};
+        int runCount = 4;
+        int frameCount = BENCH_PATH_FRAMES;
+        const char *pathFilename = NULL;
+        const char *recordFilename = NULL;
+        bool isLive = false;
+
+        for (int i = 1; i < argc; i++)
+        {
+            if ((strcmp(argv[i], "--asteroids") == 0) && (i + 1 < argc))
+            {
+                runCount = 0;
+                for (char *count = strtok(argv[++i], ","); count && (runCount < BENCH_MAX_RUNS); count = strtok(NULL, ","))
+                {
+                    asteroidCounts[runCount++] = atoi(count);
+                }
+            }
+
+            else if ((strcmp(argv[i], "--path") == 0) && (i + 1 < argc))
+            {
+                pathFilename = argv[++i];
+            }
+
+            else if ((strcmp(argv[i], "--record") == 0) && (i + 1 < argc))
+            {
+                recordFilename = argv[++i];
+            }
+
+            else if ((strcmp(argv[i], "--frames") == 0) && (i + 1 < argc))
+            {
+                frameCount = atoi(argv[++i]);
+            }
+
+            else if (strcmp(argv[i], "--live") == 0)
+            {
+                isLive = true;
+            }
+
+            else
+            {
+                fprintf(stderr, "usage: orbitalsim_renderbench [--asteroids 1000,10000,...] "
+                                "[--path file | --record file] [--frames n] [--live]\n");
+                return 1;
+            }
+        }
+
+        std::vector<CameraPose> path;
+        if (pathFilename ? !loadCameraPath(pathFilename, path) : (frameCount <= 0))
+        {
+            return 1;
+        }
+
+        if (!pathFilename)
+        {
+            path = makeScriptedPath(frameCount);
+        }
+
+        View *view = constructView(fps);
+
+        // Recorded at the interactive frame rate, so the path replays at the speed it was flown
+        if (recordFilename)
+        {
+            bool isRecorded = recordCameraPath(view, recordFilename, (runCount > 0) ? asteroidCounts[0] : NUM_ASTEROIDS,
+                                                timeStep);
+            destroyView(view);
+
+            return isRecorded ? 0 : 1;
+        }
+
+        // Frames are timed unthrottled
+        SetTargetFPS(0);
+        view->isFreeCamera = false;
+
+        printf("asteroids,live,frames,mean_ms,p50_ms,p90_ms,p99_ms,max_ms,draw_calls,est_vertices\n");
+
+        for (int i = 0; i < runCount; i++)
+        {
+            if (!runRenderBench(view, path, asteroidCounts[i], timeStep, isLive))
+            {
+                break;
+            }
+        }
+
+        destroyView(view);
+
+        return 0;
+    }
@@ -0,0 +1,396 @@
+/* *****************************************************************
+    * FILE INFORMATION *
+   ***************************************************************** */
+
+/// @brief Strong and weak scaling benchmark of the headless simulation step, for every asteroid
+        // kernel at 1..N threads. Reports step time, per-phase breakdown, parallel efficiency and
+        // achieved asteroid memory bandwidth as CSV (or JSON), and can flag regressions against
+        // a previous CSV run.
+        // With a distribution, the asteroids are a synthetic system instead of the belt.
+        // Usage: orbitalsim_scalebench [--asteroids n] [--steps n] [--max-threads n] [--json]
+        //                              [--baseline file.csv] [--threshold fraction]
+        //                              [--distribution kuiper|oort|disk|plummer|galaxy] [--seed n]
+/// @author Marc S. Ressl, Ian A. Dib, Luciano S. Cordero
+/// @copyright Copyright (c) 2022-2023
+
+
+/* *****************************************************************
+    * FILE CONFIGURATION *
+   ***************************************************************** */
+
+    //* NECESSARY LIBRARIES
+
+    #include <stdio.h>
+    #include <stdlib.h>
+    #include <string.h>
+    #include <string>
+    #include <vector>
+
+
+    //* NECESSARY HEADERS
+
+    #include "orbitalSim.h"
+    #include "metrics.h"
+    #include "syntheticSystems.h"
+
+
+    //* CONSTANTS
+
+    #define SECONDS_PER_DAY 86400
+
+    // Asteroids of the strong runs, and per thread in the weak runs
+    #define SCALE_BENCH_ASTEROIDS 100000
+
+    // Timed steps per run, after the warm-up steps
+    #define SCALE_BENCH_STEPS 50
+    #define SCALE_BENCH_WARMUP_STEPS 5
+
+    // Step time increase over the baseline reported as a regression
+    #define SCALE_BENCH_THRESHOLD 0.10
+
+    // Bytes moved per asteroid and step: its position and velocity, read and written
+    #define ASTEROID_STEP_BYTES (2 * sizeof(Asteroid))
+
+    static const char *kernelNames[ASTEROID_KERNEL_NUM] = {"fused", "tiled"};
+
+
+    //* STRUCTURES
+
+    /// @brief Result of one run
+    struct ScaleResult
+    {
+        std::string mode;               // "strong" or "weak"
+        std::string kernel;
+        int threadCount;
+        int asteroidCount;
+        double stepTime;                // Mean update [ms]
+        double phaseTimes[3];           // Significant bodies, asteroids, integration [ms]
+        double otherTime;               // Watchdog, energy and the rest of the update [ms]
+        double efficiency;
+        double bandwidth;               // Asteroid phase [GB/s]
+    };
+
+
+/* *****************************************************************
+    * LOGIC MODULES *
+   ***************************************************************** */
+
+    //* RUNS
+
+    /// @brief Replaces the belt of a simulation with a synthetic system around its most massive body
+    /// @param sim The orbital simulation
+    /// @param distribution The system
+    /// @param seed Its seed
+    void setSyntheticAsteroids(OrbitalSim *sim, SyntheticDistribution distribution, uint64_t seed)
+    {
+        float mass = 0;
+        for (int i = 0; i < sim->bodyCount; i++)
+        {
+            mass = (sim->bodies[i].mass > mass) ? sim->bodies[i].mass : mass;
+        }
+
+        std::vector<Asteroid> asteroids(sim->asteroidCapacity);
+
+        uint64_t startTime = getMetricsTime();
+        generateSyntheticSystem(sim->workers, distribution, seed, mass, asteroids.data(), sim->asteroidCapacity);
+        fprintf(stderr, "orbitalsim_scalebench: %d %s bodies generated in %.3f s\n", sim->asteroidCapacity,
+                getSyntheticDistributionName(distribution), (getMetricsTime() - startTime) * 1E-9);
+
+        setOrbitalSimAsteroids(sim, asteroids.data(), sim->asteroidCapacity);
+    }
+
+
+    /// @brief Times SCALE_BENCH_STEPS updates of a simulation
+    /// @param kernel Asteroid kernel
+    /// @param threadCount Threads, including the simulation thread
+    /// @param asteroidCount Number of asteroids
+    /// @param stepCount Timed steps
+    /// @param distribution Synthetic system of the asteroids, SYNTHETIC_DISTRIBUTION_NUM for the belt
+    /// @param seed Seed of the synthetic system
+    /// @param result Destination of the times (mode, kernel and efficiency are set by the caller)
+    void runScaleBench(AsteroidKernel kernel, int threadCount, int asteroidCount, int stepCount,
+                        SyntheticDistribution distribution, uint64_t seed, ScaleResult *result)
+    {
+        OrbitalSim *sim = constructOrbitalSim(50 * SECONDS_PER_DAY / 140.0F, asteroidCount);
+
+        if (distribution != SYNTHETIC_DISTRIBUTION_NUM)
+        {
+            setSyntheticAsteroids(sim, distribution, seed);
+        }
+
+        while (sim->asteroidCount < sim->asteroidCapacity)
+        {
+            updateOrbitalSim(sim);
+        }
+
+        sim->tuning.kernel = kernel;
+        sim->tuning.threadCount = threadCount;
+
+        for (int i = 0; i < SCALE_BENCH_WARMUP_STEPS; i++)
+        {
+            updateOrbitalSim(sim);
+        }
+
+        const MetricsPhase phases[3] = {METRICS_PHASE_SIGNIFICANT_BODIES, METRICS_PHASE_ASTEROIDS,
+                                        METRICS_PHASE_INTEGRATION};
+        uint64_t phaseStarts[3];
+        for (int i = 0; i < 3; i++)
+        {
+            phaseStarts[i] = metrics.phases[phases[i]].sumNanoseconds.load();
+        }
+
+        uint64_t startTime = getMetricsTime();
+        for (int i = 0; i < stepCount; i++)
+        {
+            updateOrbitalSim(sim);
+        }
+        uint64_t totalTime = getMetricsTime() - startTime;
+
+        result->threadCount = threadCount;
+        result->asteroidCount = asteroidCount;
+        result->stepTime = totalTime * 1E-6 / stepCount;
+        result->otherTime = result->stepTime;
+
+        for (int i = 0; i < 3; i++)
+        {
+            result->phaseTimes[i] = (metrics.phases[phases[i]].sumNanoseconds.load() - phaseStarts[i]) * 1E-6 / stepCount;
+            result->otherTime -= result->phaseTimes[i];
+        }
+
+        // Substeps raised by the watchdog move the asteroids more than once per update
+        double asteroidBytes = (double)ASTEROID_STEP_BYTES * asteroidCount * sim->substeps;
+        result->bandwidth = (result->phaseTimes[1] > 0) ? asteroidBytes / (result->phaseTimes[1] * 1E6) : 0;
+
+        destroyOrbitalSim(sim);
+    }
+
+
+    //* OUTPUT AND BASELINE
+
+    void printCSVHeader()
+    {
+        printf("mode,kernel,threads,asteroids,step_ms,significant_ms,asteroids_ms,integration_ms,other_ms,"
+                "efficiency,bandwidth_gbs\n");
+    }
+
+
+    void printCSVResult(const ScaleResult &result)
+    {
+        printf("%s,%s,%d,%d,%.4f,%.4f,%.4f,%.4f,%.4f,%.3f,%.3f\n", result.mode.c_str(), result.kernel.c_str(),
+                result.threadCount, result.asteroidCount, result.stepTime, result.phaseTimes[0],
+                result.phaseTimes[1], result.phaseTimes[2], result.otherTime, result.efficiency, result.bandwidth);
+    }
+
+
+    void printJSONResults(const std::vector<ScaleResult> &results)
+    {
+        printf("[\n");
+
+        for (size_t i = 0; i < results.size(); i++)
+        {
+            const ScaleResult &result = results[i];
+            printf("  {\"mode\": \"%s\", \"kernel\": \"%s\", \"threads\": %d, \"asteroids\": %d, "
+                    "\"step_ms\": %.4f, \"significant_ms\": %.4f, \"asteroids_ms\": %.4f, \"integration_ms\": %.4f, "
+                    "\"other_ms\": %.4f, \"efficiency\": %.3f, \"bandwidth_gbs\": %.3f}%s\n",
+                    result.mode.c_str(), result.kernel.c_str(), result.threadCount, result.asteroidCount,
+                    result.stepTime, result.phaseTimes[0], result.phaseTimes[1], result.phaseTimes[2],
+                    result.otherTime, result.efficiency, result.bandwidth, (i + 1 < results.size()) ? "," : "");
+        }
+
+        printf("]\n");
+    }
+
+
+    /// @brief Compares the results with a previous CSV run of the same configurations
+    /// @param filename Baseline CSV
+    /// @param results Current results
+    /// @param threshold Allowed step time increase (0.1 is 10%)
+    /// @return Number of regressions, or -1 if the baseline could not be read
+    int compareBaseline(const char *filename, const std::vector<ScaleResult> &results, double threshold)
+    {
+        FILE *file = fopen(filename, "r");
+        if (!file)
+        {
+            fprintf(stderr, "orbitalsim_scalebench: could not open %s\n", filename);
+            return -1;
+        }
+
+        char line[512];
+        char mode[32], kernel[32];
+        int threadCount, asteroidCount;
+        double stepTime;
+        int regressionCount = 0;
+
+        while (fgets(line, sizeof(line), file))
+        {
+            if (sscanf(line, "%31[^,],%31[^,],%d,%d,%lf", mode, kernel, &threadCount, &asteroidCount, &stepTime) != 5)
+            {
+                continue;
+            }
+
+            for (size_t i = 0; i < results.size(); i++)
+            {
+                const ScaleResult &result = results[i];
+
+                if ((result.mode == mode) && (result.kernel == kernel) &&
+                    (result.threadCount == threadCount) && (result.asteroidCount == asteroidCount) &&
+                    (result.stepTime > stepTime * (1.0 + threshold)))
+                {
+                    fprintf(stderr, "REGRESSION %s %s %d threads %d asteroids: %.4f ms (baseline %.4f ms, +%.1f%%)\n",
+                            mode, kernel, threadCount, asteroidCount, result.stepTime, stepTime,
+                            100.0 * (result.stepTime / stepTime - 1.0));
+                    regressionCount++;
+                }
+            }
+        }
+
+        fclose(file);
+
+        return regressionCount;
+    }
+
+
+/* *****************************************************************
+    * MAIN LOGIC *
+   ***************************************************************** */
+
+    int main(int argc, char **argv)
+    {
+        int asteroidCount = SCALE_BENCH_ASTEROIDS;
+        int stepCount = SCALE_BENCH_STEPS;
+        int maxThreadCount = getHardwareThreadCount();
+        bool isJSON = false;
+        const char *baselineFilename = NULL;
+        double threshold = SCALE_BENCH_THRESHOLD;
+        SyntheticDistribution distribution = SYNTHETIC_DISTRIBUTION_NUM;
+        uint64_t seed = 1;
+
+        for (int i = 1; i < argc; i++)
+        {
+            if ((strcmp(argv[i], "--asteroids") == 0) && (i + 1 < argc))
+            {
+                asteroidCount = atoi(argv[++i]);
+            }
+
+            else if ((strcmp(argv[i], "--steps") == 0) && (i + 1 < argc))
+            {
+                stepCount = atoi(argv[++i]);
+            }
+
+            else if ((strcmp(argv[i], "--max-threads") == 0) && (i + 1 < argc))
+            {
+                maxThreadCount = atoi(argv[++i]);
+            }
+
+            else if (strcmp(argv[i], "--json") == 0)
+            {
+                isJSON = true;
+            }
+
+            else if ((strcmp(argv[i], "--baseline") == 0) && (i + 1 < argc))
+            {
+                baselineFilename = argv[++i];
+            }
+
+            else if ((strcmp(argv[i], "--threshold") == 0) && (i + 1 < argc))
+            {
+                threshold = atof(argv[++i]);
+            }
+
+            else if ((strcmp(argv[i], "--distribution") == 0) && (i + 1 < argc))
+            {
+                distribution = findSyntheticDistribution(argv[++i]);
+                if (distribution == SYNTHETIC_DISTRIBUTION_NUM)
+                {
+                    fprintf(stderr, "orbitalsim_scalebench: unknown distribution %s\n", argv[i]);
+                    return 1;
+                }
+            }
+
+            else if ((strcmp(argv[i], "--seed") == 0) && (i + 1 < argc))
+            {
+                seed = strtoull(argv[++i], NULL, 10);
+            }
+
+            else
+            {
+                fprintf(stderr, "usage: orbitalsim_scalebench [--asteroids n] [--steps n] [--max-threads n] "
+                                "[--json] [--baseline file.csv] [--threshold fraction] "
+                                "[--distribution kuiper|oort|disk|plummer|galaxy] [--seed n]\n");
+                return 1;
+            }
+        }
+
+        if ((asteroidCount <= 0) || (stepCount <= 0) || (maxThreadCount <= 0))
+        {
+            fprintf(stderr, "orbitalsim_scalebench: counts must be positive\n");
+            return 1;
+        }
+
+        // The simulation's worker pool has one thread per hardware thread
+        if (maxThreadCount > getHardwareThreadCount())
+        {
+            maxThreadCount = getHardwareThreadCount();
+        }
+
+        std::vector<ScaleResult> results;
+
+        if (!isJSON)
+        {
+            printCSVHeader();
+        }
+
+        for (int isWeak = 0; isWeak <= 1; isWeak++)
+        {
+            for (int kernel = 0; kernel < ASTEROID_KERNEL_NUM; kernel++)
+            {
+                double singleThreadTime = 0;
+
+                // Powers of two, then every hardware thread
+                for (int threadCount = 1; threadCount <= maxThreadCount;
+                    threadCount = ((threadCount * 2 > maxThreadCount) && (threadCount < maxThreadCount)) ?
+                                    maxThreadCount : threadCount * 2)
+                {
+                    ScaleResult result;
+                    result.mode = isWeak ? "weak" : "strong";
+                    result.kernel = kernelNames[kernel];
+
+                    runScaleBench((AsteroidKernel)kernel, threadCount, isWeak ? asteroidCount * threadCount : asteroidCount,
+                                    stepCount, distribution, seed, &result);
+
+                    if (threadCount == 1)
+                    {
+                        singleThreadTime = result.stepTime;
+                    }
+
+                    // Strong: T1 / (p * Tp). Weak: T1 / Tp, with p times the work in Tp
+                    result.efficiency = singleThreadTime / (result.stepTime * (isWeak ? 1 : threadCount));
+
+                    results.push_back(result);
+
+                    if (!isJSON)
+                    {
+                        printCSVResult(result);
+                        fflush(stdout);
+                    }
+                }
+            }
+        }
+
+        if (isJSON)
+        {
+            printJSONResults(results);
+        }
+
+        if (baselineFilename)
+        {
+            int regressionCount = compareBaseline(baselineFilename, results, threshold);
+
+            if (regressionCount != 0)
+            {
+                return (regressionCount < 0) ? 1 : 2;
+            }
+        }
+
+        return 0;
+    }
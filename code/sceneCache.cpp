@@ -0,0 +1,445 @@
+/* *****************************************************************
+    * FILE INFORMATION *
+   ***************************************************************** */
+
+/// @brief Retained scene decoration: the grid, the reference orbits of the significant bodies
+        // and the background stars are built into vertex buffers once and drawn with one call
+        // each, and the static HUD text is drawn once into a texture
+/// @author Marc S. Ressl, Ian A. Dib, Luciano S. Cordero
+/// @copyright Copyright (c) 2022-2023
+
+
+/* *****************************************************************
+    * FILE CONFIGURATION *
+   ***************************************************************** */
+
+    //* NECESSARY LIBRARIES
+
+    // Enables M_PI #define in Windows
+    #define _USE_MATH_DEFINES
+
+    #include <math.h>
+    #include <vector>
+
+    #include "raylib.h"
+    #include "raymath.h"
+    #include "rlgl.h"
+
+    // glDrawArrays, since rlgl only draws vertex arrays as triangles. On Windows, the GL header
+    // is included without windows.h (which clashes with raylib), as GLFW does
+    #if defined(_WIN32)
+        #ifndef APIENTRY
+        #define APIENTRY __stdcall
+        #endif
+        #ifndef WINGDIAPI
+        #define WINGDIAPI __declspec(dllimport)
+        #endif
+        #include <GL/gl.h>
+    #elif defined(__APPLE__)
+        #include <OpenGL/gl.h>
+    #elif defined(GRAPHICS_API_OPENGL_ES2)
+        #include <GLES2/gl2.h>
+    #else
+        #include <GL/gl.h>
+    #endif
+
+
+    //* NECESSARY HEADERS
+
+    #include "sceneCache.h"
+    #include "starCatalog.h"
+    #include "orbitalSim.h"
+    #include "skyPositions.h"
+
+
+    //* CONSTANTS
+
+    // DrawGrid colors: center lines darker than the rest
+    #define SCENE_GRID_CENTER_COLOR CLITERAL(Color){128, 128, 128, 255}
+    #define SCENE_GRID_COLOR CLITERAL(Color){191, 191, 191, 255}
+
+    // Reference orbits are dimmed copies of their body's color
+    #define SCENE_ORBIT_ALPHA 96
+
+    // Size of a magnitude 0 star, and of the dimmest ones [display units at SCENE_STAR_DISTANCE]
+    #define SCENE_STAR_SIZE 1.5F
+    #define SCENE_STAR_MIN_SIZE 0.6F
+
+
+    //* PRIVATE FUNCTIONS PROTOTYPES
+
+    static Model loadTriangleModel(const std::vector<Vector3> &vertices, const std::vector<Color> &colors);
+    static SceneLines loadSceneLines(const std::vector<Vector3> &vertices, const std::vector<Color> &colors);
+    static void bindSceneLines(const SceneLines *lines);
+    static void unloadSceneLines(SceneLines *lines);
+    static void addSceneLine(std::vector<Vector3> &vertices, std::vector<Color> &colors, Vector3 start, Vector3 end,
+                            Color color);
+    static bool buildSceneGrid(SceneCache *cache, int slices, float spacing);
+    static bool buildSceneStars(SceneCache *cache);
+
+
+/* *****************************************************************
+    * LOGIC MODULES *
+   ***************************************************************** */
+
+    //* MESHES
+
+    /// @brief Uploads a triangle list with per-vertex colors as a model
+    /// @param vertices Three per triangle
+    /// @param colors One per vertex
+    /// @return The model
+    static Model loadTriangleModel(const std::vector<Vector3> &vertices, const std::vector<Color> &colors)
+    {
+        Mesh mesh = {};
+        mesh.vertexCount = (int)vertices.size();
+        mesh.triangleCount = mesh.vertexCount / 3;
+
+        // Freed by UnloadModel
+        mesh.vertices = (float *)MemAlloc(mesh.vertexCount * 3 * sizeof(float));
+        mesh.colors = (unsigned char *)MemAlloc(mesh.vertexCount * 4 * sizeof(unsigned char));
+
+        for (int i = 0; i < mesh.vertexCount; i++)
+        {
+            mesh.vertices[3 * i] = vertices[i].x;
+            mesh.vertices[3 * i + 1] = vertices[i].y;
+            mesh.vertices[3 * i + 2] = vertices[i].z;
+
+            mesh.colors[4 * i] = colors[i].r;
+            mesh.colors[4 * i + 1] = colors[i].g;
+            mesh.colors[4 * i + 2] = colors[i].b;
+            mesh.colors[4 * i + 3] = colors[i].a;
+        }
+
+        UploadMesh(&mesh, false);
+
+        return LoadModelFromMesh(mesh);
+    }
+
+
+    /// @brief Uploads a line list with per-vertex colors
+    /// @param vertices Two per segment
+    /// @param colors One per vertex
+    /// @return The lines
+    static SceneLines loadSceneLines(const std::vector<Vector3> &vertices, const std::vector<Color> &colors)
+    {
+        SceneLines lines;
+        lines.vertexCount = (int)vertices.size();
+
+        // Vector3 and Color are tightly packed floats and bytes
+        lines.vaoId = rlLoadVertexArray();
+        rlEnableVertexArray(lines.vaoId);
+        lines.vboIds[0] = rlLoadVertexBuffer(vertices.data(), lines.vertexCount * sizeof(Vector3), false);
+        lines.vboIds[1] = rlLoadVertexBuffer(colors.data(), lines.vertexCount * sizeof(Color), false);
+        bindSceneLines(&lines);
+        rlDisableVertexArray();
+
+        return lines;
+    }
+
+
+    /// @brief Points the default shader's position and color attributes at the line buffers
+            // (recorded in the vertex array, where supported)
+    /// @param lines The lines
+    static void bindSceneLines(const SceneLines *lines)
+    {
+        rlEnableVertexBuffer(lines->vboIds[0]);
+        rlSetVertexAttribute(RL_DEFAULT_SHADER_ATTRIB_LOCATION_POSITION, 3, RL_FLOAT, false, 0, 0);
+        rlEnableVertexAttribute(RL_DEFAULT_SHADER_ATTRIB_LOCATION_POSITION);
+
+        rlEnableVertexBuffer(lines->vboIds[1]);
+        rlSetVertexAttribute(RL_DEFAULT_SHADER_ATTRIB_LOCATION_COLOR, 4, RL_UNSIGNED_BYTE, true, 0, 0);
+        rlEnableVertexAttribute(RL_DEFAULT_SHADER_ATTRIB_LOCATION_COLOR);
+
+        // Texture coordinates take their default value, which samples the white default texture
+        rlDisableVertexAttribute(RL_DEFAULT_SHADER_ATTRIB_LOCATION_TEXCOORD);
+        rlDisableVertexBuffer();
+    }
+
+
+    /// @brief Frees the buffers of some lines
+    /// @param lines The lines
+    static void unloadSceneLines(SceneLines *lines)
+    {
+        rlUnloadVertexArray(lines->vaoId);
+        rlUnloadVertexBuffer(lines->vboIds[0]);
+        rlUnloadVertexBuffer(lines->vboIds[1]);
+        lines->vertexCount = 0;
+    }
+
+
+    /// @brief Adds a line segment
+    static void addSceneLine(std::vector<Vector3> &vertices, std::vector<Color> &colors, Vector3 start, Vector3 end,
+                            Color color)
+    {
+        vertices.push_back(start);
+        vertices.push_back(end);
+
+        colors.insert(colors.end(), 2, color);
+    }
+
+
+    /// @brief Draws some lines with the default shader, each segment once, in one draw call.
+            // Must be called between BeginMode3D and EndMode3D
+    /// @param lines The lines
+    void drawSceneLines(const SceneLines *lines)
+    {
+        if (lines->vertexCount == 0)
+        {
+            return;
+        }
+
+        Matrix modelView = MatrixMultiply(rlGetMatrixTransform(), rlGetMatrixModelview());
+        float white[4] = {1.0F, 1.0F, 1.0F, 1.0F};
+        int *locations = rlGetShaderLocsDefault();
+
+        rlEnableShader(rlGetShaderIdDefault());
+        rlSetUniformMatrix(locations[RL_SHADER_LOC_MATRIX_MVP], MatrixMultiply(modelView, rlGetMatrixProjection()));
+        rlSetUniform(locations[RL_SHADER_LOC_COLOR_DIFFUSE], white, RL_SHADER_UNIFORM_VEC4, 1);
+        rlActiveTextureSlot(0);
+        rlEnableTexture(rlGetTextureIdDefault());
+
+        if (!rlEnableVertexArray(lines->vaoId))
+        {
+            bindSceneLines(lines);
+        }
+
+        glDrawArrays(GL_LINES, 0, lines->vertexCount);
+
+        rlDisableVertexArray();
+        rlDisableTexture();
+        rlDisableShader();
+    }
+
+
+    //* SCENE PARTS
+
+    /// @brief Builds the grid DrawGrid would draw
+    /// @param cache The scene cache
+    /// @param slices Lines per axis, minus one
+    /// @param spacing Distance between lines [display units]
+    /// @return Whether there is a grid
+    static bool buildSceneGrid(SceneCache *cache, int slices, float spacing)
+    {
+        std::vector<Vector3> vertices;
+        std::vector<Color> colors;
+        int halfSlices = slices / 2;
+        float halfSize = halfSlices * spacing;
+
+        for (int i = -halfSlices; i <= halfSlices; i++)
+        {
+            Color color = (i == 0) ? SCENE_GRID_CENTER_COLOR : SCENE_GRID_COLOR;
+
+            addSceneLine(vertices, colors, {i * spacing, 0, -halfSize}, {i * spacing, 0, halfSize}, color);
+            addSceneLine(vertices, colors, {-halfSize, 0, i * spacing}, {halfSize, 0, i * spacing}, color);
+        }
+
+        if (vertices.empty())
+        {
+            return false;
+        }
+
+        cache->grid = loadSceneLines(vertices, colors);
+
+        return true;
+    }
+
+
+    /// @brief Builds the background stars as small triangles on a sphere around the origin,
+            // larger and brighter the brighter the star
+    /// @param cache The scene cache
+    /// @return Whether a catalog was loaded
+    static bool buildSceneStars(SceneCache *cache)
+    {
+        std::vector<Star> stars;
+        if (!loadStarCatalog(SCENE_STAR_CATALOG_FILE, SCENE_STAR_MAGNITUDE_LIMIT, stars) || stars.empty())
+        {
+            return false;
+        }
+
+        std::vector<Vector3> vertices;
+        std::vector<Color> colors;
+        float cosObliquity = cosf(SKY_OBLIQUITY);
+        float sinObliquity = sinf(SKY_OBLIQUITY);
+
+        for (size_t i = 0; i < stars.size(); i++)
+        {
+            float cosDeclination = cosf(stars[i].declination);
+            float equatorialX = cosDeclination * cosf(stars[i].rightAscension);
+            float equatorialY = cosDeclination * sinf(stars[i].rightAscension);
+            float equatorialZ = sinf(stars[i].declination);
+
+            // Equatorial to ecliptic, then ecliptic (x, y, z) is simulation (x, z, y)
+            Vector3 direction = {equatorialX,
+                                -equatorialY * sinObliquity + equatorialZ * cosObliquity,
+                                equatorialY * cosObliquity + equatorialZ * sinObliquity};
+
+            // Two axes across the line of sight
+            Vector3 reference = (fabsf(direction.y) < 0.9F) ? Vector3{0, 1, 0} : Vector3{1, 0, 0};
+            Vector3 side = Vector3Normalize(Vector3CrossProduct(direction, reference));
+            Vector3 up = Vector3CrossProduct(side, direction);
+
+            // Brightness ratio of 100 every 5 magnitudes
+            float brightness = powf(10.0F, -0.4F * stars[i].magnitude);
+            float size = fmaxf(SCENE_STAR_SIZE * sqrtf(fminf(brightness, 1.0F)), SCENE_STAR_MIN_SIZE);
+            unsigned char level = (unsigned char)(255 * fminf(fmaxf(sqrtf(brightness), 0.3F), 1.0F));
+
+            Vector3 center = Vector3Scale(direction, SCENE_STAR_DISTANCE);
+            vertices.push_back(Vector3Add(center, Vector3Scale(up, size)));
+            vertices.push_back(Vector3Add(center, Vector3Scale(Vector3Add(Vector3Scale(up, -0.5F),
+                                                                        Vector3Scale(side, 0.866F)), size)));
+            vertices.push_back(Vector3Add(center, Vector3Scale(Vector3Add(Vector3Scale(up, -0.5F),
+                                                                        Vector3Scale(side, -0.866F)), size)));
+            colors.insert(colors.end(), 3, Color{level, level, level, 255});
+        }
+
+        cache->stars = loadTriangleModel(vertices, colors);
+        cache->starVertices = (int)vertices.size();
+
+        return true;
+    }
+
+
+    /// @brief Builds the reference orbits: the osculating Kepler ellipse of every significant
+            // body around the most massive one, at the given snapshot. Unbound bodies and moons,
+            // whose heliocentric ellipse is not their orbit, are skipped
+    /// @param cache The scene cache
+    /// @param snapshot A snapshot with significant bodies
+    void buildSceneOrbits(SceneCache *cache, Snapshot *snapshot)
+    {
+        if (cache->hasOrbits || (snapshot->bodyCount < 2))
+        {
+            return;
+        }
+
+        SnapshotBody *bodies = getSnapshotBodies(snapshot);
+        int centerIndex = 0;
+        for (int i = 1; i < snapshot->bodyCount; i++)
+        {
+            if (bodies[i].mass > bodies[centerIndex].mass)
+            {
+                centerIndex = i;
+            }
+        }
+
+        std::vector<Vector3> vertices;
+        std::vector<Color> colors;
+        double mu = GRAVITATIONAL_CONSTANT * (double)bodies[centerIndex].mass;
+
+        for (int i = snapshot->moonCount; i < snapshot->bodyCount; i++)
+        {
+            if (i == centerIndex)
+            {
+                continue;
+            }
+
+            // In meters, as the gravitational parameter
+            Vector3 r = Vector3Scale(Vector3Subtract(bodies[i].position, bodies[centerIndex].position),
+                                    1.0F / SCALE_FACTOR);
+            Vector3 v = Vector3Scale(Vector3Subtract(bodies[i].velocity, bodies[centerIndex].velocity),
+                                    1.0F / SCALE_FACTOR);
+            double distance = Vector3Length(r);
+            double energy = Vector3LengthSqr(v) / 2.0 - mu / distance;
+
+            if ((distance <= 0) || (energy >= 0))
+            {
+                continue;
+            }
+
+            // Semi-major axis, eccentricity vector and the axes of the orbital plane
+            double semiMajorAxis = -mu / (2.0 * energy);
+            Vector3 h = Vector3CrossProduct(r, v);
+            Vector3 e = Vector3Subtract(Vector3Scale(Vector3CrossProduct(v, h), (float)(1.0 / mu)),
+                                        Vector3Scale(r, (float)(1.0 / distance)));
+            double eccentricity = fmin(Vector3Length(e), 0.999);
+
+            Vector3 periapsisAxis = Vector3Normalize((eccentricity > 1E-6) ? e : r);
+            Vector3 normalAxis = Vector3CrossProduct(Vector3Normalize(h), periapsisAxis);
+
+            double scale = semiMajorAxis * SCALE_FACTOR;
+            double semiMinorScale = scale * sqrt(1.0 - eccentricity * eccentricity);
+            Vector3 center = Vector3Add(bodies[centerIndex].position,
+                                        Vector3Scale(periapsisAxis, (float)(-scale * eccentricity)));
+
+            Color color = bodies[i].color;
+            color.a = SCENE_ORBIT_ALPHA;
+
+            Vector3 previous = Vector3Add(center, Vector3Scale(periapsisAxis, (float)scale));
+            for (int k = 1; k <= SCENE_ORBIT_SEGMENTS; k++)
+            {
+                double anomaly = 2.0 * M_PI * k / SCENE_ORBIT_SEGMENTS;
+                Vector3 point = Vector3Add(center,
+                                        Vector3Add(Vector3Scale(periapsisAxis, (float)(scale * cos(anomaly))),
+                                                    Vector3Scale(normalAxis, (float)(semiMinorScale * sin(anomaly)))));
+
+                addSceneLine(vertices, colors, previous, point, color);
+                previous = point;
+            }
+        }
+
+        if (!vertices.empty())
+        {
+            cache->orbits = loadSceneLines(vertices, colors);
+        }
+
+        // Built once, even if every body was unbound
+        cache->hasOrbits = true;
+    }
+
+
+    //* SCENE CACHE MANAGEMENT
+
+    /// @brief Constructs the scene cache. Needs the window (the GL context) to be open
+    /// @param gridSlices Grid lines per axis, minus one
+    /// @param gridSpacing Distance between grid lines [display units]
+    /// @param width HUD width [pixels]
+    /// @param height HUD height [pixels]
+    /// @return The scene cache
+    SceneCache *constructSceneCache(int gridSlices, float gridSpacing, int width, int height)
+    {
+        SceneCache *cache = new SceneCache();
+
+        cache->hasGrid = buildSceneGrid(cache, gridSlices, gridSpacing);
+        cache->hasStars = buildSceneStars(cache);
+        cache->hasOrbits = false;
+        cache->orbits.vertexCount = 0;
+
+        cache->hud = LoadRenderTexture(width, height);
+        cache->hasHud = cache->hud.id > 0;
+
+        if (cache->hasHud)
+        {
+            BeginTextureMode(cache->hud);
+            ClearBackground(BLANK);
+            EndTextureMode();
+        }
+
+        return cache;
+    }
+
+
+    /// @brief Destroys a scene cache
+    /// @param cache The scene cache
+    void destroySceneCache(SceneCache *cache)
+    {
+        if (cache->hasGrid)
+        {
+            unloadSceneLines(&cache->grid);
+        }
+
+        if (cache->orbits.vertexCount > 0)
+        {
+            unloadSceneLines(&cache->orbits);
+        }
+
+        if (cache->hasStars)
+        {
+            UnloadModel(cache->stars);
+        }
+
+        if (cache->hasHud)
+        {
+            UnloadRenderTexture(cache->hud);
+        }
+
+        delete cache;
+    }
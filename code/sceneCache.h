@@ -0,0 +1,77 @@
+/* *****************************************************************
+    * FILE INFORMATION *
+   ***************************************************************** */
+
+/// @brief Retained scene decoration: the grid, the reference orbits of the significant bodies
+        // and the background stars are built into meshes once and drawn with one call each,
+        // and the static HUD text is drawn once into a texture
+/// @author Marc S. Ressl, Ian A. Dib, Luciano S. Cordero
+/// @copyright Copyright (c) 2022-2023
+
+
+/* *****************************************************************
+    * HEADER CONFIGURATION *
+   ***************************************************************** */
+
+    #ifndef SCENECACHE_H
+    #define SCENECACHE_H
+
+
+    //* NECESSARY LIBRARIES AND HEADERS
+
+    #include <raylib.h>
+    #include "snapshot.h"
+
+
+    //* CONFIGURATION
+
+    // Background star catalog, skipped if missing (see starCatalog.h for its format)
+    #define SCENE_STAR_CATALOG_FILE "stars.csv"
+    #define SCENE_STAR_MAGNITUDE_LIMIT 6.5F
+
+    // Radius of the star sphere around the camera, inside the far clipping plane [display units]
+    #define SCENE_STAR_DISTANCE 500.0F
+
+    // Segments of every reference orbit
+    #define SCENE_ORBIT_SEGMENTS 256
+
+
+    //* CONSTANTS & STRUCTURES
+
+    /// @brief Line segments uploaded once and drawn as GL_LINES
+    struct SceneLines
+    {
+        unsigned int vaoId;         // 0 where vertex arrays are not supported
+        unsigned int vboIds[2];     // Positions and colors
+        int vertexCount;            // Two per segment
+    };
+
+
+    /// @brief Retained scene decoration. Every part is drawn only if built: the stars need a
+            // catalog, and the orbits a snapshot
+    struct SceneCache
+    {
+        SceneLines grid;
+        bool hasGrid;
+
+        SceneLines orbits;          // Osculating Kepler ellipses at the first snapshot, no vertices if every body was unbound
+        bool hasOrbits;             // Built, once the first snapshot with bodies arrived
+
+        Model stars;
+        int starVertices;
+        bool hasStars;
+
+        RenderTexture2D hud;        // Static HUD text, drawn over every frame
+        bool hasHud;
+    };
+
+
+    //* PUBLIC FUNCTIONS PROTOTYPES
+
+    SceneCache *constructSceneCache(int gridSlices, float gridSpacing, int width, int height);
+    void destroySceneCache(SceneCache *cache);
+    void buildSceneOrbits(SceneCache *cache, Snapshot *snapshot);
+    void drawSceneLines(const SceneLines *lines);
+
+
+    #endif // SCENECACHE_H
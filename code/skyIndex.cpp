@@ -0,0 +1,264 @@
+/* *****************************************************************
+    * FILE INFORMATION *
+   ***************************************************************** */
+
+/// @brief Sky index of the asteroids for field-of-view queries.
+        // The sky is split into rings of equal declination height, and every ring into as many
+        // cells as fit its circumference, so cells are nearly square and of nearly equal area
+        // (as in HEALPix, without its exact equal-area ring boundaries). A cone query only visits
+        // the cells it overlaps and tests the asteroids in them
+/// @author Marc S. Ressl, Ian A. Dib, Luciano S. Cordero
+/// @copyright Copyright (c) 2022-2023
+
+
+/* *****************************************************************
+    * FILE CONFIGURATION *
+   ***************************************************************** */
+
+    //* NECESSARY LIBRARIES
+
+    // Enables M_PI #define in Windows
+    #define _USE_MATH_DEFINES
+
+    #include <math.h>
+    #include <vector>
+
+
+    //* NECESSARY HEADERS
+
+    #include "skyIndex.h"
+
+
+    //* STRUCTURES
+
+    struct SkyIndex
+    {
+        int ringCount;
+        float ringHeight;                       // [rad]
+        std::vector<int> ringCellCounts;
+        std::vector<int> ringFirstCells;        // Index of every ring's first cell
+
+        std::vector<std::vector<int>> cells;    // Asteroids in every cell
+        std::vector<int> asteroidCells;         // Cell of every asteroid, -1 if not indexed yet
+        std::vector<int> asteroidSlots;         // Position of every asteroid in its cell
+        std::vector<int> nextCells;             // Cells computed by the last update
+        std::vector<Vector3> directions;        // Unit vector of every asteroid (x to RA 0, z to the pole)
+    };
+
+
+    /// @brief Arguments of the parallel cell update
+    struct SkyIndexContext
+    {
+        SkyIndex *index;
+        SkyPositions *sky;
+    };
+
+
+    //* PRIVATE FUNCTIONS PROTOTYPES
+
+    static int findSkyIndexCell(SkyIndex *index, float rightAscension, float declination);
+    static void updateSkyIndexChunk(void *context, int startIndex, int endIndex);
+    static void moveSkyIndexAsteroid(SkyIndex *index, int asteroid, int cell);
+
+
+/* *****************************************************************
+    * LOGIC MODULES *
+   ***************************************************************** */
+
+    //* CELLS
+
+    /// @brief Finds the cell a direction falls in
+    /// @param index The sky index
+    /// @param rightAscension [rad], in [0, 2 pi)
+    /// @param declination [rad]
+    /// @return The cell
+    static int findSkyIndexCell(SkyIndex *index, float rightAscension, float declination)
+    {
+        int ring = (int)((declination + 0.5F * (float)M_PI) / index->ringHeight);
+        ring = (ring < 0) ? 0 : ((ring >= index->ringCount) ? index->ringCount - 1 : ring);
+
+        int cellCount = index->ringCellCounts[ring];
+        int cell = (int)(rightAscension * (0.5F / (float)M_PI) * cellCount);
+        cell = (cell < 0) ? 0 : ((cell >= cellCount) ? cellCount - 1 : cell);
+
+        return index->ringFirstCells[ring] + cell;
+    }
+
+
+    /// @brief Worker task: finds the cell and direction of one chunk of asteroids
+    /// @param context A SkyIndexContext
+    /// @param startIndex Starting index of the chunk
+    /// @param endIndex Ending index (exclusive) of the chunk
+    static void updateSkyIndexChunk(void *context, int startIndex, int endIndex)
+    {
+        SkyIndexContext *update = (SkyIndexContext *)context;
+        SkyIndex *index = update->index;
+
+        for (int i = startIndex; i < endIndex; i++)
+        {
+            SkyPosition *position = &update->sky->positions[i];
+            float cosDeclination = cosf(position->declination);
+
+            index->directions[i] = {cosDeclination * cosf(position->rightAscension),
+                                    cosDeclination * sinf(position->rightAscension),
+                                    sinf(position->declination)};
+            index->nextCells[i] = findSkyIndexCell(index, position->rightAscension, position->declination);
+        }
+    }
+
+
+    /// @brief Moves an asteroid to another cell. The last asteroid of its old cell takes its slot
+    /// @param index The sky index
+    /// @param asteroid The asteroid
+    /// @param cell Its new cell
+    static void moveSkyIndexAsteroid(SkyIndex *index, int asteroid, int cell)
+    {
+        int oldCell = index->asteroidCells[asteroid];
+
+        if (oldCell >= 0)
+        {
+            std::vector<int> &oldAsteroids = index->cells[oldCell];
+            int slot = index->asteroidSlots[asteroid];
+            int last = oldAsteroids.back();
+
+            oldAsteroids[slot] = last;
+            index->asteroidSlots[last] = slot;
+            oldAsteroids.pop_back();
+        }
+
+        index->asteroidCells[asteroid] = cell;
+        index->asteroidSlots[asteroid] = (int)index->cells[cell].size();
+        index->cells[cell].push_back(asteroid);
+    }
+
+
+    //* SKY INDEX MANAGEMENT
+
+    /// @brief Constructs an empty sky index
+    /// @param ringCount Rings of declination
+    /// @return The sky index
+    SkyIndex *constructSkyIndex(int ringCount)
+    {
+        SkyIndex *index = new SkyIndex;
+        index->ringCount = (ringCount > 0) ? ringCount : 1;
+        index->ringHeight = (float)M_PI / index->ringCount;
+
+        int cellCount = 0;
+        for (int ring = 0; ring < index->ringCount; ring++)
+        {
+            // As many cells as ring heights fit along the ring's middle
+            float declination = (ring + 0.5F) * index->ringHeight - 0.5F * (float)M_PI;
+            int ringCellCount = (int)lroundf(2.0F * index->ringCount * cosf(declination));
+
+            index->ringCellCounts.push_back((ringCellCount > 0) ? ringCellCount : 1);
+            index->ringFirstCells.push_back(cellCount);
+            cellCount += index->ringCellCounts.back();
+        }
+
+        index->cells.resize(cellCount);
+
+        return index;
+    }
+
+
+    /// @brief Destroys a sky index
+    /// @param index The sky index
+    void destroySkyIndex(SkyIndex *index)
+    {
+        delete index;
+    }
+
+
+    /// @brief Brings the index up to date with new sky positions. Cells are found on the worker
+            // pool; only the asteroids whose cell changed are then moved
+    /// @param index The sky index
+    /// @param sky Sky positions, just updated
+    /// @param sim The orbital simulation the positions belong to
+    void updateSkyIndex(SkyIndex *index, SkyPositions *sky, OrbitalSim *sim)
+    {
+        if ((int)index->asteroidCells.size() < sky->count)
+        {
+            index->asteroidCells.resize(sky->count, -1);
+            index->asteroidSlots.resize(sky->count);
+            index->nextCells.resize(sky->count);
+            index->directions.resize(sky->count);
+        }
+
+        SkyIndexContext update;
+        update.index = index;
+        update.sky = sky;
+
+        runWorkerPool(sim->workers, sim->tuning.threadCount, sky->count, sim->tuning.chunkSize,
+                        updateSkyIndexChunk, &update, NULL);
+
+        for (int i = 0; i < sky->count; i++)
+        {
+            if (index->nextCells[i] != index->asteroidCells[i])
+            {
+                moveSkyIndexAsteroid(index, i, index->nextCells[i]);
+            }
+        }
+    }
+
+
+    /// @brief Finds the asteroids within a cone
+    /// @param index The sky index
+    /// @param rightAscension Center of the field of view [rad]
+    /// @param declination Center of the field of view [rad]
+    /// @param radius Radius of the field of view [rad]
+    /// @param asteroids Destination of the asteroid indices (cleared first)
+    /// @return Number of asteroids found
+    int querySkyIndex(SkyIndex *index, float rightAscension, float declination, float radius,
+                        std::vector<int> &asteroids)
+    {
+        asteroids.clear();
+
+        float halfPi = 0.5F * (float)M_PI;
+        float cosDeclination = cosf(declination);
+        Vector3 center = {cosDeclination * cosf(rightAscension), cosDeclination * sinf(rightAscension),
+                            sinf(declination)};
+
+        // Chord length test: unlike the dot product against cos(radius), it keeps its precision
+        // for fields of a few arcminutes
+        float chord = 2.0F * sinf(0.5F * fminf(radius, (float)M_PI));
+        float chordSqr = chord * chord;
+
+        float minDeclination = declination - radius;
+        float maxDeclination = declination + radius;
+        bool hasPole = (minDeclination <= -halfPi) || (maxDeclination >= halfPi);
+
+        // Half width of the cone in right ascension, the same at every declination it spans
+        float halfWidth = hasPole ? (float)M_PI : asinf(fminf(sinf(radius) / cosDeclination, 1.0F));
+
+        int firstRing = (int)((fmaxf(minDeclination, -halfPi) + halfPi) / index->ringHeight);
+        int lastRing = (int)((fminf(maxDeclination, halfPi) + halfPi) / index->ringHeight);
+        firstRing = (firstRing < 0) ? 0 : firstRing;
+        lastRing = (lastRing >= index->ringCount) ? index->ringCount - 1 : lastRing;
+
+        for (int ring = firstRing; ring <= lastRing; ring++)
+        {
+            int cellCount = index->ringCellCounts[ring];
+            int firstCell = (int)floorf((rightAscension - halfWidth) * (0.5F / (float)M_PI) * cellCount);
+            int lastCell = (int)floorf((rightAscension + halfWidth) * (0.5F / (float)M_PI) * cellCount);
+            int spannedCount = (lastCell - firstCell + 1 < cellCount) ? lastCell - firstCell + 1 : cellCount;
+
+            for (int i = 0; i < spannedCount; i++)
+            {
+                // Wraps around right ascension 0
+                int cell = ((firstCell + i) % cellCount + cellCount) % cellCount;
+                const std::vector<int> &cellAsteroids = index->cells[index->ringFirstCells[ring] + cell];
+
+                for (size_t j = 0; j < cellAsteroids.size(); j++)
+                {
+                    int asteroid = cellAsteroids[j];
+
+                    if (Vector3DistanceSqr(index->directions[asteroid], center) <= chordSqr)
+                    {
+                        asteroids.push_back(asteroid);
+                    }
+                }
+            }
+        }
+
+        return (int)asteroids.size();
+    }
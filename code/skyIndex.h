@@ -0,0 +1,52 @@
+/* *****************************************************************
+    * FILE INFORMATION *
+   ***************************************************************** */
+
+/// @brief Sky index of the asteroids for field-of-view queries: an iso-latitude grid of rings
+        // split into cells of nearly equal area, kept up to date by moving only the asteroids
+        // that changed cell since the last observation
+/// @author Marc S. Ressl, Ian A. Dib, Luciano S. Cordero
+/// @copyright Copyright (c) 2022-2023
+
+
+/* *****************************************************************
+    * HEADER CONFIGURATION *
+   ***************************************************************** */
+
+    #ifndef SKYINDEX_H
+    #define SKYINDEX_H
+
+
+    //* NECESSARY LIBRARIES
+
+    #include <vector>
+
+
+    //* NECESSARY HEADERS
+
+    #include "orbitalSim.h"
+    #include "skyPositions.h"
+
+
+    //* CONFIGURATION
+
+    // Rings of declination: 180 rings make cells of about 1 x 1 degrees
+    #define SKY_INDEX_RINGS 180
+
+
+    //* STRUCTURES
+
+    /// @brief Sky index. Opaque: the cell lists (C++ containers) stay inside skyIndex.cpp
+    struct SkyIndex;
+
+
+    //* PUBLIC FUNCTIONS PROTOTYPES
+
+    SkyIndex *constructSkyIndex(int ringCount = SKY_INDEX_RINGS);
+    void destroySkyIndex(SkyIndex *index);
+    void updateSkyIndex(SkyIndex *index, SkyPositions *sky, OrbitalSim *sim);
+    int querySkyIndex(SkyIndex *index, float rightAscension, float declination, float radius,
+                        std::vector<int> &asteroids);
+
+
+    #endif // SKYINDEX_H
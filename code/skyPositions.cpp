@@ -0,0 +1,271 @@
+/* *****************************************************************
+    * FILE INFORMATION *
+   ***************************************************************** */
+
+/// @brief Sky positions of the asteroids as seen from an observer body.
+        // Simulation vectors are ecliptic J2000 with the y and z axes swapped (y is the ecliptic
+        // pole), so a vector is first taken to ecliptic (x, z, y) and then rotated about x by the
+        // obliquity to the equator
+/// @author Marc S. Ressl, Ian A. Dib, Luciano S. Cordero
+/// @copyright Copyright (c) 2022-2023
+
+
+/* *****************************************************************
+    * FILE CONFIGURATION *
+   ***************************************************************** */
+
+    //* NECESSARY LIBRARIES
+
+    // Enables M_PI #define in Windows
+    #define _USE_MATH_DEFINES
+
+    #include <stdio.h>
+    #include <string.h>
+    #include <math.h>
+
+
+    //* NECESSARY HEADERS
+
+    #include "skyPositions.h"
+    #include "metrics.h"
+
+
+    //* STRUCTURES
+
+    // Asteroids gathered per block of the sky positions loop
+    #define SKY_BLOCK_SIZE 64
+
+
+    /// @brief Arguments of the parallel sky positions update
+    struct SkyPositionsContext
+    {
+        SkyPositions *sky;
+        OrbitalSim *sim;
+    };
+
+
+    //* PRIVATE FUNCTIONS PROTOTYPES
+
+    static inline float fastAtan2(float y, float x);
+    static inline SkyPosition projectOnSky(Vector3 position, Vector3 velocity, Vector3 observerPosition,
+                                            Vector3 illuminatorPosition);
+    static int findSignificantBody(OrbitalSim *sim, const char *name);
+    static void updateSkyPositionsChunk(void *context, int startIndex, int endIndex);
+
+
+/* *****************************************************************
+    * LOGIC MODULES *
+   ***************************************************************** */
+
+    //* SKY GEOMETRY
+
+    /// @brief Branch-free atan2 (Cephes atanf reduction and polynomial, about 1 ulp). Unlike the
+            // libm call, its selects if-convert, so the asteroid block loop vectorizes through it
+    /// @param y Ordinate
+    /// @param x Abscissa
+    /// @return Angle of (x, y) in [-pi, pi] [rad], 0 for the origin
+    static inline float fastAtan2(float y, float x)
+    {
+        float absX = fabsf(x);
+        float absY = fabsf(y);
+
+        // atan(q), q = |y / x|, from atan(t) with |t| <= tan(pi / 8)
+        bool isSteep = absY > 2.414213562F * absX;          // q > tan(3 pi / 8): t = -1 / q
+        bool isMiddle = absY > 0.414213562F * absX;         // q > tan(pi / 8): t = (q - 1) / (q + 1)
+        float numerator = isSteep ? -absX : (isMiddle ? absY - absX : absY);
+        float denominator = isSteep ? absY : (isMiddle ? absY + absX : absX);
+        float offset = isSteep ? 0.5F * (float)M_PI : (isMiddle ? 0.25F * (float)M_PI : 0);
+
+        // Only the origin has a zero denominator, and its numerator is zero too
+        float t = numerator / ((denominator > 0) ? denominator : 1.0F);
+        float z = t * t;
+        float angle = offset + ((((8.05374449538E-2F * z - 1.38776856032E-1F) * z + 1.99777106478E-1F) * z -
+                                3.33329491539E-1F) * z * t + t);
+
+        angle = (x < 0) ? (float)M_PI - angle : angle;
+
+        return (y < 0) ? -angle : angle;
+    }
+
+
+    /// @brief Computes the apparent direction of a body
+    /// @param position Position of the body [m]
+    /// @param velocity Velocity of the body, for the light-time correction [m/s]
+    /// @param observerPosition Position of the observer [m]
+    /// @param illuminatorPosition Position of the body lighting it [m]
+    /// @return Its sky position
+    static inline SkyPosition projectOnSky(Vector3 position, Vector3 velocity, Vector3 observerPosition,
+                                            Vector3 illuminatorPosition)
+    {
+        Vector3 lineOfSight = Vector3Subtract(position, observerPosition);
+        float distance = Vector3Length(lineOfSight);
+
+        // One iteration is enough: the body moves a few thousand kilometers while light crosses the belt
+        if (SKY_LIGHT_TIME_CORRECTION)
+        {
+            position = Vector3Subtract(position, Vector3Scale(velocity, distance / SPEED_OF_LIGHT));
+            lineOfSight = Vector3Subtract(position, observerPosition);
+            distance = Vector3Length(lineOfSight);
+        }
+
+        // Simulation (x, y, z) is ecliptic (x, z, y)
+        float eclipticX = lineOfSight.x;
+        float eclipticY = lineOfSight.z;
+        float eclipticZ = lineOfSight.y;
+
+        float cosObliquity = cosf(SKY_OBLIQUITY);
+        float sinObliquity = sinf(SKY_OBLIQUITY);
+        float equatorialX = eclipticX;
+        float equatorialY = eclipticY * cosObliquity - eclipticZ * sinObliquity;
+        float equatorialZ = eclipticY * sinObliquity + eclipticZ * cosObliquity;
+
+        SkyPosition sky;
+        float rightAscension = fastAtan2(equatorialY, equatorialX);
+        sky.rightAscension = (rightAscension < 0) ? rightAscension + 2.0F * (float)M_PI : rightAscension;
+        sky.declination = fastAtan2(equatorialZ, sqrtf(equatorialX * equatorialX + equatorialY * equatorialY));
+        sky.distance = distance;
+
+        // atan2 keeps its precision near 0 and pi, unlike acos. Unit vectors, since the cross
+        // product of two distances squares past the float range
+        Vector3 toIlluminator = Vector3Subtract(illuminatorPosition, position);
+        toIlluminator = Vector3Scale(toIlluminator, 1.0F / Vector3Length(toIlluminator));
+        Vector3 toObserver = Vector3Scale(lineOfSight, -1.0F / distance);
+        sky.phaseAngle = fastAtan2(Vector3Length(Vector3CrossProduct(toIlluminator, toObserver)),
+                                Vector3DotProduct(toIlluminator, toObserver));
+
+        return sky;
+    }
+
+
+    /// @brief Computes the apparent direction of a body
+    /// @param position Position of the body [m]
+    /// @param velocity Velocity of the body, for the light-time correction [m/s]
+    /// @param observerPosition Position of the observer [m]
+    /// @param illuminatorPosition Position of the body lighting it [m]
+    /// @return Its sky position
+    SkyPosition calculateSkyPosition(Vector3 position, Vector3 velocity, Vector3 observerPosition,
+                                    Vector3 illuminatorPosition)
+    {
+        return projectOnSky(position, velocity, observerPosition, illuminatorPosition);
+    }
+
+
+    /// @brief Finds a significant body by name
+    /// @param sim The orbital simulation
+    /// @param name Name of the body
+    /// @return Its index, or -1 if there is none
+    static int findSignificantBody(OrbitalSim *sim, const char *name)
+    {
+        for (int i = 0; i < sim->bodyCount; i++)
+        {
+            if (strcmp(sim->bodies[i].name, name) == 0)
+            {
+                return i;
+            }
+        }
+
+        return -1;
+    }
+
+
+    /// @brief Worker task: computes the sky positions of one chunk of asteroids
+    /// @param context A SkyPositionsContext
+    /// @param startIndex Starting index of the chunk
+    /// @param endIndex Ending index (exclusive) of the chunk
+    static void updateSkyPositionsChunk(void *context, int startIndex, int endIndex)
+    {
+        SkyPositionsContext *update = (SkyPositionsContext *)context;
+        SkyPositions *sky = update->sky;
+        OrbitalSim *sim = update->sim;
+        Vector3 observerPosition = sim->bodies[sky->observerIndex].position;
+        Vector3 illuminatorPosition = sim->bodies[sky->illuminatorIndex].position;
+
+        // GCC does not vectorize loads from the interleaved Asteroid array, so each block is first
+        // gathered into separate coordinate arrays. The projection loop then vectorizes at -O3 with
+        // -fno-math-errno and -fno-trapping-math (see CMakeLists.txt), but not under the sanitizers
+        float block[6][SKY_BLOCK_SIZE];
+
+        for (int blockStart = startIndex; blockStart < endIndex; blockStart += SKY_BLOCK_SIZE)
+        {
+            int blockEnd = (blockStart + SKY_BLOCK_SIZE < endIndex) ? blockStart + SKY_BLOCK_SIZE : endIndex;
+            int blockCount = blockEnd - blockStart;
+            Asteroid *asteroids = sim->asteroids + blockStart;
+            SkyPosition *positions = sky->positions + blockStart;
+
+            for (int i = 0; i < blockCount; i++)
+            {
+                block[0][i] = asteroids[i].position.x;
+                block[1][i] = asteroids[i].position.y;
+                block[2][i] = asteroids[i].position.z;
+                block[3][i] = asteroids[i].velocity.x;
+                block[4][i] = asteroids[i].velocity.y;
+                block[5][i] = asteroids[i].velocity.z;
+            }
+
+            for (int i = 0; i < blockCount; i++)
+            {
+                Vector3 position = {block[0][i], block[1][i], block[2][i]};
+                Vector3 velocity = {block[3][i], block[4][i], block[5][i]};
+                positions[i] = projectOnSky(position, velocity, observerPosition, illuminatorPosition);
+            }
+        }
+    }
+
+
+    //* SKY POSITIONS MANAGEMENT
+
+    /// @brief Constructs the sky positions of a simulation's asteroids
+    /// @param sim The orbital simulation
+    /// @return The sky positions, or NULL if the simulation has no SKY_OBSERVER or SKY_ILLUMINATOR
+    SkyPositions *constructSkyPositions(OrbitalSim *sim)
+    {
+        int observerIndex = findSignificantBody(sim, SKY_OBSERVER);
+        int illuminatorIndex = findSignificantBody(sim, SKY_ILLUMINATOR);
+
+        if ((observerIndex < 0) || (illuminatorIndex < 0))
+        {
+            fprintf(stderr, "skyPositions: the simulation has no %s or %s\n", SKY_OBSERVER, SKY_ILLUMINATOR);
+            return NULL;
+        }
+
+        SkyPositions *sky = new SkyPositions;
+        sky->observerIndex = observerIndex;
+        sky->illuminatorIndex = illuminatorIndex;
+        sky->time = 0;
+        sky->count = 0;
+        sky->capacity = sim->asteroidCapacity;
+        sky->positions = new SkyPosition[sky->capacity];
+        sky->schedule = constructWorkerSchedule();
+
+        return sky;
+    }
+
+
+    /// @brief Destroys sky positions
+    /// @param sky The sky positions
+    void destroySkyPositions(SkyPositions *sky)
+    {
+        destroyWorkerSchedule(sky->schedule);
+        delete[] sky->positions;
+        delete sky;
+    }
+
+
+    /// @brief Computes the sky positions of every asteroid taking part, with the threads and
+            // chunks of the asteroid step
+    /// @param sky The sky positions
+    /// @param sim The orbital simulation
+    void updateSkyPositions(SkyPositions *sky, OrbitalSim *sim)
+    {
+        SkyPositionsContext update;
+        update.sky = sky;
+        update.sim = sim;
+
+        uint64_t phaseStart = getMetricsTime();
+        runWorkerPool(sim->workers, sim->tuning.threadCount, sim->asteroidCount, sim->tuning.chunkSize,
+                        updateSkyPositionsChunk, &update, sky->schedule);
+        recordMetricsPhase(METRICS_PHASE_SKY_POSITIONS, phaseStart);
+
+        sky->time = sim->time;
+        sky->count = sim->asteroidCount;
+    }
@@ -0,0 +1,71 @@
+/* *****************************************************************
+    * FILE INFORMATION *
+   ***************************************************************** */
+
+/// @brief Sky positions of the asteroids as seen from an observer body: geocentric right
+        // ascension and declination, distance and phase angle, computed on the worker pool
+/// @author Marc S. Ressl, Ian A. Dib, Luciano S. Cordero
+/// @copyright Copyright (c) 2022-2023
+
+
+/* *****************************************************************
+    * HEADER CONFIGURATION *
+   ***************************************************************** */
+
+    #ifndef SKYPOSITIONS_H
+    #define SKYPOSITIONS_H
+
+
+    //* NECESSARY HEADERS
+
+    #include "orbitalSim.h"
+
+
+    //* CONFIGURATION
+
+    // Significant body the sky is seen from, and the one lighting the asteroids
+    #define SKY_OBSERVER "Tierra"
+    #define SKY_ILLUMINATOR "Sol"
+
+    // Move every asteroid back to where it was when the observed light left it
+    #define SKY_LIGHT_TIME_CORRECTION 1
+
+
+    //* CONSTANTS & STRUCTURES
+
+    #define SPEED_OF_LIGHT 299792458.0F         // [m/s]
+    #define SKY_OBLIQUITY 0.40909262F           // J2000 obliquity of the ecliptic, 23.4393 degrees [rad]
+
+    /// @brief Apparent direction of an asteroid, referred to the J2000 equator
+    struct SkyPosition
+    {
+        float rightAscension;       // [rad], in [0, 2 pi)
+        float declination;          // [rad]
+        float distance;             // From the observer [m]
+        float phaseAngle;           // Illuminator-asteroid-observer angle [rad]
+    };
+
+
+    /// @brief Sky positions of every asteroid at one time
+    struct SkyPositions
+    {
+        int observerIndex;          // Significant body indices
+        int illuminatorIndex;
+        float time;                 // Simulation time of the positions [s]
+        int count;                  // Asteroids with a position
+        int capacity;
+        SkyPosition *positions;     // Indexed like sim->asteroids
+        WorkerSchedule *schedule;
+    };
+
+
+    //* PUBLIC FUNCTIONS PROTOTYPES
+
+    SkyPositions *constructSkyPositions(OrbitalSim *sim);
+    void destroySkyPositions(SkyPositions *sky);
+    void updateSkyPositions(SkyPositions *sky, OrbitalSim *sim);
+    SkyPosition calculateSkyPosition(Vector3 position, Vector3 velocity, Vector3 observerPosition,
+                                    Vector3 illuminatorPosition);
+
+
+    #endif // SKYPOSITIONS_H
@@ -0,0 +1,367 @@
+/* *****************************************************************
+    * FILE INFORMATION *
+   ***************************************************************** */
+
+/// @brief Quantized snapshots of an orbital simulation, for render and IPC consumers
+/// @author Marc S. Ressl, Ian A. Dib, Luciano S. Cordero
+/// @copyright Copyright (c) 2022-2023
+
+
+/* *****************************************************************
+    * FILE CONFIGURATION *
+   ***************************************************************** */
+
+    //* NECESSARY LIBRARIES
+
+    #include <string.h>
+    #include <float.h>
+    #include <math.h>
+
+    #include "raymath.h"
+
+
+    //* NECESSARY HEADERS
+
+    #include "snapshot.h"
+
+
+    //* CONSTANTS
+
+    // Every section of the snapshot buffer starts at a multiple of this alignment
+    #define SNAPSHOT_ALIGNMENT 8
+
+    // Smallest quantization step, which keeps the inverse finite for flat bounding boxes
+    #define SNAPSHOT_MIN_QUANTUM 1E-12F
+
+
+    //* PRIVATE FUNCTIONS PROTOTYPES
+
+    static uint32_t alignSnapshotOffset(uint32_t offset);
+    static uint32_t getBodiesOffset();
+    static uint32_t getGroupsOffset(int bodyCount);
+    static uint32_t getPositionsOffset(int bodyCount, int groupCount);
+    static uint32_t getVelocitiesOffset(int bodyCount, int groupCount, int asteroidCount);
+    static void copySnapshotName(char *destination, const char *source);
+    static void packSnapshotGroup(Snapshot *snapshot, SnapshotGroup *snapshotGroup, OrbitalSim *sim);
+
+
+/* *****************************************************************
+    * LOGIC MODULES *
+   ***************************************************************** */
+
+    //* SNAPSHOT LAYOUT
+
+    /// @brief Rounds an offset up to the snapshot alignment
+    /// @param offset Offset in bytes
+    /// @return The aligned offset
+    static uint32_t alignSnapshotOffset(uint32_t offset)
+    {
+        return (offset + SNAPSHOT_ALIGNMENT - 1) & ~(uint32_t)(SNAPSHOT_ALIGNMENT - 1);
+    }
+
+    static uint32_t getBodiesOffset()
+    {
+        return alignSnapshotOffset(sizeof(Snapshot));
+    }
+
+    static uint32_t getGroupsOffset(int bodyCount)
+    {
+        return alignSnapshotOffset(getBodiesOffset() + bodyCount * sizeof(SnapshotBody));
+    }
+
+    static uint32_t getPositionsOffset(int bodyCount, int groupCount)
+    {
+        return alignSnapshotOffset(getGroupsOffset(bodyCount) + groupCount * sizeof(SnapshotGroup));
+    }
+
+    static uint32_t getVelocitiesOffset(int bodyCount, int groupCount, int asteroidCount)
+    {
+        return alignSnapshotOffset(getPositionsOffset(bodyCount, groupCount)
+                                    + 3 * asteroidCount * sizeof(SnapshotCoordinate));
+    }
+
+
+    /// @brief Calculates the size of a snapshot buffer
+    /// @param bodyCount Number of significant bodies
+    /// @param groupCount Number of asteroid groups
+    /// @param asteroidCount Number of asteroids
+    /// @return The size in bytes
+    uint32_t getSnapshotSize(int bodyCount, int groupCount, int asteroidCount)
+    {
+        return alignSnapshotOffset(getVelocitiesOffset(bodyCount, groupCount, asteroidCount)
+                                    + 3 * asteroidCount * sizeof(SnapshotCoordinate));
+    }
+
+
+    SnapshotBody *getSnapshotBodies(Snapshot *snapshot)
+    {
+        return (SnapshotBody *)((unsigned char *)snapshot + getBodiesOffset());
+    }
+
+    SnapshotGroup *getSnapshotGroups(Snapshot *snapshot)
+    {
+        return (SnapshotGroup *)((unsigned char *)snapshot + getGroupsOffset(snapshot->bodyCount));
+    }
+
+    SnapshotCoordinate *getSnapshotPositions(Snapshot *snapshot)
+    {
+        return (SnapshotCoordinate *)((unsigned char *)snapshot
+                    + getPositionsOffset(snapshot->bodyCount, snapshot->groupCount));
+    }
+
+    SnapshotCoordinate *getSnapshotVelocities(Snapshot *snapshot)
+    {
+        return (SnapshotCoordinate *)((unsigned char *)snapshot
+                    + getVelocitiesOffset(snapshot->bodyCount, snapshot->groupCount,
+                                            snapshot->asteroidCount));
+    }
+
+
+    //* SNAPSHOT PACKING
+
+    /// @brief Copies a name, truncating it to the snapshot name length
+    /// @param destination Snapshot name field
+    /// @param source Name to copy
+    static void copySnapshotName(char *destination, const char *source)
+    {
+        strncpy(destination, source, SNAPSHOT_NAME_LENGTH - 1);
+        destination[SNAPSHOT_NAME_LENGTH - 1] = '\0';
+    }
+
+
+    /// @brief Rounds a coordinate to the nearest integer, clamped to the coordinate range.
+            // The clamp is done in float, where SNAPSHOT_COORDINATE_MAX is exact, so rounding
+            // at the box edges (or a NaN) never casts out of range
+    /// @param value Coordinate in quanta
+    /// @return The quantized coordinate
+    static inline SnapshotCoordinate quantizeSnapshotCoordinate(float value)
+    {
+        return (SnapshotCoordinate)fminf(fmaxf(floorf(value + 0.5F), -SNAPSHOT_COORDINATE_MAX),
+                                        SNAPSHOT_COORDINATE_MAX);
+    }
+
+
+    /// @brief Quantizes the asteroids of a group relative to the group's bounding box
+    /// @param snapshot The snapshot
+    /// @param snapshotGroup The group, with its startIndex and count already set
+    /// @param sim The orbital simulation
+    static void packSnapshotGroup(Snapshot *snapshot, SnapshotGroup *snapshotGroup, OrbitalSim *sim)
+    {
+        Asteroid *asteroids = sim->asteroids + snapshotGroup->startIndex;
+        int count = snapshotGroup->count;
+
+        if (count == 0)
+        {
+            snapshotGroup->origin = {0, 0, 0};
+            snapshotGroup->positionQuantum = {0, 0, 0};
+            snapshotGroup->velocityQuantum = {0, 0, 0};
+            return;
+        }
+
+        SnapshotCoordinate *positions = getSnapshotPositions(snapshot) + 3 * snapshotGroup->startIndex;
+        SnapshotCoordinate *velocities = getSnapshotVelocities(snapshot) + 3 * snapshotGroup->startIndex;
+
+        // Unquantized: display units as they are, through the same unpacking
+        if (!SNAPSHOT_QUANTIZED)
+        {
+            snapshotGroup->origin = {0, 0, 0};
+            snapshotGroup->positionQuantum = {1, 1, 1};
+            snapshotGroup->velocityQuantum = {1, 1, 1};
+
+            for (int i = 0; i < count; i++)
+            {
+                positions[3 * i] = asteroids[i].position.x * SCALE_FACTOR;
+                positions[3 * i + 1] = asteroids[i].position.y * SCALE_FACTOR;
+                positions[3 * i + 2] = asteroids[i].position.z * SCALE_FACTOR;
+
+                velocities[3 * i] = asteroids[i].velocity.x * SCALE_FACTOR;
+                velocities[3 * i + 1] = asteroids[i].velocity.y * SCALE_FACTOR;
+                velocities[3 * i + 2] = asteroids[i].velocity.z * SCALE_FACTOR;
+            }
+
+            return;
+        }
+
+        // Bounding box of the group and largest velocity component.
+        // Branch-free min/max loops, so the compiler can vectorize them
+        Vector3 minPosition = {FLT_MAX, FLT_MAX, FLT_MAX};
+        Vector3 maxPosition = {-FLT_MAX, -FLT_MAX, -FLT_MAX};
+        Vector3 maxVelocity = {0, 0, 0};
+
+        for (int i = 0; i < count; i++)
+        {
+            Vector3 position = asteroids[i].position;
+            Vector3 velocity = asteroids[i].velocity;
+
+            minPosition = Vector3Min(minPosition, position);
+            maxPosition = Vector3Max(maxPosition, position);
+            maxVelocity = Vector3Max(maxVelocity, {fabsf(velocity.x), fabsf(velocity.y),
+                                                    fabsf(velocity.z)});
+        }
+
+        // The quanta are premultiplied by the scale factor, so unpacking gives display units.
+        // One step of margin absorbs rounding at the box edges
+        Vector3 halfExtent = Vector3Scale(Vector3Subtract(maxPosition, minPosition), 0.5F * SCALE_FACTOR);
+        float positionScale = 1.0F / (SNAPSHOT_COORDINATE_MAX - 1.0F);
+        float velocityScale = SCALE_FACTOR / (SNAPSHOT_COORDINATE_MAX - 1.0F);
+
+        Vector3 origin = Vector3Scale(Vector3Add(minPosition, maxPosition), 0.5F * SCALE_FACTOR);
+        Vector3 positionQuantum = {fmaxf(halfExtent.x * positionScale, SNAPSHOT_MIN_QUANTUM),
+                                    fmaxf(halfExtent.y * positionScale, SNAPSHOT_MIN_QUANTUM),
+                                    fmaxf(halfExtent.z * positionScale, SNAPSHOT_MIN_QUANTUM)};
+        Vector3 velocityQuantum = {fmaxf(maxVelocity.x * velocityScale, SNAPSHOT_MIN_QUANTUM),
+                                    fmaxf(maxVelocity.y * velocityScale, SNAPSHOT_MIN_QUANTUM),
+                                    fmaxf(maxVelocity.z * velocityScale, SNAPSHOT_MIN_QUANTUM)};
+
+        snapshotGroup->origin = origin;
+        snapshotGroup->positionQuantum = positionQuantum;
+        snapshotGroup->velocityQuantum = velocityQuantum;
+
+        // Quantization: q = round((x * SCALE_FACTOR - origin) / quantum)
+        Vector3 positionFactor = {SCALE_FACTOR / positionQuantum.x, SCALE_FACTOR / positionQuantum.y,
+                                    SCALE_FACTOR / positionQuantum.z};
+        Vector3 positionOffset = {origin.x / positionQuantum.x, origin.y / positionQuantum.y,
+                                    origin.z / positionQuantum.z};
+        Vector3 velocityFactor = {SCALE_FACTOR / velocityQuantum.x, SCALE_FACTOR / velocityQuantum.y,
+                                    SCALE_FACTOR / velocityQuantum.z};
+
+        for (int i = 0; i < count; i++)
+        {
+            Vector3 position = asteroids[i].position;
+            Vector3 velocity = asteroids[i].velocity;
+
+            positions[3 * i] = quantizeSnapshotCoordinate(position.x * positionFactor.x - positionOffset.x);
+            positions[3 * i + 1] = quantizeSnapshotCoordinate(position.y * positionFactor.y - positionOffset.y);
+            positions[3 * i + 2] = quantizeSnapshotCoordinate(position.z * positionFactor.z - positionOffset.z);
+
+            velocities[3 * i] = quantizeSnapshotCoordinate(velocity.x * velocityFactor.x);
+            velocities[3 * i + 1] = quantizeSnapshotCoordinate(velocity.y * velocityFactor.y);
+            velocities[3 * i + 2] = quantizeSnapshotCoordinate(velocity.z * velocityFactor.z);
+        }
+    }
+
+
+    /// @brief Constructs a snapshot buffer sized for an orbital simulation
+    /// @param sim The orbital simulation
+    /// @return The snapshot (empty until packed)
+    Snapshot *constructSnapshot(OrbitalSim *sim)
+    {
+        // Sized for every asteroid, including those still being generated
+        uint32_t size = getSnapshotSize(sim->bodyCount, ASTEROID_GROUPNUM, sim->asteroidCapacity);
+
+        Snapshot *snapshot = (Snapshot *)new unsigned char[size]();
+        snapshot->size = size;
+        snapshot->time = 0.0F;
+        snapshot->bodyCount = sim->bodyCount;
+        snapshot->moonCount = sim->moonCount;
+        snapshot->groupCount = ASTEROID_GROUPNUM;
+        snapshot->asteroidCount = sim->asteroidCapacity;
+
+        return snapshot;
+    }
+
+
+    /// @brief Destroys a snapshot
+    /// @param snapshot The snapshot
+    void destroySnapshot(Snapshot *snapshot)
+    {
+        delete[] (unsigned char *)snapshot;
+    }
+
+
+    /// @brief Packs the current state of an orbital simulation into a snapshot
+    /// @param snapshot A snapshot constructed for the simulation
+    /// @param sim The orbital simulation
+    void packSnapshot(Snapshot *snapshot, OrbitalSim *sim)
+    {
+        snapshot->time = sim->time;
+
+        SnapshotBody *bodies = getSnapshotBodies(snapshot);
+
+        for (int i = 0; i < snapshot->bodyCount; i++)
+        {
+            copySnapshotName(bodies[i].name, sim->bodies[i].name);
+            bodies[i].mass = sim->bodies[i].mass;
+            bodies[i].radius = sim->bodies[i].radius;
+            bodies[i].color = sim->bodies[i].color;
+            bodies[i].position = Vector3Scale(sim->bodies[i].position, SCALE_FACTOR);
+            bodies[i].velocity = Vector3Scale(sim->bodies[i].velocity, SCALE_FACTOR);
+        }
+
+        SnapshotGroup *groups = getSnapshotGroups(snapshot);
+
+        for (int i = 0; i < snapshot->groupCount; i++)
+        {
+            AsteroidGroup *group = &sim->asteroidGroups[i];
+
+            copySnapshotName(groups[i].name, group->name);
+            groups[i].mass = group->mass;
+            groups[i].radius = group->radius;
+            groups[i].color = group->color;
+            groups[i].startIndex = group->startIndex;
+            groups[i].count = group->count;
+
+            packSnapshotGroup(snapshot, &groups[i], sim);
+        }
+    }
+
+
+    //* SNAPSHOT UNPACKING
+
+    /// @brief Gets the position of a snapshot asteroid
+    /// @param snapshot The snapshot
+    /// @param group The group the asteroid belongs to
+    /// @param index Index of the asteroid
+    /// @return Position [display units]
+    Vector3 unpackSnapshotPosition(Snapshot *snapshot, SnapshotGroup *group, int index)
+    {
+        SnapshotCoordinate *position = getSnapshotPositions(snapshot) + 3 * index;
+
+        return {group->origin.x + position[0] * group->positionQuantum.x,
+                group->origin.y + position[1] * group->positionQuantum.y,
+                group->origin.z + position[2] * group->positionQuantum.z};
+    }
+
+
+    /// @brief Gets the velocity of a snapshot asteroid
+    /// @param snapshot The snapshot
+    /// @param group The group the asteroid belongs to
+    /// @param index Index of the asteroid
+    /// @return Velocity [display units/s]
+    Vector3 unpackSnapshotVelocity(Snapshot *snapshot, SnapshotGroup *group, int index)
+    {
+        SnapshotCoordinate *velocity = getSnapshotVelocities(snapshot) + 3 * index;
+
+        return {velocity[0] * group->velocityQuantum.x,
+                velocity[1] * group->velocityQuantum.y,
+                velocity[2] * group->velocityQuantum.z};
+    }
+
+
+    /// @brief Finds the group an asteroid belongs to
+    /// @param snapshot The snapshot
+    /// @param index Index of the asteroid
+    /// @return Its group, or NULL if the slot is not in use
+    SnapshotGroup *findSnapshotGroup(Snapshot *snapshot, int index)
+    {
+        SnapshotGroup *groups = getSnapshotGroups(snapshot);
+
+        for (int i = 0; i < snapshot->groupCount; i++)
+        {
+            if ((index >= groups[i].startIndex) && (index < groups[i].startIndex + groups[i].count))
+            {
+                return &groups[i];
+            }
+        }
+
+        return NULL;
+    }
+
+
+    /// @brief Radius a body is drawn with, from the recommended empirical formula
+    /// @param radius Physical radius [m]
+    /// @return Visual radius [display units]
+    float getSnapshotVisualRadius(float radius)
+    {
+        return 0.005F * logf(radius);
+    }
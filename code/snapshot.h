@@ -0,0 +1,115 @@
+/* *****************************************************************
+    * FILE INFORMATION *
+   ***************************************************************** */
+
+/// @brief Quantized snapshots of an orbital simulation, for render and IPC consumers
+/// @author Marc S. Ressl, Ian A. Dib, Luciano S. Cordero
+/// @copyright Copyright (c) 2022-2023
+
+
+/* *****************************************************************
+    * HEADER CONFIGURATION *
+   ***************************************************************** */
+
+    #ifndef SNAPSHOT_H
+    #define SNAPSHOT_H
+
+
+    //* NECESSARY LIBRARIES AND HEADERS
+
+    #include <stdint.h>
+    #include <float.h>
+
+    #include <raylib.h>
+    #include "orbitalSim.h"
+
+
+    //* CONFIGURATION
+
+    // Scale factor for converting astronomical distances to screen coordinates
+    #define SCALE_FACTOR 1E-11F
+
+    // Asteroid coordinates quantized as offsets from their group's cell, which cuts snapshot
+    // copies 3 to 6 times. With 0 they are stored as floats in display units instead
+    #define SNAPSHOT_QUANTIZED 1
+
+    // Bits of each quantized asteroid coordinate (16 or 32)
+    #define SNAPSHOT_COORDINATE_BITS 16
+
+    // Maximum length of the names stored in a snapshot, terminator included
+    #define SNAPSHOT_NAME_LENGTH 32
+
+
+    //* CONSTANTS & STRUCTURES
+
+    #if !SNAPSHOT_QUANTIZED
+    typedef float SnapshotCoordinate;
+    #define SNAPSHOT_COORDINATE_MAX FLT_MAX
+    #elif SNAPSHOT_COORDINATE_BITS == 32
+    typedef int32_t SnapshotCoordinate;
+    #define SNAPSHOT_COORDINATE_MAX 2147483520.0F   // Largest float below 2^31
+    #else
+    typedef int16_t SnapshotCoordinate;
+    #define SNAPSHOT_COORDINATE_MAX 32767.0F
+    #endif
+
+    /// @brief Significant body as stored in a snapshot (full precision, few of them)
+    struct SnapshotBody
+    {
+        char name[SNAPSHOT_NAME_LENGTH];
+        float mass;                 // [kg]
+        float radius;               // [m]
+        Color color;                // Raylib color
+        Vector3 position;           // [display units]
+        Vector3 velocity;           // [display units/s]
+    };
+
+
+    /// @brief Asteroid group as stored in a snapshot. Each group is a quantization cell:
+            // its asteroids are stored as offsets from the cell origin
+    struct SnapshotGroup
+    {
+        char name[SNAPSHOT_NAME_LENGTH];
+        float mass;                 // [kg]
+        float radius;               // [m]
+        Color color;                // Raylib color
+        int startIndex;             // First asteroid of the group
+        int count;                  // Number of asteroids in the group
+        Vector3 origin;             // Cell center [display units]
+        Vector3 positionQuantum;    // Position step per coordinate unit [display units]
+        Vector3 velocityQuantum;    // Velocity step per coordinate unit [display units/s]
+    };
+
+
+    /// @brief Snapshot header. A snapshot is a single flat buffer (so it can be copied
+            // to other threads or processes as is) laid out as: header, bodies, groups,
+            // asteroid positions and asteroid velocities (3 coordinates per asteroid)
+    struct Snapshot
+    {
+        uint32_t size;              // Total size of the buffer [bytes]
+        float time;                 // Simulation time [s]
+        int bodyCount;
+        int moonCount;              // Bodies [0, moonCount) are moons
+        int groupCount;
+        int asteroidCount;          // Asteroid slots, the groups tell how many are in use
+    };
+
+
+    //* PUBLIC FUNCTIONS PROTOTYPES
+
+    uint32_t getSnapshotSize(int bodyCount, int groupCount, int asteroidCount);
+    Snapshot *constructSnapshot(OrbitalSim *sim);
+    void destroySnapshot(Snapshot *snapshot);
+    void packSnapshot(Snapshot *snapshot, OrbitalSim *sim);
+
+    SnapshotBody *getSnapshotBodies(Snapshot *snapshot);
+    SnapshotGroup *getSnapshotGroups(Snapshot *snapshot);
+    SnapshotCoordinate *getSnapshotPositions(Snapshot *snapshot);
+    SnapshotCoordinate *getSnapshotVelocities(Snapshot *snapshot);
+    Vector3 unpackSnapshotPosition(Snapshot *snapshot, SnapshotGroup *group, int index);
+    Vector3 unpackSnapshotVelocity(Snapshot *snapshot, SnapshotGroup *group, int index);
+    SnapshotGroup *findSnapshotGroup(Snapshot *snapshot, int index);
+    float getSnapshotVisualRadius(float radius);
+
+
+    #endif // SNAPSHOT_H
@@ -0,0 +1,365 @@
+/* *****************************************************************
+    * FILE INFORMATION *
+   ***************************************************************** */
+
+/// @brief Shared-memory ring of snapshots, published by a headless engine and read by viewers
+/// @author Marc S. Ressl, Ian A. Dib, Luciano S. Cordero
+/// @copyright Copyright (c) 2022-2023
+
+
+/* *****************************************************************
+    * FILE CONFIGURATION *
+   ***************************************************************** */
+
+    //* NECESSARY LIBRARIES
+
+    #include <errno.h>
+    #include <signal.h>
+    #include <stdio.h>
+    #include <string.h>
+    #include <new>
+
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+
+
+    //* NECESSARY HEADERS
+
+    #include "snapshotRing.h"
+
+
+    //* CONSTANTS
+
+    // Changes with the layout of the ring header or of the snapshots, so engines and viewers
+    // of different versions never share a ring
+    #define SNAPSHOT_RING_MAGIC 0x4F524232 // "ORB2"
+
+    // Slots start at a cache line boundary
+    #define SNAPSHOT_RING_ALIGNMENT 64
+
+    // Attempts to read a consistent slot before giving up for this frame
+    #define SNAPSHOT_RING_READ_ATTEMPTS 4
+
+    // Waits for another engine to finish writing the header of the ring it is creating
+    #define SNAPSHOT_RING_CREATE_ATTEMPTS 20
+    #define SNAPSHOT_RING_CREATE_WAIT 50000 // [us]
+
+
+    //* STRUCTURES
+
+    /// @brief What an engine finds when the ring already exists
+    enum SnapshotRingState
+    {
+        SNAPSHOT_RING_MISSING,      // Unlinked since, create it again
+        SNAPSHOT_RING_UNWRITTEN,    // No valid header yet: its engine may still be creating it
+        SNAPSHOT_RING_IN_USE,       // Its engine is running, or it cannot be read
+        SNAPSHOT_RING_STALE         // Left by an engine that is gone
+    };
+
+
+    //* PRIVATE FUNCTIONS PROTOTYPES
+
+    static size_t getSlotsOffset();
+    static SnapshotRingState getSnapshotRingState();
+
+
+/* *****************************************************************
+    * LOGIC MODULES *
+   ***************************************************************** */
+
+    //* RING MANAGEMENT
+
+    static size_t getSlotsOffset()
+    {
+        return (sizeof(SnapshotRingHeader) + SNAPSHOT_RING_ALIGNMENT - 1) & ~(size_t)(SNAPSHOT_RING_ALIGNMENT - 1);
+    }
+
+
+    /// @brief Checks who owns the existing ring. Only a valid header whose engine is gone is
+            // stale: a ring without one may belong to an engine that is still creating it
+    /// @return The state of the ring
+    static SnapshotRingState getSnapshotRingState()
+    {
+        int fd = shm_open(SNAPSHOT_RING_NAME, O_RDONLY, 0);
+        if (fd < 0)
+        {
+            return (errno == ENOENT) ? SNAPSHOT_RING_MISSING : SNAPSHOT_RING_IN_USE;
+        }
+
+        struct stat status;
+        SnapshotRingState state = SNAPSHOT_RING_UNWRITTEN;
+
+        if ((fstat(fd, &status) == 0) && ((size_t)status.st_size >= sizeof(SnapshotRingHeader)))
+        {
+            void *mapping = mmap(NULL, sizeof(SnapshotRingHeader), PROT_READ, MAP_SHARED, fd, 0);
+
+            if (mapping == MAP_FAILED)
+            {
+                state = SNAPSHOT_RING_IN_USE;
+            }
+
+            else
+            {
+                const SnapshotRingHeader *header = (const SnapshotRingHeader *)mapping;
+
+                // Signal 0 only checks that the process exists
+                if (header->magic == SNAPSHOT_RING_MAGIC)
+                {
+                    bool isWriterAlive = (header->writerPid > 0) &&
+                                         ((kill((pid_t)header->writerPid, 0) == 0) || (errno == EPERM));
+
+                    if (isWriterAlive)
+                    {
+                        fprintf(stderr, "snapshotRing: engine %d is already publishing %s\n",
+                                (int)header->writerPid, SNAPSHOT_RING_NAME);
+                    }
+
+                    state = isWriterAlive ? SNAPSHOT_RING_IN_USE : SNAPSHOT_RING_STALE;
+                }
+
+                munmap(mapping, sizeof(SnapshotRingHeader));
+            }
+        }
+
+        close(fd);
+
+        return state;
+    }
+
+
+    /// @brief Creates the shared-memory ring, replacing a stale one left by a crashed engine.
+            // A ring whose engine is still running is left alone, and one without a valid
+            // header is waited on, since its engine may still be writing it
+    /// @param slotSize Size of each slot, at least the size of the published snapshots [bytes]
+    /// @return The ring, or NULL if another engine is publishing or the object could not be created
+    SnapshotRing *createSnapshotRing(uint32_t slotSize)
+    {
+        slotSize = (slotSize + SNAPSHOT_RING_ALIGNMENT - 1) & ~(uint32_t)(SNAPSHOT_RING_ALIGNMENT - 1);
+        size_t mappingSize = getSlotsOffset() + (size_t)slotSize * SNAPSHOT_RING_SLOTS;
+
+        int fd = -1;
+        SnapshotRingState state = SNAPSHOT_RING_MISSING;
+
+        for (int attempt = 0; (attempt < SNAPSHOT_RING_CREATE_ATTEMPTS) && (fd < 0); attempt++)
+        {
+            fd = shm_open(SNAPSHOT_RING_NAME, O_CREAT | O_EXCL | O_RDWR, 0600);
+            if ((fd >= 0) || (errno != EEXIST))
+            {
+                break;
+            }
+
+            state = getSnapshotRingState();
+
+            if (state == SNAPSHOT_RING_IN_USE)
+            {
+                return NULL;
+            }
+
+            else if (state == SNAPSHOT_RING_STALE)
+            {
+                shm_unlink(SNAPSHOT_RING_NAME);
+            }
+
+            else if (state == SNAPSHOT_RING_UNWRITTEN)
+            {
+                usleep(SNAPSHOT_RING_CREATE_WAIT);
+            }
+        }
+
+        if (fd < 0)
+        {
+            if (state == SNAPSHOT_RING_UNWRITTEN)
+            {
+                fprintf(stderr, "snapshotRing: %s has no valid header, remove it if no engine is starting\n",
+                        SNAPSHOT_RING_NAME);
+            }
+
+            return NULL;
+        }
+
+        if (ftruncate(fd, (off_t)mappingSize) != 0)
+        {
+            close(fd);
+            shm_unlink(SNAPSHOT_RING_NAME);
+            return NULL;
+        }
+
+        void *mapping = mmap(NULL, mappingSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+
+        if (mapping == MAP_FAILED)
+        {
+            shm_unlink(SNAPSHOT_RING_NAME);
+            return NULL;
+        }
+
+        SnapshotRing *ring = new SnapshotRing;
+        ring->header = new (mapping) SnapshotRingHeader;
+        ring->slots = (unsigned char *)mapping + getSlotsOffset();
+        ring->mappingSize = mappingSize;
+        ring->isOwner = true;
+
+        ring->header->writerPid = (int32_t)getpid();
+        ring->header->slotCount = SNAPSHOT_RING_SLOTS;
+        ring->header->slotSize = slotSize;
+        ring->header->publishCount.store(0);
+
+        for (int i = 0; i < SNAPSHOT_RING_SLOTS; i++)
+        {
+            ring->header->slotSequences[i].store(0);
+        }
+
+        // Readers check the magic last, once the rest of the header is valid
+        std::atomic_thread_fence(std::memory_order_release);
+        ring->header->magic = SNAPSHOT_RING_MAGIC;
+
+        return ring;
+    }
+
+
+    /// @brief Attaches to the ring of a running engine (read only)
+    /// @return The ring, or NULL if no engine is publishing
+    SnapshotRing *attachSnapshotRing()
+    {
+        int fd = shm_open(SNAPSHOT_RING_NAME, O_RDONLY, 0);
+        if (fd < 0)
+        {
+            return NULL;
+        }
+
+        struct stat status;
+        if ((fstat(fd, &status) != 0) || ((size_t)status.st_size < getSlotsOffset()))
+        {
+            close(fd);
+            return NULL;
+        }
+
+        size_t mappingSize = (size_t)status.st_size;
+        void *mapping = mmap(NULL, mappingSize, PROT_READ, MAP_SHARED, fd, 0);
+        close(fd);
+
+        if (mapping == MAP_FAILED)
+        {
+            return NULL;
+        }
+
+        SnapshotRingHeader *header = (SnapshotRingHeader *)mapping;
+
+        if ((header->magic != SNAPSHOT_RING_MAGIC) || (header->slotCount != SNAPSHOT_RING_SLOTS) ||
+            (getSlotsOffset() + (size_t)header->slotSize * header->slotCount > mappingSize))
+        {
+            munmap(mapping, mappingSize);
+            return NULL;
+        }
+
+        SnapshotRing *ring = new SnapshotRing;
+        ring->header = header;
+        ring->slots = (unsigned char *)mapping + getSlotsOffset();
+        ring->mappingSize = mappingSize;
+        ring->isOwner = false;
+
+        return ring;
+    }
+
+
+    /// @brief Unmaps a ring. The owner also removes the shared-memory object
+    /// @param ring The ring
+    void destroySnapshotRing(SnapshotRing *ring)
+    {
+        munmap(ring->header, ring->mappingSize);
+
+        if (ring->isOwner)
+        {
+            shm_unlink(SNAPSHOT_RING_NAME);
+        }
+
+        delete ring;
+    }
+
+
+    //* PUBLISHING AND READING
+
+    /// @brief Publishes a snapshot. Never waits for readers
+    /// @param ring A ring created by this process
+    /// @param snapshot The snapshot, no larger than the ring slots
+    void publishSnapshot(SnapshotRing *ring, Snapshot *snapshot)
+    {
+        SnapshotRingHeader *header = ring->header;
+
+        if (snapshot->size > header->slotSize)
+        {
+            return;
+        }
+
+        uint64_t publishCount = header->publishCount.load(std::memory_order_relaxed);
+        uint32_t slot = (uint32_t)(publishCount % header->slotCount);
+        std::atomic<uint32_t> *sequence = &header->slotSequences[slot];
+
+        // Seqlock: odd sequence while the slot is being written
+        sequence->fetch_add(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        memcpy(ring->slots + (size_t)slot * header->slotSize, snapshot, snapshot->size);
+
+        sequence->fetch_add(1, std::memory_order_release);
+        header->publishCount.store(publishCount + 1, std::memory_order_release);
+    }
+
+
+    /// @brief Gets the number of snapshots published so far, which readers can use to detect
+            // a stalled or restarted engine
+    /// @param ring The ring
+    /// @return Number of published snapshots
+    uint64_t getSnapshotRingPublishCount(SnapshotRing *ring)
+    {
+        return ring->header->publishCount.load(std::memory_order_acquire);
+    }
+
+
+    /// @brief Copies the latest published snapshot
+    /// @param ring The ring
+    /// @param snapshot Destination buffer
+    /// @param capacity Size of the destination buffer [bytes]
+    /// @return Whether a consistent snapshot was copied
+    bool readLatestSnapshot(SnapshotRing *ring, Snapshot *snapshot, uint32_t capacity)
+    {
+        SnapshotRingHeader *header = ring->header;
+
+        if (header->slotSize > capacity)
+        {
+            return false;
+        }
+
+        for (int attempt = 0; attempt < SNAPSHOT_RING_READ_ATTEMPTS; attempt++)
+        {
+            uint64_t publishCount = header->publishCount.load(std::memory_order_acquire);
+            if (publishCount == 0)
+            {
+                return false;
+            }
+
+            uint32_t slot = (uint32_t)((publishCount - 1) % header->slotCount);
+            std::atomic<uint32_t> *sequence = &header->slotSequences[slot];
+
+            uint32_t sequenceBefore = sequence->load(std::memory_order_acquire);
+            if (sequenceBefore & 1)
+            {
+                continue;
+            }
+
+            memcpy(snapshot, ring->slots + (size_t)slot * header->slotSize, header->slotSize);
+
+            std::atomic_thread_fence(std::memory_order_acquire);
+            uint32_t sequenceAfter = sequence->load(std::memory_order_relaxed);
+
+            // The writer lapped the ring while copying: try again with the newest slot
+            if ((sequenceBefore == sequenceAfter) && (snapshot->size <= header->slotSize))
+            {
+                return true;
+            }
+        }
+
+        return false;
+    }
@@ -0,0 +1,70 @@
+/* *****************************************************************
+    * FILE INFORMATION *
+   ***************************************************************** */
+
+/// @brief Shared-memory ring of snapshots, published by a headless engine and read by viewers
+/// @author Marc S. Ressl, Ian A. Dib, Luciano S. Cordero
+/// @copyright Copyright (c) 2022-2023
+
+
+/* *****************************************************************
+    * HEADER CONFIGURATION *
+   ***************************************************************** */
+
+    #ifndef SNAPSHOTRING_H
+    #define SNAPSHOTRING_H
+
+
+    //* NECESSARY LIBRARIES AND HEADERS
+
+    #include <stddef.h>
+    #include <stdint.h>
+    #include <atomic>
+
+    #include "snapshot.h"
+
+
+    //* CONFIGURATION
+
+    // POSIX shared-memory object name
+    #define SNAPSHOT_RING_NAME "/orbitalsim-snapshots"
+
+    // Number of snapshot slots: the writer never waits, so readers get this much slack
+    #define SNAPSHOT_RING_SLOTS 4
+
+
+    //* CONSTANTS & STRUCTURES
+
+    /// @brief Ring header, at the start of the shared-memory object
+    struct SnapshotRingHeader
+    {
+        uint32_t magic;
+        int32_t writerPid;                                      // Engine that publishes
+        uint32_t slotCount;
+        uint32_t slotSize;                                      // [bytes]
+        std::atomic<uint64_t> publishCount;                     // Snapshots published so far
+        std::atomic<uint32_t> slotSequences[SNAPSHOT_RING_SLOTS]; // Odd while a slot is written
+    };
+
+
+    /// @brief Process-local handle of a mapped ring
+    struct SnapshotRing
+    {
+        SnapshotRingHeader *header;
+        unsigned char *slots;
+        size_t mappingSize;         // [bytes]
+        bool isOwner;               // The owner creates and unlinks the shared-memory object
+    };
+
+
+    //* PUBLIC FUNCTIONS PROTOTYPES
+
+    SnapshotRing *createSnapshotRing(uint32_t slotSize);
+    SnapshotRing *attachSnapshotRing();
+    void destroySnapshotRing(SnapshotRing *ring);
+    void publishSnapshot(SnapshotRing *ring, Snapshot *snapshot);
+    uint64_t getSnapshotRingPublishCount(SnapshotRing *ring);
+    bool readLatestSnapshot(SnapshotRing *ring, Snapshot *snapshot, uint32_t capacity);
+
+
+    #endif // SNAPSHOTRING_H
@@ -0,0 +1,751 @@
+/* *****************************************************************
+    * FILE INFORMATION *
+   ***************************************************************** */
+
+/// @brief Bounding volume hierarchy over the bodies of a snapshot (a linear BVH).
+        // Bodies are sorted along a Morton curve with a radix sort, and every node splits its
+        // range where the highest bit of the Morton codes changes, so the tree is rebuilt in
+        // linear time. Every node covers a contiguous range of the sorted bodies, so a node
+        // that falls entirely inside the frustum is emitted without visiting it. Periodic rebuilds
+        // run on a background thread, over a copy of the bodies, while every snapshot refits the
+        // current tree; the new tree takes over once it is done
+/// @author Marc S. Ressl, Ian A. Dib, Luciano S. Cordero
+/// @copyright Copyright (c) 2022-2023
+
+
+/* *****************************************************************
+    * FILE CONFIGURATION *
+   ***************************************************************** */
+
+    //* NECESSARY LIBRARIES
+
+    #include <stdint.h>
+    #include <float.h>
+    #include <math.h>
+    #include <atomic>
+    #include <thread>
+    #include <utility>
+    #include <vector>
+
+    #include "raymath.h"
+
+
+    //* NECESSARY HEADERS
+
+    #include "snapshotTree.h"
+
+
+    //* CONSTANTS
+
+    // Bits of every Morton coordinate, and of the radix sort digits
+    #define MORTON_BITS 10
+    #define RADIX_BITS 10
+
+    // Deeper than any tree: every split takes one Morton bit, or halves a range of equal codes
+    #define SNAPSHOT_TREE_STACK_SIZE 128
+
+    #define FRUSTUM_PLANES 6
+
+
+    //* STRUCTURES
+
+    /// @brief Node of the tree. The left child follows its parent
+    struct SnapshotTreeNode
+    {
+        Vector3 min;                // Bounds of the body spheres [display units]
+        Vector3 max;
+        int first;                  // Range of sorted bodies covered
+        int count;
+        int right;                  // Right child, -1 for leaves
+    };
+
+
+    /// @brief A built tree, with the buffers that built it
+    struct SnapshotTreeData
+    {
+        // Bodies the tree was built for
+        int bodyCount;
+        std::vector<int> groupRanges;           // Start and count of every group
+
+        std::vector<SnapshotTreeNode> nodes;
+        std::vector<uint32_t> codes;            // Morton code of every sorted body
+        std::vector<int> items;                 // Item of every sorted body
+        std::vector<Vector3> positions;         // [display units]
+        std::vector<float> radii;               // Visual radius [display units]
+
+        // Build buffers, in snapshot order
+        std::vector<int> order;
+        std::vector<int> nextOrder;
+        std::vector<uint32_t> nextCodes;
+        std::vector<int> unsortedItems;
+        std::vector<Vector3> unsortedPositions;
+        std::vector<float> unsortedRadii;
+    };
+
+
+    struct SnapshotTree
+    {
+        // Snapshot the current tree was updated to
+        bool isBuilt;
+        float time;
+        int refitCount;                         // Refits since the last rebuild started
+        std::vector<int> groupRanges;           // Of the snapshot being updated to, reused
+
+        SnapshotTreeData current;               // Culling and picking use this one only
+
+        // Background rebuild, into next
+        SnapshotTreeData next;
+        std::thread builder;
+        bool isRebuilding;
+        std::atomic<bool> isRebuilt;
+    };
+
+
+    //* PRIVATE FUNCTIONS PROTOTYPES
+
+    static uint32_t spreadMortonBits(uint32_t value);
+    static void sortSnapshotTreeCodes(SnapshotTreeData *tree);
+    static int findSnapshotTreeSplit(SnapshotTreeData *tree, int first, int end);
+    static int buildSnapshotTreeNode(SnapshotTreeData *tree, int first, int end);
+    static void fitSnapshotTreeNodes(SnapshotTreeData *tree);
+    static void gatherSnapshotTreeBodies(SnapshotTreeData *tree, Snapshot *snapshot, const std::vector<int> &groupRanges);
+    static void buildSnapshotTreeData(SnapshotTreeData *tree);
+    static void runSnapshotTreeBuilder(SnapshotTree *tree);
+    static void refitSnapshotTree(SnapshotTreeData *tree, Snapshot *snapshot);
+    static void getFrustumPlanes(Matrix viewProjection, Vector4 *planes);
+
+
+/* *****************************************************************
+    * LOGIC MODULES *
+   ***************************************************************** */
+
+    //* CONSTRUCTION
+
+    /// @brief Spreads the low MORTON_BITS bits of a value two bits apart
+    /// @param value The value
+    /// @return The spread bits
+    static uint32_t spreadMortonBits(uint32_t value)
+    {
+        value &= 0x3FF;
+        value = (value | (value << 16)) & 0x030000FF;
+        value = (value | (value << 8)) & 0x0300F00F;
+        value = (value | (value << 4)) & 0x030C30C3;
+        value = (value | (value << 2)) & 0x09249249;
+
+        return value;
+    }
+
+
+    /// @brief Sorts the body order by Morton code (least significant digit radix sort)
+    /// @param tree The snapshot tree, with codes and order in snapshot order
+    static void sortSnapshotTreeCodes(SnapshotTreeData *tree)
+    {
+        int count = (int)tree->codes.size();
+        tree->nextCodes.resize(count);
+        tree->nextOrder.resize(count);
+
+        for (int shift = 0; shift < 3 * MORTON_BITS; shift += RADIX_BITS)
+        {
+            int offsets[1 << RADIX_BITS] = {0};
+
+            for (int i = 0; i < count; i++)
+            {
+                offsets[(tree->codes[i] >> shift) & ((1 << RADIX_BITS) - 1)]++;
+            }
+
+            int offset = 0;
+            for (int digit = 0; digit < (1 << RADIX_BITS); digit++)
+            {
+                int digitCount = offsets[digit];
+                offsets[digit] = offset;
+                offset += digitCount;
+            }
+
+            for (int i = 0; i < count; i++)
+            {
+                int slot = offsets[(tree->codes[i] >> shift) & ((1 << RADIX_BITS) - 1)]++;
+                tree->nextCodes[slot] = tree->codes[i];
+                tree->nextOrder[slot] = tree->order[i];
+            }
+
+            tree->codes.swap(tree->nextCodes);
+            tree->order.swap(tree->nextOrder);
+        }
+    }
+
+
+    /// @brief Finds where a range of sorted bodies splits: at the highest Morton bit that changes
+            // within it, or in the middle if every code is equal
+    /// @param tree The snapshot tree
+    /// @param first First body of the range
+    /// @param end End (exclusive) of the range
+    /// @return First body of the right half
+    static int findSnapshotTreeSplit(SnapshotTreeData *tree, int first, int end)
+    {
+        uint32_t firstCode = tree->codes[first];
+        uint32_t lastCode = tree->codes[end - 1];
+
+        if (firstCode == lastCode)
+        {
+            return (first + end) / 2;
+        }
+
+        uint32_t bit = 1U << (3 * MORTON_BITS - 1);
+        while (!((firstCode ^ lastCode) & bit))
+        {
+            bit >>= 1;
+        }
+
+        // The range shares every bit above: the bit is clear in the left half, set in the right
+        int low = first;
+        int high = end - 1;
+        while (high - low > 1)
+        {
+            int middle = (low + high) / 2;
+
+            if (tree->codes[middle] & bit)
+            {
+                high = middle;
+            }
+
+            else
+            {
+                low = middle;
+            }
+        }
+
+        return high;
+    }
+
+
+    /// @brief Builds the node of a range of sorted bodies and, recursively, its children.
+            // Bounds are left to fitSnapshotTreeNodes
+    /// @param tree The snapshot tree
+    /// @param first First body of the range
+    /// @param end End (exclusive) of the range
+    /// @return Index of the node
+    static int buildSnapshotTreeNode(SnapshotTreeData *tree, int first, int end)
+    {
+        int index = (int)tree->nodes.size();
+        tree->nodes.push_back({{0, 0, 0}, {0, 0, 0}, first, end - first, -1});
+
+        if (end - first > SNAPSHOT_TREE_LEAF_SIZE)
+        {
+            int split = findSnapshotTreeSplit(tree, first, end);
+            buildSnapshotTreeNode(tree, first, split);
+
+            int right = buildSnapshotTreeNode(tree, split, end);
+
+            // Indexed after the call: building the children may have moved the nodes
+            tree->nodes[index].right = right;
+        }
+
+        return index;
+    }
+
+
+    /// @brief Computes the bounds of every node from the sorted bodies. Children come after
+            // their parent, so a backwards sweep sees both children of a node before it
+    /// @param tree The snapshot tree
+    static void fitSnapshotTreeNodes(SnapshotTreeData *tree)
+    {
+        for (int index = (int)tree->nodes.size() - 1; index >= 0; index--)
+        {
+            SnapshotTreeNode &node = tree->nodes[index];
+
+            if (node.right >= 0)
+            {
+                node.min = Vector3Min(tree->nodes[index + 1].min, tree->nodes[node.right].min);
+                node.max = Vector3Max(tree->nodes[index + 1].max, tree->nodes[node.right].max);
+                continue;
+            }
+
+            Vector3 min = {FLT_MAX, FLT_MAX, FLT_MAX};
+            Vector3 max = {-FLT_MAX, -FLT_MAX, -FLT_MAX};
+
+            // Comparisons instead of fminf and fmaxf, which are calls unless NaNs can be ignored
+            for (int i = node.first; i < node.first + node.count; i++)
+            {
+                const Vector3 &position = tree->positions[i];
+                float radius = tree->radii[i];
+
+                min.x = (position.x - radius < min.x) ? position.x - radius : min.x;
+                min.y = (position.y - radius < min.y) ? position.y - radius : min.y;
+                min.z = (position.z - radius < min.z) ? position.z - radius : min.z;
+                max.x = (position.x + radius > max.x) ? position.x + radius : max.x;
+                max.y = (position.y + radius > max.y) ? position.y + radius : max.y;
+                max.z = (position.z + radius > max.z) ? position.z + radius : max.z;
+            }
+
+            node.min = min;
+            node.max = max;
+        }
+    }
+
+
+    /// @brief Moves the sorted bodies to their positions in a new snapshot, keeping the order
+            // and the topology. Cheaper than a rebuild, but the nodes loosen as bodies drift apart
+    /// @param tree The built tree
+    /// @param snapshot The snapshot, with the same bodies the tree was built for
+    static void refitSnapshotTree(SnapshotTreeData *tree, Snapshot *snapshot)
+    {
+        SnapshotBody *bodies = getSnapshotBodies(snapshot);
+        SnapshotGroup *groups = getSnapshotGroups(snapshot);
+
+        for (size_t i = 0; i < tree->items.size(); i++)
+        {
+            int item = tree->items[i];
+
+            if (item < snapshot->bodyCount)
+            {
+                tree->positions[i] = bodies[item].position;
+                continue;
+            }
+
+            // Few groups: a linear search beats storing the group of every body
+            int asteroid = item - snapshot->bodyCount;
+            int group = 0;
+            while (asteroid >= groups[group].startIndex + groups[group].count)
+            {
+                group++;
+            }
+
+            tree->positions[i] = unpackSnapshotPosition(snapshot, &groups[group], asteroid);
+        }
+
+        fitSnapshotTreeNodes(tree);
+    }
+
+
+    /// @brief Copies the bodies of a snapshot into the build buffers of a tree
+    /// @param tree The tree to build
+    /// @param snapshot The snapshot
+    /// @param groupRanges Start and count of every group of the snapshot
+    static void gatherSnapshotTreeBodies(SnapshotTreeData *tree, Snapshot *snapshot, const std::vector<int> &groupRanges)
+    {
+        SnapshotBody *bodies = getSnapshotBodies(snapshot);
+        SnapshotGroup *groups = getSnapshotGroups(snapshot);
+
+        tree->bodyCount = snapshot->bodyCount;
+        tree->groupRanges = groupRanges;
+
+        int count = snapshot->bodyCount;
+        for (int i = 0; i < snapshot->groupCount; i++)
+        {
+            count += groups[i].count;
+        }
+
+        tree->unsortedItems.resize(count);
+        tree->unsortedPositions.resize(count);
+        tree->unsortedRadii.resize(count);
+
+        for (int i = 0; i < snapshot->bodyCount; i++)
+        {
+            tree->unsortedItems[i] = i;
+            tree->unsortedPositions[i] = bodies[i].position;
+            tree->unsortedRadii[i] = getSnapshotVisualRadius(bodies[i].radius);
+        }
+
+        int slot = snapshot->bodyCount;
+        for (int i = 0; i < snapshot->groupCount; i++)
+        {
+            SnapshotGroup *group = &groups[i];
+            float radius = getSnapshotVisualRadius(group->radius);
+
+            for (int j = group->startIndex; j < group->startIndex + group->count; j++, slot++)
+            {
+                tree->unsortedItems[slot] = snapshot->bodyCount + j;
+                tree->unsortedPositions[slot] = unpackSnapshotPosition(snapshot, group, j);
+                tree->unsortedRadii[slot] = radius;
+            }
+        }
+    }
+
+
+    /// @brief Builds a tree from the bodies in its build buffers
+    /// @param tree The tree
+    static void buildSnapshotTreeData(SnapshotTreeData *tree)
+    {
+        int count = (int)tree->unsortedItems.size();
+        tree->nodes.clear();
+
+        if (count == 0)
+        {
+            return;
+        }
+
+        // Morton codes over the bounds of the body centers
+        Vector3 min = tree->unsortedPositions[0];
+        Vector3 max = min;
+        for (int i = 1; i < count; i++)
+        {
+            const Vector3 &position = tree->unsortedPositions[i];
+
+            min.x = (position.x < min.x) ? position.x : min.x;
+            min.y = (position.y < min.y) ? position.y : min.y;
+            min.z = (position.z < min.z) ? position.z : min.z;
+            max.x = (position.x > max.x) ? position.x : max.x;
+            max.y = (position.y > max.y) ? position.y : max.y;
+            max.z = (position.z > max.z) ? position.z : max.z;
+        }
+
+        float cellCount = (float)((1 << MORTON_BITS) - 1);
+        Vector3 extent = Vector3Subtract(max, min);
+        Vector3 scale = {(extent.x > 0) ? cellCount / extent.x : 0, (extent.y > 0) ? cellCount / extent.y : 0,
+                        (extent.z > 0) ? cellCount / extent.z : 0};
+
+        tree->codes.resize(count);
+        tree->order.resize(count);
+
+        for (int i = 0; i < count; i++)
+        {
+            Vector3 cell = Vector3Multiply(Vector3Subtract(tree->unsortedPositions[i], min), scale);
+
+            tree->codes[i] = (spreadMortonBits((uint32_t)cell.x) << 2) | (spreadMortonBits((uint32_t)cell.y) << 1) |
+                            spreadMortonBits((uint32_t)cell.z);
+            tree->order[i] = i;
+        }
+
+        sortSnapshotTreeCodes(tree);
+
+        tree->items.resize(count);
+        tree->positions.resize(count);
+        tree->radii.resize(count);
+
+        for (int i = 0; i < count; i++)
+        {
+            int body = tree->order[i];
+            tree->items[i] = tree->unsortedItems[body];
+            tree->positions[i] = tree->unsortedPositions[body];
+            tree->radii[i] = tree->unsortedRadii[body];
+        }
+
+        buildSnapshotTreeNode(tree, 0, count);
+        fitSnapshotTreeNodes(tree);
+    }
+
+
+    /// @brief Background rebuild of the next tree
+    /// @param tree The snapshot tree
+    static void runSnapshotTreeBuilder(SnapshotTree *tree)
+    {
+        buildSnapshotTreeData(&tree->next);
+        tree->isRebuilt.store(true, std::memory_order_release);
+    }
+
+
+    //* QUERIES
+
+    /// @brief Extracts the frustum planes of a view-projection matrix (Gribb-Hartmann).
+            // Planes are normalized and point inwards
+    /// @param viewProjection View-projection matrix, as raylib composes it
+    /// @param planes Destination of the FRUSTUM_PLANES planes (x, y, z normal, w offset)
+    static void getFrustumPlanes(Matrix viewProjection, Vector4 *planes)
+    {
+        const Matrix &m = viewProjection;
+        Vector4 rows[4] = {{m.m0, m.m4, m.m8, m.m12}, {m.m1, m.m5, m.m9, m.m13},
+                            {m.m2, m.m6, m.m10, m.m14}, {m.m3, m.m7, m.m11, m.m15}};
+
+        for (int i = 0; i < FRUSTUM_PLANES; i++)
+        {
+            // Left, right, bottom, top, near, far
+            const Vector4 &row = rows[i / 2];
+            float sign = (i % 2) ? -1.0F : 1.0F;
+            Vector4 plane = {rows[3].x + sign * row.x, rows[3].y + sign * row.y,
+                            rows[3].z + sign * row.z, rows[3].w + sign * row.w};
+
+            float length = sqrtf(plane.x * plane.x + plane.y * plane.y + plane.z * plane.z);
+            planes[i] = {plane.x / length, plane.y / length, plane.z / length, plane.w / length};
+        }
+    }
+
+
+    //* SNAPSHOT TREE MANAGEMENT
+
+    /// @brief Constructs an empty snapshot tree
+    /// @return The snapshot tree
+    SnapshotTree *constructSnapshotTree()
+    {
+        SnapshotTree *tree = new SnapshotTree;
+        tree->isBuilt = false;
+        tree->time = 0;
+        tree->refitCount = 0;
+        tree->current.bodyCount = 0;
+        tree->next.bodyCount = 0;
+        tree->isRebuilding = false;
+        tree->isRebuilt.store(false);
+
+        return tree;
+    }
+
+
+    /// @brief Destroys a snapshot tree
+    /// @param tree The snapshot tree
+    void destroySnapshotTree(SnapshotTree *tree)
+    {
+        if (tree->isRebuilding)
+        {
+            tree->builder.join();
+        }
+
+        delete tree;
+    }
+
+
+    /// @brief Brings the tree up to date with a snapshot. With the same bodies as the last one,
+            // the tree is refitted, and a rebuild starts in the background every
+            // SNAPSHOT_TREE_REBUILD_INTERVAL snapshots. New bodies need a rebuild right away
+    /// @param tree The snapshot tree
+    /// @param snapshot The snapshot
+    void updateSnapshotTree(SnapshotTree *tree, Snapshot *snapshot)
+    {
+        SnapshotGroup *groups = getSnapshotGroups(snapshot);
+
+        tree->groupRanges.clear();
+        for (int i = 0; i < snapshot->groupCount; i++)
+        {
+            tree->groupRanges.push_back(groups[i].startIndex);
+            tree->groupRanges.push_back(groups[i].count);
+        }
+
+        bool isSameBodies = tree->isBuilt && (tree->current.bodyCount == snapshot->bodyCount) &&
+                            (tree->current.groupRanges == tree->groupRanges);
+
+        if (isSameBodies && (tree->time == snapshot->time))
+        {
+            return;
+        }
+
+        tree->time = snapshot->time;
+
+        // A finished rebuild takes over, unless the bodies changed while it ran
+        if (tree->isRebuilding && tree->isRebuilt.load(std::memory_order_acquire))
+        {
+            tree->builder.join();
+            tree->isRebuilding = false;
+
+            if (isSameBodies && (tree->next.bodyCount == tree->current.bodyCount) &&
+                (tree->next.groupRanges == tree->current.groupRanges))
+            {
+                std::swap(tree->current, tree->next);
+            }
+        }
+
+        if (isSameBodies)
+        {
+            refitSnapshotTree(&tree->current, snapshot);
+            tree->refitCount++;
+
+            if ((tree->refitCount >= SNAPSHOT_TREE_REBUILD_INTERVAL) && !tree->isRebuilding)
+            {
+                // The snapshot may be overwritten while the builder runs, so it gets a copy
+                gatherSnapshotTreeBodies(&tree->next, snapshot, tree->groupRanges);
+                tree->refitCount = 0;
+                tree->isRebuilding = true;
+                tree->isRebuilt.store(false);
+                tree->builder = std::thread(runSnapshotTreeBuilder, tree);
+            }
+
+            return;
+        }
+
+        tree->isBuilt = true;
+        tree->refitCount = 0;
+        gatherSnapshotTreeBodies(&tree->current, snapshot, tree->groupRanges);
+        buildSnapshotTreeData(&tree->current);
+    }
+
+
+    /// @brief Finds the bodies whose spheres are at least partly inside a view frustum
+    /// @param tree The snapshot tree
+    /// @param viewProjection View-projection matrix of the camera
+    /// @param items Destination of the items found (cleared first), in tree order
+    /// @return Number of items found
+    int cullSnapshotTree(SnapshotTree *tree, Matrix viewProjection, std::vector<int> &items)
+    {
+        SnapshotTreeData *current = &tree->current;
+        items.clear();
+
+        if (current->nodes.empty())
+        {
+            return 0;
+        }
+
+        Vector4 planes[FRUSTUM_PLANES];
+        getFrustumPlanes(viewProjection, planes);
+
+        // Every entry carries the planes its node may still cross
+        int stack[SNAPSHOT_TREE_STACK_SIZE];
+        int planeMasks[SNAPSHOT_TREE_STACK_SIZE];
+        int stackSize = 0;
+
+        stack[stackSize] = 0;
+        planeMasks[stackSize++] = (1 << FRUSTUM_PLANES) - 1;
+
+        while (stackSize > 0)
+        {
+            stackSize--;
+            int index = stack[stackSize];
+            const SnapshotTreeNode &node = current->nodes[index];
+            int planeMask = planeMasks[stackSize];
+            bool isOutside = false;
+
+            for (int i = 0; (i < FRUSTUM_PLANES) && !isOutside; i++)
+            {
+                if (!(planeMask & (1 << i)))
+                {
+                    continue;
+                }
+
+                // Box corners farthest along and against the plane normal
+                const Vector4 &plane = planes[i];
+                Vector3 inner = {(plane.x > 0) ? node.max.x : node.min.x, (plane.y > 0) ? node.max.y : node.min.y,
+                                (plane.z > 0) ? node.max.z : node.min.z};
+                Vector3 outer = {(plane.x > 0) ? node.min.x : node.max.x, (plane.y > 0) ? node.min.y : node.max.y,
+                                (plane.z > 0) ? node.min.z : node.max.z};
+
+                isOutside = plane.x * inner.x + plane.y * inner.y + plane.z * inner.z + plane.w < 0;
+
+                if (plane.x * outer.x + plane.y * outer.y + plane.z * outer.z + plane.w >= 0)
+                {
+                    planeMask &= ~(1 << i);
+                }
+            }
+
+            if (isOutside)
+            {
+                continue;
+            }
+
+            if (!planeMask)
+            {
+                items.insert(items.end(), current->items.begin() + node.first,
+                            current->items.begin() + node.first + node.count);
+            }
+
+            else if (node.right < 0)
+            {
+                for (int i = node.first; i < node.first + node.count; i++)
+                {
+                    const Vector3 &position = current->positions[i];
+                    bool isVisible = true;
+
+                    for (int j = 0; (j < FRUSTUM_PLANES) && isVisible; j++)
+                    {
+                        const Vector4 &plane = planes[j];
+                        isVisible = plane.x * position.x + plane.y * position.y + plane.z * position.z + plane.w >=
+                                    -current->radii[i];
+                    }
+
+                    if (isVisible)
+                    {
+                        items.push_back(current->items[i]);
+                    }
+                }
+            }
+
+            else
+            {
+                stack[stackSize] = node.right;
+                planeMasks[stackSize++] = planeMask;
+                stack[stackSize] = index + 1;
+                planeMasks[stackSize++] = planeMask;
+            }
+        }
+
+        return (int)items.size();
+    }
+
+
+    /// @brief Casts a ray and finds the body it passes closest to, in angle as seen from the ray
+            // origin. Bodies whose sphere the ray hits come first, nearest first
+    /// @param tree The snapshot tree
+    /// @param ray The ray
+    /// @param tolerance Largest angle between the ray and a body sphere [rad, small angle]
+    /// @return The item picked, or -1 if there is none
+    int pickSnapshotTree(SnapshotTree *tree, Ray ray, float tolerance)
+    {
+        SnapshotTreeData *current = &tree->current;
+
+        if (current->nodes.empty())
+        {
+            return -1;
+        }
+
+        Vector3 origin = ray.position;
+        Vector3 direction = Vector3Normalize(ray.direction);
+
+        // Slab test; a huge inverse stands in for the infinite one of an axis-parallel ray
+        Vector3 inverse = {(fabsf(direction.x) > 1E-20F) ? 1.0F / direction.x : 1E30F,
+                            (fabsf(direction.y) > 1E-20F) ? 1.0F / direction.y : 1E30F,
+                            (fabsf(direction.z) > 1E-20F) ? 1.0F / direction.z : 1E30F};
+
+        int best = -1;
+        float bestScore = FLT_MAX;
+        float bestDistance = FLT_MAX;
+
+        int stack[SNAPSHOT_TREE_STACK_SIZE];
+        int stackSize = 0;
+        stack[stackSize++] = 0;
+
+        while (stackSize > 0)
+        {
+            int index = stack[--stackSize];
+            const SnapshotTreeNode &node = current->nodes[index];
+
+            // The tolerance cone is widest at the farthest corner of the box
+            Vector3 toMin = Vector3Subtract(node.min, origin);
+            Vector3 toMax = Vector3Subtract(node.max, origin);
+            Vector3 farthest = {fmaxf(fabsf(toMin.x), fabsf(toMax.x)), fmaxf(fabsf(toMin.y), fabsf(toMax.y)),
+                                fmaxf(fabsf(toMin.z), fabsf(toMax.z))};
+            float padding = tolerance * Vector3Length(farthest);
+
+            float nearX = (toMin.x - padding) * inverse.x;
+            float farX = (toMax.x + padding) * inverse.x;
+            float nearY = (toMin.y - padding) * inverse.y;
+            float farY = (toMax.y + padding) * inverse.y;
+            float nearZ = (toMin.z - padding) * inverse.z;
+            float farZ = (toMax.z + padding) * inverse.z;
+
+            float entry = fmaxf(fmaxf(fminf(nearX, farX), fminf(nearY, farY)), fmaxf(fminf(nearZ, farZ), 0));
+            float exit = fminf(fminf(fmaxf(nearX, farX), fmaxf(nearY, farY)), fmaxf(nearZ, farZ));
+
+            if (exit < entry)
+            {
+                continue;
+            }
+
+            if (node.right >= 0)
+            {
+                stack[stackSize++] = node.right;
+                stack[stackSize++] = index + 1;
+                continue;
+            }
+
+            for (int i = node.first; i < node.first + node.count; i++)
+            {
+                Vector3 toBody = Vector3Subtract(current->positions[i], origin);
+                float distance = Vector3DotProduct(toBody, direction);
+
+                if (distance <= 0)
+                {
+                    continue;
+                }
+
+                // The cross product keeps its precision for bodies close to a long ray
+                float offset = Vector3Length(Vector3CrossProduct(toBody, direction));
+                float miss = fmaxf(offset - current->radii[i], 0);
+                float score = miss / distance;
+
+                if ((score <= tolerance) &&
+                    ((score < bestScore) || ((score == bestScore) && (distance < bestDistance))))
+                {
+                    best = current->items[i];
+                    bestScore = score;
+                    bestDistance = distance;
+                }
+            }
+        }
+
+        return best;
+    }
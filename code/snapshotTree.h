@@ -0,0 +1,55 @@
+/* *****************************************************************
+    * FILE INFORMATION *
+   ***************************************************************** */
+
+/// @brief Bounding volume hierarchy over the bodies of a snapshot, shared by frustum culling
+        // and ray-cast picking. Rebuilt in linear time every few snapshots on a background thread,
+        // and refitted in between
+/// @author Marc S. Ressl, Ian A. Dib, Luciano S. Cordero
+/// @copyright Copyright (c) 2022-2023
+
+
+/* *****************************************************************
+    * HEADER CONFIGURATION *
+   ***************************************************************** */
+
+    #ifndef SNAPSHOTTREE_H
+    #define SNAPSHOTTREE_H
+
+
+    //* NECESSARY LIBRARIES AND HEADERS
+
+    #include <vector>
+
+    #include <raylib.h>
+    #include "snapshot.h"
+
+
+    //* CONFIGURATION
+
+    // Most bodies per leaf
+    #define SNAPSHOT_TREE_LEAF_SIZE 16
+
+    // Snapshots between background rebuilds; every snapshot refits the bounds of the current tree
+    // to the new positions, until the rebuilt one takes over
+    #define SNAPSHOT_TREE_REBUILD_INTERVAL 8
+
+
+    //* STRUCTURES
+
+    /// @brief Snapshot tree. Opaque: the nodes and items (C++ containers) stay inside
+            // snapshotTree.cpp. Items are identified as in the Arrow export: significant bodies
+            // first, then bodyCount + asteroid index
+    struct SnapshotTree;
+
+
+    //* PUBLIC FUNCTIONS PROTOTYPES
+
+    SnapshotTree *constructSnapshotTree();
+    void destroySnapshotTree(SnapshotTree *tree);
+    void updateSnapshotTree(SnapshotTree *tree, Snapshot *snapshot);
+    int cullSnapshotTree(SnapshotTree *tree, Matrix viewProjection, std::vector<int> &items);
+    int pickSnapshotTree(SnapshotTree *tree, Ray ray, float tolerance);
+
+
+    #endif // SNAPSHOTTREE_H
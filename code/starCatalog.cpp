@@ -0,0 +1,157 @@
+/* *****************************************************************
+    * FILE INFORMATION *
+   ***************************************************************** */
+
+/// @brief Background star catalog, read from a memory-mapped CSV of "ra_deg,dec_deg,magnitude"
+        // lines (J2000 equatorial). Kept apart from raylib, whose names clash with windows.h
+/// @author Marc S. Ressl, Ian A. Dib, Luciano S. Cordero
+/// @copyright Copyright (c) 2022-2023
+
+
+/* *****************************************************************
+    * FILE CONFIGURATION *
+   ***************************************************************** */
+
+    //* NECESSARY LIBRARIES
+
+    #include <stdio.h>
+    #include <string.h>
+
+    #ifdef _WIN32
+    #include <windows.h>
+    #else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+    #endif
+
+
+    //* NECESSARY HEADERS
+
+    #include "starCatalog.h"
+
+
+    //* CONSTANTS
+
+    #define DEGREES_PER_RADIAN 57.29577951308232
+
+    // Longest line parsed; the rest of a longer one is skipped
+    #define STAR_CATALOG_LINE_SIZE 256
+
+
+    //* PRIVATE FUNCTIONS PROTOTYPES
+
+    static void parseStarCatalog(const char *data, size_t size, float magnitudeLimit, std::vector<Star> &stars);
+
+
+/* *****************************************************************
+    * LOGIC MODULES *
+   ***************************************************************** */
+
+    //* PARSING
+
+    /// @brief Parses the mapped catalog. Lines that do not parse, like the header, are skipped
+    /// @param data Mapped file (not null-terminated)
+    /// @param size File size [bytes]
+    /// @param magnitudeLimit Dimmer stars are skipped
+    /// @param stars Destination stars
+    static void parseStarCatalog(const char *data, size_t size, float magnitudeLimit, std::vector<Star> &stars)
+    {
+        char line[STAR_CATALOG_LINE_SIZE];
+        size_t start = 0;
+
+        while (start < size)
+        {
+            const char *end = (const char *)memchr(data + start, '\n', size - start);
+            size_t lineLength = (end ? (size_t)(end - data) : size) - start;
+            size_t copyLength = (lineLength < sizeof(line) - 1) ? lineLength : sizeof(line) - 1;
+
+            memcpy(line, data + start, copyLength);
+            line[copyLength] = '\0';
+            start += lineLength + 1;
+
+            float rightAscension, declination, magnitude;
+            if ((sscanf(line, "%f,%f,%f", &rightAscension, &declination, &magnitude) == 3) &&
+                (magnitude <= magnitudeLimit))
+            {
+                stars.push_back({(float)(rightAscension / DEGREES_PER_RADIAN),
+                                (float)(declination / DEGREES_PER_RADIAN), magnitude});
+            }
+        }
+    }
+
+
+    //* LOADING
+
+    /// @brief Loads a star catalog. The file is mapped rather than read, so only the pages
+            // parsed are brought in, and no copy of it is kept
+    /// @param filename Catalog CSV
+    /// @param magnitudeLimit Dimmer stars are skipped
+    /// @param stars Destination stars
+    /// @return Whether the file could be mapped
+    bool loadStarCatalog(const char *filename, float magnitudeLimit, std::vector<Star> &stars)
+    {
+    #ifdef _WIN32
+        HANDLE file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+                                    FILE_ATTRIBUTE_NORMAL, NULL);
+        if (file == INVALID_HANDLE_VALUE)
+        {
+            return false;
+        }
+
+        LARGE_INTEGER fileSize;
+        HANDLE mapping = NULL;
+        const char *data = NULL;
+
+        if (GetFileSizeEx(file, &fileSize) && (fileSize.QuadPart > 0))
+        {
+            mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+            data = mapping ? (const char *)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : NULL;
+        }
+
+        if (data)
+        {
+            parseStarCatalog(data, (size_t)fileSize.QuadPart, magnitudeLimit, stars);
+            UnmapViewOfFile(data);
+        }
+
+        if (mapping)
+        {
+            CloseHandle(mapping);
+        }
+
+        CloseHandle(file);
+    #else
+        int file = open(filename, O_RDONLY);
+        if (file < 0)
+        {
+            return false;
+        }
+
+        struct stat fileStat;
+        const char *data = NULL;
+
+        if ((fstat(file, &fileStat) == 0) && (fileStat.st_size > 0))
+        {
+            void *mapping = mmap(NULL, (size_t)fileStat.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+            data = (mapping != MAP_FAILED) ? (const char *)mapping : NULL;
+        }
+
+        // The mapping stays valid without the descriptor
+        close(file);
+
+        if (data)
+        {
+            parseStarCatalog(data, (size_t)fileStat.st_size, magnitudeLimit, stars);
+            munmap((void *)data, (size_t)fileStat.st_size);
+        }
+    #endif
+
+        if (!data)
+        {
+            fprintf(stderr, "starCatalog: could not map %s\n", filename);
+        }
+
+        return data != NULL;
+    }
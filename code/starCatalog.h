@@ -0,0 +1,40 @@
+/* *****************************************************************
+    * FILE INFORMATION *
+   ***************************************************************** */
+
+/// @brief Background star catalog, read from a memory-mapped CSV of "ra_deg,dec_deg,magnitude"
+        // lines (J2000 equatorial). Kept apart from raylib, whose names clash with windows.h
+/// @author Marc S. Ressl, Ian A. Dib, Luciano S. Cordero
+/// @copyright Copyright (c) 2022-2023
+
+
+/* *****************************************************************
+    * HEADER CONFIGURATION *
+   ***************************************************************** */
+
+    #ifndef STARCATALOG_H
+    #define STARCATALOG_H
+
+
+    //* NECESSARY LIBRARIES
+
+    #include <vector>
+
+
+    //* CONSTANTS & STRUCTURES
+
+    /// @brief Catalog star
+    struct Star
+    {
+        float rightAscension;       // [rad]
+        float declination;          // [rad]
+        float magnitude;            // Visual magnitude
+    };
+
+
+    //* PUBLIC FUNCTIONS PROTOTYPES
+
+    bool loadStarCatalog(const char *filename, float magnitudeLimit, std::vector<Star> &stars);
+
+
+    #endif // STARCATALOG_H
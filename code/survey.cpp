@@ -0,0 +1,311 @@
+/* *****************************************************************
+    * FILE INFORMATION *
+   ***************************************************************** */
+
+/// @brief Synthetic survey: runs the headless simulation and writes, every few steps, the sky
+        // position of every body as seen from SKY_OBSERVER as CSV (right ascension and declination
+        // referred to the J2000 equator, distance and phase angle). With a pointings file, writes
+        // instead the asteroids that fall in every field of view.
+        // Usage: orbitalsim_survey [--asteroids n] [--days n] [--interval n] [--pointings file.csv]
+        // Pointings: one "time_days,ra_deg,dec_deg,radius_deg" line per field of view.
+        // Times are days since the survey starts, once the whole belt is generated
+/// @author Marc S. Ressl, Ian A. Dib, Luciano S. Cordero
+/// @copyright Copyright (c) 2022-2023
+
+
+/* *****************************************************************
+    * FILE CONFIGURATION *
+   ***************************************************************** */
+
+    //* NECESSARY LIBRARIES
+
+    #include <stdio.h>
+    #include <stdlib.h>
+    #include <string.h>
+    #include <algorithm>
+    #include <vector>
+
+
+    //* NECESSARY HEADERS
+
+    #include "orbitalSim.h"
+    #include "skyPositions.h"
+    #include "skyIndex.h"
+    #include "metrics.h"
+
+
+    //* CONSTANTS
+
+    #define SECONDS_PER_DAY 86400
+    #define ASTRONOMICAL_UNIT 1.495978707E11    // [m]
+    #define DEGREES_PER_RADIAN 57.29577951308232
+
+    // Defaults: one simulated year, one row per body every 140 steps (50 simulated days)
+    #define SURVEY_DAYS 365
+    #define SURVEY_INTERVAL 140
+
+
+    //* STRUCTURES
+
+    /// @brief Field of view observed at a time
+    struct SurveyPointing
+    {
+        float time;                 // [s]
+        float rightAscension;       // [rad]
+        float declination;          // [rad]
+        float radius;               // [rad]
+    };
+
+
+/* *****************************************************************
+    * LOGIC MODULES *
+   ***************************************************************** */
+
+    //* OUTPUT
+
+    /// @brief Prints a CSV row
+    /// @param time Survey time [s]
+    /// @param id Body id: significant bodies first, then asteroids (as in the Arrow export)
+    /// @param sky Its sky position
+    void printSkyPosition(float time, int id, const SkyPosition &sky)
+    {
+        printf("%.4f,%d,%.6f,%.6f,%.8f,%.4f\n", time / SECONDS_PER_DAY, id,
+                sky.rightAscension * DEGREES_PER_RADIAN, sky.declination * DEGREES_PER_RADIAN,
+                sky.distance / ASTRONOMICAL_UNIT, sky.phaseAngle * DEGREES_PER_RADIAN);
+    }
+
+
+    /// @brief Prints the sky positions of every body but the observer
+    /// @param sky Sky positions, just updated
+    /// @param sim The orbital simulation
+    /// @param startTime Simulation time the survey started at [s]
+    void printSkyPositions(SkyPositions *sky, OrbitalSim *sim, float startTime)
+    {
+        Vector3 observerPosition = sim->bodies[sky->observerIndex].position;
+        Vector3 illuminatorPosition = sim->bodies[sky->illuminatorIndex].position;
+
+        for (int i = 0; i < sim->bodyCount; i++)
+        {
+            if (i == sky->observerIndex)
+            {
+                continue;
+            }
+
+            SkyPosition bodySky = calculateSkyPosition(sim->bodies[i].position, sim->bodies[i].velocity,
+                                                        observerPosition, illuminatorPosition);
+
+            // The illuminator has no phase
+            if (i == sky->illuminatorIndex)
+            {
+                bodySky.phaseAngle = 0;
+            }
+
+            printSkyPosition(sky->time - startTime, i, bodySky);
+        }
+
+        for (int i = 0; i < sky->count; i++)
+        {
+            printSkyPosition(sky->time - startTime, sim->bodyCount + i, sky->positions[i]);
+        }
+    }
+
+
+    //* POINTINGS
+
+    /// @brief Loads a pointings file, sorted by time
+    /// @param filename Pointings CSV (lines that do not parse, like the header, are skipped)
+    /// @param pointings Destination pointings
+    /// @return Whether at least one pointing was read
+    bool loadSurveyPointings(const char *filename, std::vector<SurveyPointing> &pointings)
+    {
+        FILE *file = fopen(filename, "r");
+        if (!file)
+        {
+            fprintf(stderr, "orbitalsim_survey: could not open %s\n", filename);
+            return false;
+        }
+
+        char line[256];
+        float time, rightAscension, declination, radius;
+
+        while (fgets(line, sizeof(line), file))
+        {
+            if (sscanf(line, "%f,%f,%f,%f", &time, &rightAscension, &declination, &radius) == 4)
+            {
+                pointings.push_back({time * SECONDS_PER_DAY, (float)(rightAscension / DEGREES_PER_RADIAN),
+                                    (float)(declination / DEGREES_PER_RADIAN), (float)(radius / DEGREES_PER_RADIAN)});
+            }
+        }
+
+        fclose(file);
+
+        std::stable_sort(pointings.begin(), pointings.end(),
+                        [](const SurveyPointing &a, const SurveyPointing &b) { return a.time < b.time; });
+
+        return !pointings.empty();
+    }
+
+
+    /// @brief Observes every pointing at the simulation step closest to its time, and prints
+            // the asteroids in its field of view. The sky index is brought up to date once per step
+    /// @param sim The orbital simulation
+    /// @param sky Sky positions
+    /// @param pointings Pointings, sorted by time
+    /// @param startTime Simulation time the survey started at [s]
+    void observeSurveyPointings(OrbitalSim *sim, SkyPositions *sky, const std::vector<SurveyPointing> &pointings,
+                                float startTime)
+    {
+        SkyIndex *index = constructSkyIndex();
+        std::vector<int> asteroids;
+        bool isIndexed = false;
+        long detectionCount = 0;
+        uint64_t queryTime = 0;
+        uint64_t wallStartTime = getMetricsTime();
+
+        printf("pointing,time_days,id,ra_deg,dec_deg,distance_au,phase_deg\n");
+
+        for (size_t i = 0; i < pointings.size(); i++)
+        {
+            const SurveyPointing &pointing = pointings[i];
+
+            while (sim->time - startTime + 0.5F * sim->timeStep <= pointing.time)
+            {
+                updateOrbitalSim(sim);
+                isIndexed = false;
+            }
+
+            if (!isIndexed)
+            {
+                updateSkyPositions(sky, sim);
+                updateSkyIndex(index, sky, sim);
+                isIndexed = true;
+            }
+
+            uint64_t queryStart = getMetricsTime();
+            querySkyIndex(index, pointing.rightAscension, pointing.declination, pointing.radius, asteroids);
+            queryTime += getMetricsTime() - queryStart;
+
+            for (size_t j = 0; j < asteroids.size(); j++)
+            {
+                const SkyPosition &position = sky->positions[asteroids[j]];
+
+                printf("%u,%.4f,%d,%.6f,%.6f,%.8f,%.4f\n", (unsigned)i, (sky->time - startTime) / SECONDS_PER_DAY,
+                        sim->bodyCount + asteroids[j], position.rightAscension * DEGREES_PER_RADIAN,
+                        position.declination * DEGREES_PER_RADIAN, position.distance / ASTRONOMICAL_UNIT,
+                        position.phaseAngle * DEGREES_PER_RADIAN);
+            }
+
+            detectionCount += (long)asteroids.size();
+        }
+
+        fprintf(stderr, "orbitalsim_survey: %u pointings, %ld detections in %.3f s (%.3f s in queries)\n",
+                (unsigned)pointings.size(), detectionCount, (getMetricsTime() - wallStartTime) * 1E-9, queryTime * 1E-9);
+
+        destroySkyIndex(index);
+    }
+
+
+/* *****************************************************************
+    * MAIN LOGIC *
+   ***************************************************************** */
+
+    int main(int argc, char **argv)
+    {
+        int asteroidCount = NUM_ASTEROIDS;
+        float days = SURVEY_DAYS;
+        int interval = SURVEY_INTERVAL;
+        const char *pointingsFilename = NULL;
+
+        for (int i = 1; i < argc; i++)
+        {
+            if ((strcmp(argv[i], "--asteroids") == 0) && (i + 1 < argc))
+            {
+                asteroidCount = atoi(argv[++i]);
+            }
+
+            else if ((strcmp(argv[i], "--days") == 0) && (i + 1 < argc))
+            {
+                days = (float)atof(argv[++i]);
+            }
+
+            else if ((strcmp(argv[i], "--interval") == 0) && (i + 1 < argc))
+            {
+                interval = atoi(argv[++i]);
+            }
+
+            else if ((strcmp(argv[i], "--pointings") == 0) && (i + 1 < argc))
+            {
+                pointingsFilename = argv[++i];
+            }
+
+            else
+            {
+                fprintf(stderr, "usage: orbitalsim_survey [--asteroids n] [--days n] [--interval n] "
+                                "[--pointings file.csv]\n");
+                return 1;
+            }
+        }
+
+        if ((asteroidCount < 0) || (days < 0) || (interval <= 0))
+        {
+            fprintf(stderr, "orbitalsim_survey: counts must be positive\n");
+            return 1;
+        }
+
+        std::vector<SurveyPointing> pointings;
+        if (pointingsFilename && !loadSurveyPointings(pointingsFilename, pointings))
+        {
+            return 1;
+        }
+
+        // Reference integration step: 50 simulated days every 140 steps
+        OrbitalSim *sim = constructOrbitalSim(50 * SECONDS_PER_DAY / 140.0F, asteroidCount);
+
+        // The survey starts with the whole belt
+        while (sim->asteroidCount < sim->asteroidCapacity)
+        {
+            updateOrbitalSim(sim);
+        }
+
+        float startTime = sim->time;
+
+        SkyPositions *sky = constructSkyPositions(sim);
+        if (!sky)
+        {
+            destroyOrbitalSim(sim);
+            return 1;
+        }
+
+        if (pointingsFilename)
+        {
+            observeSurveyPointings(sim, sky, pointings, startTime);
+
+            destroySkyPositions(sky);
+            destroyOrbitalSim(sim);
+
+            return 0;
+        }
+
+        int stepCount = (int)(days * SECONDS_PER_DAY / sim->timeStep);
+
+        printf("time_days,id,ra_deg,dec_deg,distance_au,phase_deg\n");
+
+        for (int step = 0; step <= stepCount; step++)
+        {
+            if (step % interval == 0)
+            {
+                updateSkyPositions(sky, sim);
+                printSkyPositions(sky, sim, startTime);
+            }
+
+            if (step < stepCount)
+            {
+                updateOrbitalSim(sim);
+            }
+        }
+
+        destroySkyPositions(sky);
+        destroyOrbitalSim(sim);
+
+        return 0;
+    }
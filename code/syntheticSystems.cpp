@@ -0,0 +1,371 @@
+/* *****************************************************************
+    * FILE INFORMATION *
+   ***************************************************************** */
+
+/// @brief Seedable generators of large synthetic systems of test particles: Kuiper belt, Oort
+        // cloud, planetesimal disk, Plummer sphere and disk galaxy. Bodies are filled in parallel
+        // on the worker pool, each one from its own counter-based random stream, so the result
+        // only depends on the seed and never on the threads or chunks
+/// @author Marc S. Ressl, Ian A. Dib, Luciano S. Cordero
+/// @copyright Copyright (c) 2022-2023
+
+
+/* *****************************************************************
+    * FILE CONFIGURATION *
+   ***************************************************************** */
+
+    //* NECESSARY LIBRARIES
+
+    // Enables M_PI #define in Windows
+    #define _USE_MATH_DEFINES
+
+    #include <math.h>
+    #include <string.h>
+
+
+    //* NECESSARY HEADERS
+
+    #include "syntheticSystems.h"
+
+
+    //* CONSTANTS
+
+    #define ASTRONOMICAL_UNIT 1.495978707E11    // [m]
+
+    // Newton iterations of Kepler's equation, enough below e = 0.99
+    #define SYNTHETIC_KEPLER_ITERATIONS 8
+
+    // Plummer bodies farther than this many scale radii are drawn again
+    #define SYNTHETIC_PLUMMER_CUTOFF 20.0
+
+    // Velocity dispersion of the disk galaxy, relative to the circular speed
+    #define SYNTHETIC_GALAXY_DISPERSION 0.1
+
+    static const char *distributionNames[SYNTHETIC_DISTRIBUTION_NUM] = {"kuiper", "oort", "disk", "plummer", "galaxy"};
+
+
+    //* STRUCTURES
+
+    /// @brief Random stream of one body: the n-th draw is a hash of the key and n
+    struct SyntheticRandom
+    {
+        uint64_t key;
+        uint64_t counter;
+    };
+
+
+    /// @brief Arguments of the parallel fill
+    struct SyntheticContext
+    {
+        SyntheticDistribution distribution;
+        uint64_t seed;
+        double mass;                // [kg]
+        Asteroid *asteroids;
+    };
+
+
+    //* PRIVATE FUNCTIONS PROTOTYPES
+
+    static uint64_t mixSyntheticBits(uint64_t x);
+    static double getSyntheticUniform(SyntheticRandom *random);
+    static double getSyntheticRayleigh(SyntheticRandom *random, double sigma);
+    static double getSyntheticPowerLaw(SyntheticRandom *random, double min, double max, double exponent);
+    static void getSyntheticDirection(SyntheticRandom *random, double *direction);
+    static void setSyntheticKeplerState(Asteroid *asteroid, double mu, double semiMajorAxis, double eccentricity,
+                                        double inclination, double ascendingNode, double argumentOfPeriapsis,
+                                        double meanAnomaly);
+    static void generateSyntheticBody(const SyntheticContext *context, int index, Asteroid *asteroid);
+    static void generateSyntheticChunk(void *context, int startIndex, int endIndex);
+
+
+/* *****************************************************************
+    * LOGIC MODULES *
+   ***************************************************************** */
+
+    //* COUNTER-BASED RANDOM NUMBERS
+
+    /// @brief SplitMix64 finalizer: a bijective mix of a 64-bit counter
+    /// @cite https://prng.di.unimi.it/splitmix64.c
+    static uint64_t mixSyntheticBits(uint64_t x)
+    {
+        x += 0x9E3779B97F4A7C15ULL;
+        x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+        return x ^ (x >> 31);
+    }
+
+
+    /// @brief Draws a uniform number in (0, 1), never 0 nor 1 so logarithms stay finite
+    static double getSyntheticUniform(SyntheticRandom *random)
+    {
+        uint64_t bits = mixSyntheticBits(random->key + 0x9E3779B97F4A7C15ULL * random->counter++);
+        return ((bits >> 11) + 0.5) * (1.0 / 9007199254740992.0);
+    }
+
+
+    /// @brief Draws from a Rayleigh distribution, as the eccentricities and inclinations of a
+            // dynamically cold population
+    static double getSyntheticRayleigh(SyntheticRandom *random, double sigma)
+    {
+        return sigma * sqrt(-2.0 * log(getSyntheticUniform(random)));
+    }
+
+
+    /// @brief Draws from p(x) ~ x^exponent in [min, max], by inverting its distribution
+    /// @param exponent Any but -1
+    static double getSyntheticPowerLaw(SyntheticRandom *random, double min, double max, double exponent)
+    {
+        double power = exponent + 1.0;
+        double minPower = pow(min, power);
+
+        return pow(minPower + getSyntheticUniform(random) * (pow(max, power) - minPower), 1.0 / power);
+    }
+
+
+    /// @brief Draws an isotropic unit vector
+    /// @param direction Destination (3 doubles)
+    static void getSyntheticDirection(SyntheticRandom *random, double *direction)
+    {
+        double z = 2.0 * getSyntheticUniform(random) - 1.0;
+        double phi = 2.0 * M_PI * getSyntheticUniform(random);
+        double radius = sqrt(1.0 - z * z);
+
+        direction[0] = radius * cos(phi);
+        direction[1] = radius * sin(phi);
+        direction[2] = z;
+    }
+
+
+    //* STATES
+
+    /// @brief Sets the state of a body from its Keplerian elements around a center at the origin
+    /// @param asteroid Destination body
+    /// @param mu Gravitational parameter of the center [m^3/s^2]
+    /// @param semiMajorAxis [m]
+    /// @param eccentricity Below 1
+    /// @param inclination Referred to the ecliptic [rad]
+    /// @param ascendingNode [rad]
+    /// @param argumentOfPeriapsis [rad]
+    /// @param meanAnomaly [rad]
+    static void setSyntheticKeplerState(Asteroid *asteroid, double mu, double semiMajorAxis, double eccentricity,
+                                        double inclination, double ascendingNode, double argumentOfPeriapsis,
+                                        double meanAnomaly)
+    {
+        // Kepler's equation M = E - e sin E, by Newton's method
+        double anomaly = (eccentricity < 0.8) ? meanAnomaly : M_PI;
+        for (int i = 0; i < SYNTHETIC_KEPLER_ITERATIONS; i++)
+        {
+            anomaly -= (anomaly - eccentricity * sin(anomaly) - meanAnomaly) / (1.0 - eccentricity * cos(anomaly));
+        }
+
+        // Perifocal frame: x to the periapsis
+        double axisRatio = sqrt(1.0 - eccentricity * eccentricity);
+        double distance = semiMajorAxis * (1.0 - eccentricity * cos(anomaly));
+        double speedFactor = sqrt(mu * semiMajorAxis) / distance;
+        double x = semiMajorAxis * (cos(anomaly) - eccentricity);
+        double y = semiMajorAxis * axisRatio * sin(anomaly);
+        double vx = -speedFactor * sin(anomaly);
+        double vy = speedFactor * axisRatio * cos(anomaly);
+
+        // Rotated by the argument of periapsis, the inclination and the node
+        double cosNode = cos(ascendingNode), sinNode = sin(ascendingNode);
+        double cosPeriapsis = cos(argumentOfPeriapsis), sinPeriapsis = sin(argumentOfPeriapsis);
+        double cosInclination = cos(inclination), sinInclination = sin(inclination);
+
+        double xx = cosNode * cosPeriapsis - sinNode * sinPeriapsis * cosInclination;
+        double xy = -cosNode * sinPeriapsis - sinNode * cosPeriapsis * cosInclination;
+        double yx = sinNode * cosPeriapsis + cosNode * sinPeriapsis * cosInclination;
+        double yy = -sinNode * sinPeriapsis + cosNode * cosPeriapsis * cosInclination;
+        double zx = sinPeriapsis * sinInclination;
+        double zy = cosPeriapsis * sinInclination;
+
+        // Ecliptic (x, y, z) is simulation (x, z, y)
+        asteroid->position = {(float)(xx * x + xy * y), (float)(zx * x + zy * y), (float)(yx * x + yy * y)};
+        asteroid->velocity = {(float)(xx * vx + xy * vy), (float)(zx * vx + zy * vy), (float)(yx * vx + yy * vy)};
+    }
+
+
+    /// @brief Generates one body
+    /// @param context The fill arguments
+    /// @param index Index of the body, which keys its random stream
+    /// @param asteroid Destination body
+    static void generateSyntheticBody(const SyntheticContext *context, int index, Asteroid *asteroid)
+    {
+        SyntheticRandom random = {mixSyntheticBits(context->seed ^ mixSyntheticBits((uint64_t)index)), 0};
+        double mu = (double)GRAVITATIONAL_CONSTANT * context->mass;
+
+        switch (context->distribution)
+        {
+            case SYNTHETIC_KUIPER_BELT:
+            {
+                // One in five is a plutino, eccentric and inclined; the rest are classical
+                bool isPlutino = getSyntheticUniform(&random) < 0.2;
+                double semiMajorAxis = isPlutino ? SYNTHETIC_PLUTINO_AXIS :
+                                        SYNTHETIC_KUIPER_MIN_AXIS + (SYNTHETIC_KUIPER_MAX_AXIS - SYNTHETIC_KUIPER_MIN_AXIS) *
+                                        getSyntheticUniform(&random);
+                double eccentricity = isPlutino ? 0.1 + 0.2 * getSyntheticUniform(&random) :
+                                        fmin(getSyntheticRayleigh(&random, 0.05), 0.3);
+                double inclination = getSyntheticRayleigh(&random, isPlutino ? 0.2 : 0.05);
+
+                setSyntheticKeplerState(asteroid, mu, semiMajorAxis * ASTRONOMICAL_UNIT, eccentricity, inclination,
+                                        2.0 * M_PI * getSyntheticUniform(&random),
+                                        2.0 * M_PI * getSyntheticUniform(&random),
+                                        2.0 * M_PI * getSyntheticUniform(&random));
+                break;
+            }
+
+            case SYNTHETIC_OORT_CLOUD:
+            {
+                // Number density ~ r^-3.5 makes dN/da ~ a^-1.5; thermal eccentricities, p(e) = 2e
+                double semiMajorAxis = getSyntheticPowerLaw(&random, SYNTHETIC_OORT_MIN_AXIS, SYNTHETIC_OORT_MAX_AXIS, -1.5);
+                double eccentricity = fmin(sqrt(getSyntheticUniform(&random)), 0.99);
+                double inclination = acos(2.0 * getSyntheticUniform(&random) - 1.0);
+
+                setSyntheticKeplerState(asteroid, mu, semiMajorAxis * ASTRONOMICAL_UNIT, eccentricity, inclination,
+                                        2.0 * M_PI * getSyntheticUniform(&random),
+                                        2.0 * M_PI * getSyntheticUniform(&random),
+                                        2.0 * M_PI * getSyntheticUniform(&random));
+                break;
+            }
+
+            case SYNTHETIC_PLANETESIMAL_DISK:
+            {
+                // Surface density ~ r^-1.5 makes dN/da ~ a^-0.5
+                double semiMajorAxis = getSyntheticPowerLaw(&random, SYNTHETIC_DISK_MIN_AXIS, SYNTHETIC_DISK_MAX_AXIS, -0.5);
+
+                setSyntheticKeplerState(asteroid, mu, semiMajorAxis * ASTRONOMICAL_UNIT,
+                                        fmin(getSyntheticRayleigh(&random, 0.01), 0.5),
+                                        getSyntheticRayleigh(&random, 0.005),
+                                        2.0 * M_PI * getSyntheticUniform(&random),
+                                        2.0 * M_PI * getSyntheticUniform(&random),
+                                        2.0 * M_PI * getSyntheticUniform(&random));
+                break;
+            }
+
+            case SYNTHETIC_PLUMMER_SPHERE:
+            {
+                /// @cite Aarseth, Henon & Wielen (1974), A&A 37, 183
+                double scale = SYNTHETIC_PLUMMER_RADIUS * ASTRONOMICAL_UNIT;
+                double radius;
+                do
+                {
+                    radius = scale / sqrt(pow(getSyntheticUniform(&random), -2.0 / 3.0) - 1.0);
+                } while (radius > SYNTHETIC_PLUMMER_CUTOFF * scale);
+
+                // Speed as a fraction q of the escape speed, from g(q) = q^2 (1 - q^2)^3.5 by rejection
+                double q, g;
+                do
+                {
+                    q = getSyntheticUniform(&random);
+                    g = 0.1 * getSyntheticUniform(&random);
+                } while (g > q * q * pow(1.0 - q * q, 3.5));
+
+                double speed = q * sqrt(2.0 * mu / scale) * pow(1.0 + radius * radius / (scale * scale), -0.25);
+
+                double position[3], velocity[3];
+                getSyntheticDirection(&random, position);
+                getSyntheticDirection(&random, velocity);
+
+                asteroid->position = {(float)(radius * position[0]), (float)(radius * position[1]),
+                                        (float)(radius * position[2])};
+                asteroid->velocity = {(float)(speed * velocity[0]), (float)(speed * velocity[1]),
+                                        (float)(speed * velocity[2])};
+                break;
+            }
+
+            case SYNTHETIC_DISK_GALAXY:
+            default:
+            {
+                // Exponential surface density: the radius follows a gamma distribution of shape 2.
+                // sech^2 vertical profile with a tenth of the scale length
+                double scale = SYNTHETIC_GALAXY_RADIUS * ASTRONOMICAL_UNIT;
+                double radius = -scale * log(getSyntheticUniform(&random) * getSyntheticUniform(&random));
+                double u = getSyntheticUniform(&random);
+                double height = 0.05 * scale * log(u / (1.0 - u));
+                double phi = 2.0 * M_PI * getSyntheticUniform(&random);
+
+                // Circular speed from the mass inside the radius, as if it were spherical
+                double x = radius / scale;
+                double enclosedMu = mu * (1.0 - (1.0 + x) * exp(-x));
+                double speed = sqrt(enclosedMu / radius);
+                double dispersion = SYNTHETIC_GALAXY_DISPERSION * speed;
+
+                // Box-Muller pair, and a third draw, for the dispersion
+                double gaussianRadius = sqrt(-2.0 * log(getSyntheticUniform(&random)));
+                double gaussianAngle = 2.0 * M_PI * getSyntheticUniform(&random);
+                double noise[3] = {gaussianRadius * cos(gaussianAngle), gaussianRadius * sin(gaussianAngle),
+                                    sqrt(-2.0 * log(getSyntheticUniform(&random))) *
+                                    cos(2.0 * M_PI * getSyntheticUniform(&random))};
+
+                // Prograde like the planets
+                asteroid->position = {(float)(radius * cos(phi)), (float)height, (float)(radius * sin(phi))};
+                asteroid->velocity = {(float)(-speed * sin(phi) + dispersion * noise[0]),
+                                        (float)(dispersion * noise[1]),
+                                        (float)(speed * cos(phi) + dispersion * noise[2])};
+                break;
+            }
+        }
+    }
+
+
+    /// @brief Worker task: generates one chunk of bodies
+    /// @param context A SyntheticContext
+    /// @param startIndex Starting index of the chunk
+    /// @param endIndex Ending index (exclusive) of the chunk
+    static void generateSyntheticChunk(void *context, int startIndex, int endIndex)
+    {
+        SyntheticContext *fill = (SyntheticContext *)context;
+
+        for (int i = startIndex; i < endIndex; i++)
+        {
+            generateSyntheticBody(fill, i, &fill->asteroids[i]);
+        }
+    }
+
+
+    //* GENERATION
+
+    /// @brief Finds a distribution by name
+    /// @param name "kuiper", "oort", "disk", "plummer" or "galaxy"
+    /// @return The distribution, or SYNTHETIC_DISTRIBUTION_NUM if there is none by that name
+    SyntheticDistribution findSyntheticDistribution(const char *name)
+    {
+        for (int i = 0; i < SYNTHETIC_DISTRIBUTION_NUM; i++)
+        {
+            if (strcmp(name, distributionNames[i]) == 0)
+            {
+                return (SyntheticDistribution)i;
+            }
+        }
+
+        return SYNTHETIC_DISTRIBUTION_NUM;
+    }
+
+
+    /// @brief Gets the name of a distribution
+    /// @param distribution The distribution
+    /// @return Its name
+    const char *getSyntheticDistributionName(SyntheticDistribution distribution)
+    {
+        return (distribution < SYNTHETIC_DISTRIBUTION_NUM) ? distributionNames[distribution] : "unknown";
+    }
+
+
+    /// @brief Fills an array of bodies with a synthetic system, on every thread of the pool
+    /// @param pool The worker pool
+    /// @param distribution The system
+    /// @param seed Seed: the same seed gives the same bodies
+    /// @param mass Mass the bodies orbit: the central star, or the whole cluster or galaxy [kg]
+    /// @param asteroids Destination bodies
+    /// @param count Number of bodies
+    void generateSyntheticSystem(WorkerPool *pool, SyntheticDistribution distribution, uint64_t seed, double mass,
+                                Asteroid *asteroids, int count)
+    {
+        SyntheticContext context;
+        context.distribution = distribution;
+        context.seed = seed;
+        context.mass = mass;
+        context.asteroids = asteroids;
+
+        runWorkerPool(pool, getWorkerPoolSize(pool), count, SYNTHETIC_CHUNK_SIZE, generateSyntheticChunk, &context, NULL);
+    }
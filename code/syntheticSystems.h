@@ -0,0 +1,70 @@
+/* *****************************************************************
+    * FILE INFORMATION *
+   ***************************************************************** */
+
+/// @brief Seedable generators of large synthetic systems of test particles: Kuiper belt, Oort
+        // cloud, planetesimal disk, Plummer sphere and disk galaxy. Bodies are filled in parallel
+        // on the worker pool, each one from its own counter-based random stream, so the result
+        // only depends on the seed and never on the threads or chunks
+/// @author Marc S. Ressl, Ian A. Dib, Luciano S. Cordero
+/// @copyright Copyright (c) 2022-2023
+
+
+/* *****************************************************************
+    * HEADER CONFIGURATION *
+   ***************************************************************** */
+
+    #ifndef SYNTHETICSYSTEMS_H
+    #define SYNTHETICSYSTEMS_H
+
+
+    //* NECESSARY LIBRARIES AND HEADERS
+
+    #include <stdint.h>
+
+    #include "orbitalSim.h"
+    #include "workerPool.h"
+
+
+    //* CONFIGURATION
+
+    // Bodies per chunk of the parallel fill
+    #define SYNTHETIC_CHUNK_SIZE 16384
+
+    // Semi-major axes [AU]: plutinos sit in the 3:2 resonance with Neptune, the classical belt past it
+    #define SYNTHETIC_PLUTINO_AXIS 39.4
+    #define SYNTHETIC_KUIPER_MIN_AXIS 42.0
+    #define SYNTHETIC_KUIPER_MAX_AXIS 48.0
+    #define SYNTHETIC_OORT_MIN_AXIS 2E3
+    #define SYNTHETIC_OORT_MAX_AXIS 1E5
+    #define SYNTHETIC_DISK_MIN_AXIS 0.3
+    #define SYNTHETIC_DISK_MAX_AXIS 5.0
+
+    // Plummer scale radius, and disk galaxy scale length [AU]
+    #define SYNTHETIC_PLUMMER_RADIUS 100.0
+    #define SYNTHETIC_GALAXY_RADIUS 1E3
+
+
+    //* CONSTANTS & STRUCTURES
+
+    /// @brief Synthetic systems
+    enum SyntheticDistribution
+    {
+        SYNTHETIC_KUIPER_BELT,      // Plutinos and classical belt, around the center
+        SYNTHETIC_OORT_CLOUD,       // Isotropic, thermal eccentricities, density ~ r^-3.5
+        SYNTHETIC_PLANETESIMAL_DISK,// Cold disk, surface density ~ r^-1.5
+        SYNTHETIC_PLUMMER_SPHERE,   // Self-gravitating equilibrium cluster
+        SYNTHETIC_DISK_GALAXY,      // Exponential, sech^2 thick rotating disk
+        SYNTHETIC_DISTRIBUTION_NUM
+    };
+
+
+    //* PUBLIC FUNCTIONS PROTOTYPES
+
+    SyntheticDistribution findSyntheticDistribution(const char *name);
+    const char *getSyntheticDistributionName(SyntheticDistribution distribution);
+    void generateSyntheticSystem(WorkerPool *pool, SyntheticDistribution distribution, uint64_t seed, double mass,
+                                Asteroid *asteroids, int count);
+
+
+    #endif // SYNTHETICSYSTEMS_H
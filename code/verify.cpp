@@ -0,0 +1,190 @@
+/* *****************************************************************
+    * FILE INFORMATION *
+   ***************************************************************** */
+
+/// @brief Optimization-safety check: runs the simulation in a fast mode alongside two long double
+        // reference solvers and reports the largest position and velocity divergence over time.
+        // The step reference takes the simulation's own steps, so it only sees rounding and
+        // optimization errors; the accurate reference takes --substeps steps per timeStep, so it
+        // also sees the integrator's truncation error. Exits with status 1 if the relative position
+        // divergence from the step reference ever exceeds the tolerance.
+        // --step sets the timeStep in days: 1.6667 is the interactive simulation's (50 days per
+        // second at 30 physics steps per second).
+        // Usage: orbitalsim_verify [--kernel fused|tiled] [--threads n] [--asteroids n] [--steps n]
+        //                          [--samples n] [--substeps n] [--interval n] [--tolerance fraction]
+        //                          [--step days]
+/// @author Marc S. Ressl, Ian A. Dib, Luciano S. Cordero
+/// @copyright Copyright (c) 2022-2023
+
+
+/* *****************************************************************
+    * FILE CONFIGURATION *
+   ***************************************************************** */
+
+    //* NECESSARY LIBRARIES
+
+    #include <stdio.h>
+    #include <stdlib.h>
+    #include <string.h>
+
+
+    //* NECESSARY HEADERS
+
+    #include "orbitalSim.h"
+    #include "referenceSolver.h"
+
+
+    //* CONSTANTS
+
+    #define SECONDS_PER_DAY 86400
+
+    // Defaults: one simulated year at the reference integration step (50 days every 140 steps)
+    #define VERIFY_STEP_DAYS (50 / 140.0)
+    #define VERIFY_STEPS 1022
+    #define VERIFY_SAMPLES 64
+    #define VERIFY_SUBSTEPS 16
+    #define VERIFY_INTERVAL 70
+
+    // Largest divergence from the step reference allowed, relative to the distance from the
+    // origin. The float kernels stay around 5E-5 over the default year
+    #define VERIFY_TOLERANCE 1E-3
+
+
+/* *****************************************************************
+    * MAIN LOGIC *
+   ***************************************************************** */
+
+    int main(int argc, char **argv)
+    {
+        AsteroidKernel kernel = ASTEROID_KERNEL_FUSED;
+        int threadCount = 1;
+        int asteroidCount = NUM_ASTEROIDS;
+        int stepCount = VERIFY_STEPS;
+        int sampleCount = VERIFY_SAMPLES;
+        int substeps = VERIFY_SUBSTEPS;
+        int interval = VERIFY_INTERVAL;
+        double tolerance = VERIFY_TOLERANCE;
+        double stepDays = VERIFY_STEP_DAYS;
+
+        for (int i = 1; i < argc; i++)
+        {
+            if ((strcmp(argv[i], "--kernel") == 0) && (i + 1 < argc))
+            {
+                i++;
+                kernel = (strcmp(argv[i], "tiled") == 0) ? ASTEROID_KERNEL_TILED : ASTEROID_KERNEL_FUSED;
+            }
+
+            else if ((strcmp(argv[i], "--threads") == 0) && (i + 1 < argc))
+            {
+                threadCount = atoi(argv[++i]);
+            }
+
+            else if ((strcmp(argv[i], "--asteroids") == 0) && (i + 1 < argc))
+            {
+                asteroidCount = atoi(argv[++i]);
+            }
+
+            else if ((strcmp(argv[i], "--steps") == 0) && (i + 1 < argc))
+            {
+                stepCount = atoi(argv[++i]);
+            }
+
+            else if ((strcmp(argv[i], "--samples") == 0) && (i + 1 < argc))
+            {
+                sampleCount = atoi(argv[++i]);
+            }
+
+            else if ((strcmp(argv[i], "--substeps") == 0) && (i + 1 < argc))
+            {
+                substeps = atoi(argv[++i]);
+            }
+
+            else if ((strcmp(argv[i], "--interval") == 0) && (i + 1 < argc))
+            {
+                interval = atoi(argv[++i]);
+            }
+
+            else if ((strcmp(argv[i], "--tolerance") == 0) && (i + 1 < argc))
+            {
+                tolerance = atof(argv[++i]);
+            }
+
+            else if ((strcmp(argv[i], "--step") == 0) && (i + 1 < argc))
+            {
+                stepDays = atof(argv[++i]);
+            }
+
+            else
+            {
+                fprintf(stderr, "usage: orbitalsim_verify [--kernel fused|tiled] [--threads n] [--asteroids n] "
+                                "[--steps n] [--samples n] [--substeps n] [--interval n] [--tolerance fraction] "
+                                "[--step days]\n");
+                return 1;
+            }
+        }
+
+        if ((threadCount <= 0) || (asteroidCount < 0) || (stepCount <= 0) || (sampleCount < 0) || (substeps <= 0) || (interval <= 0) ||
+            !(stepDays > 0))
+        {
+            fprintf(stderr, "orbitalsim_verify: counts must be positive\n");
+            return 1;
+        }
+
+        OrbitalSim *sim = constructOrbitalSim((float)(stepDays * SECONDS_PER_DAY), asteroidCount);
+
+        while (sim->asteroidCount < sim->asteroidCapacity)
+        {
+            updateOrbitalSim(sim);
+        }
+
+        sim->tuning.kernel = kernel;
+        sim->tuning.threadCount = threadCount;
+
+        ReferenceSim *stepReference = constructReferenceSim(sim, sampleCount, sim->substeps);
+        ReferenceSim *accurateReference = constructReferenceSim(sim, sampleCount, substeps);
+        double maxRelativePosition = 0;
+
+        printf("time_days,step_position_m,step_velocity_ms,step_relative_position,"
+                "accurate_position_m,accurate_velocity_ms,accurate_relative_position\n");
+
+        for (int step = 1; step <= stepCount; step++)
+        {
+            updateOrbitalSim(sim);
+
+            // Follows the watchdog, which may have split the step
+            stepReference->substeps = sim->substeps;
+            updateReferenceSim(stepReference, sim->timeStep);
+            updateReferenceSim(accurateReference, sim->timeStep);
+
+            ReferenceDivergence stepDivergence = calculateReferenceDivergence(stepReference, sim);
+
+            if (!(stepDivergence.relativePosition <= maxRelativePosition))
+            {
+                maxRelativePosition = stepDivergence.relativePosition;
+            }
+
+            if ((step % interval == 0) || (step == stepCount))
+            {
+                ReferenceDivergence accurateDivergence = calculateReferenceDivergence(accurateReference, sim);
+
+                printf("%.2f,%.6g,%.6g,%.6g,%.6g,%.6g,%.6g\n", step * sim->timeStep / SECONDS_PER_DAY,
+                        stepDivergence.position, stepDivergence.velocity, stepDivergence.relativePosition,
+                        accurateDivergence.position, accurateDivergence.velocity,
+                        accurateDivergence.relativePosition);
+            }
+        }
+
+        destroyReferenceSim(stepReference);
+        destroyReferenceSim(accurateReference);
+        destroyOrbitalSim(sim);
+
+        // Also fails on NaN
+        if (!(maxRelativePosition <= tolerance))
+        {
+            fprintf(stderr, "orbitalsim_verify: relative position divergence %g exceeds %g\n",
+                    maxRelativePosition, tolerance);
+            return 1;
+        }
+
+        return 0;
+    }
@@ -17,14 +17,20 @@
 
     #include "raylib.h"
     #include "raymath.h"
+    #include "rlgl.h"
 
     #include <stdio.h>
+    #include <vector>
 
 
     //* NECESSARY HEADERS
 
-    #include "View.h"
-    #include "OrbitalSim.h"
+    #include "view.h"
+    #include "orbitalSim.h"
+    #include "snapshot.h"
+    #include "snapshotTree.h"
+    #include "orbitalElements.h"
+    #include "metrics.h"
 
 
     //* CONSTANTS
@@ -32,9 +38,6 @@
     #define WINDOW_WIDTH 1280
     #define WINDOW_HEIGHT 720
 
-    // Scale factor for converting astronomical distances to screen coordinates
-    #define SCALE_FACTOR 1E-11F
-
     // Constants for UI placement
     #define UI_TEXT_SIZE 20
     #define UI_MARGIN 10
@@ -47,6 +50,39 @@
     // Point size for distant objects
     #define POINT_SIZE 1.0f
 
+    // Clipping planes of the raylib projection (RL_CULL_DISTANCE_NEAR and RL_CULL_DISTANCE_FAR)
+    #define CAMERA_NEAR_PLANE 0.01
+    #define CAMERA_FAR_PLANE 1000.0
+
+    // Largest angle between the crosshair and a body it picks, about 5 pixels [rad]
+    #define PICK_TOLERANCE 0.005F
+
+    #define DEGREES_PER_RADIAN 57.29577951308232
+    #define ASTRONOMICAL_UNIT 1.495978707E11    // [m]
+
+    // Sphere tessellation, as in DrawSphere. rlgl has no vertex counter, so the vertices of
+    // immediate-mode primitives are estimated from the tessellation raylib uses for them:
+    // two triangles per ring and slice, plus the caps; DrawGrid draws two lines per slice and axis
+    #define SPHERE_RINGS 16
+    #define SPHERE_SLICES 16
+    #define SPHERE_VERTICES ((SPHERE_RINGS + 2) * SPHERE_SLICES * 6)
+    #define LINE_VERTICES 2
+    #define GRID_SLICES 50
+    #define GRID_VERTICES ((GRID_SLICES + 1) * 4)
+
+
+    //* STRUCTURES
+
+    /// @brief A frame placed between the two latest snapshots
+    struct ViewFrame
+    {
+        Snapshot *snapshot;             // Latest snapshot
+        Snapshot *previousSnapshot;     // NULL to show the latest as is
+        float time;                     // Presentation time [s]
+        float fraction;                 // 0 at the previous snapshot, 1 at the latest
+        float span;                     // Time between both snapshots [s]
+    };
+
 
 /* *****************************************************************
     * LOGIC MODULES *
@@ -74,63 +110,350 @@
     }
 
 
+    //* INTERPOLATION
+
+    /// @brief Gets the position and velocity of a snapshot item
+    /// @param snapshot The snapshot
+    /// @param item The item, as in the snapshot tree
+    /// @param position Destination position [display units]
+    /// @param velocity Destination velocity [display units/s]
+    /// @return Whether the item is in the snapshot
+    bool getSnapshotItemState(Snapshot *snapshot, int item, Vector3 *position, Vector3 *velocity)
+    {
+        if ((item >= 0) && (item < snapshot->bodyCount))
+        {
+            SnapshotBody *body = &getSnapshotBodies(snapshot)[item];
+            *position = body->position;
+            *velocity = body->velocity;
+
+            return true;
+        }
+
+        int asteroid = item - snapshot->bodyCount;
+        SnapshotGroup *group = (item >= 0) ? findSnapshotGroup(snapshot, asteroid) : NULL;
+
+        if (!group)
+        {
+            return false;
+        }
+
+        *position = unpackSnapshotPosition(snapshot, group, asteroid);
+        *velocity = unpackSnapshotVelocity(snapshot, group, asteroid);
+
+        return true;
+    }
+
+
+    /// @brief Places a frame between two snapshots
+    /// @param snapshot The latest snapshot
+    /// @param previousSnapshot The one before it, or NULL
+    /// @param time Presentation time of the frame [s]
+    /// @return The frame. Without a usable previous snapshot (none, or one with other bodies or
+            // not older than the latest), the frame shows the latest snapshot as is
+    ViewFrame getViewFrame(Snapshot *snapshot, Snapshot *previousSnapshot, float time)
+    {
+        ViewFrame frame = {snapshot, NULL, snapshot->time, 1.0F, 0.0F};
+
+        if (!previousSnapshot || (previousSnapshot->bodyCount != snapshot->bodyCount) ||
+            (previousSnapshot->time >= snapshot->time))
+        {
+            return frame;
+        }
+
+        float fraction = (time - previousSnapshot->time) / (snapshot->time - previousSnapshot->time);
+
+        frame.previousSnapshot = previousSnapshot;
+        frame.fraction = (fraction < 0.0F) ? 0.0F : ((fraction > 1.0F) ? 1.0F : fraction);
+        frame.span = snapshot->time - previousSnapshot->time;
+        frame.time = previousSnapshot->time + frame.fraction * frame.span;
+
+        return frame;
+    }
+
+
+    /// @brief Gets the position and velocity of an item at the frame's time: a cubic Hermite
+            // curve through both snapshots' positions, with their velocities as tangents, so
+            // orbits stay curved and the motion has no kinks at the snapshots
+    /// @param frame The frame
+    /// @param item The item, as in the snapshot tree
+    /// @param position Destination position [display units]
+    /// @param velocity Destination velocity [display units/s]
+    /// @return Whether the item is in the latest snapshot
+    bool getFrameState(const ViewFrame &frame, int item, Vector3 *position, Vector3 *velocity)
+    {
+        if (!getSnapshotItemState(frame.snapshot, item, position, velocity))
+        {
+            return false;
+        }
+
+        // Items generated since the previous snapshot are shown where they are now
+        Vector3 previousPosition, previousVelocity;
+        if (!frame.previousSnapshot ||
+            !getSnapshotItemState(frame.previousSnapshot, item, &previousPosition, &previousVelocity))
+        {
+            return true;
+        }
+
+        float s = frame.fraction;
+        float s2 = s * s;
+        float s3 = s2 * s;
+
+        // Hermite basis and its derivatives; tangents are velocities times the span
+        float h00 = 2.0F * s3 - 3.0F * s2 + 1.0F, h10 = s3 - 2.0F * s2 + s;
+        float h01 = 3.0F * s2 - 2.0F * s3, h11 = s3 - s2;
+        float d00 = 6.0F * (s2 - s), d10 = 3.0F * s2 - 4.0F * s + 1.0F;
+        float d11 = 3.0F * s2 - 2.0F * s;
+
+        Vector3 latestPosition = *position;
+        Vector3 latestVelocity = *velocity;
+
+        *position = Vector3Add(Vector3Add(Vector3Scale(previousPosition, h00),
+                                          Vector3Scale(previousVelocity, h10 * frame.span)),
+                               Vector3Add(Vector3Scale(latestPosition, h01),
+                                          Vector3Scale(latestVelocity, h11 * frame.span)));
+        *velocity = Vector3Add(Vector3Add(Vector3Scale(Vector3Subtract(previousPosition, latestPosition),
+                                                       d00 / frame.span),
+                                          Vector3Scale(previousVelocity, d10)),
+                               Vector3Scale(latestVelocity, d11));
+
+        return true;
+    }
+
+
     //* RENDERING OPTIMIZER
 
-    /// @brief Renders significant bodies as spheres and asteroids as either spheres or lines,
-            // depending on their distance to the camera
-    /// @param sim The orbital simulation
-    /// @param startIndex Starting index of the group of bodies to render
-    /// @param endIndex Ending index of the group of bodies to render
+    /// @brief Renders the bodies that survived culling: significant bodies as spheres and
+            // asteroids as either spheres or lines, depending on their distance to the camera
+    /// @param frame The frame, between two snapshots
+    /// @param items Visible items, as in the snapshot tree
     /// @param renderDistance Render distance threshold
     /// @param cameraDistance Camera distance from the origin
-    void renderOptimizer(OrbitalSim *sim, int startIndex, int endIndex, 
-                    float renderDistance, float cameraDistance) 
+    /// @param asteroidStride Only every n-th asteroid is drawn
+    /// @param stats Counters of the submitted work, incremented here
+    void renderOptimizer(const ViewFrame &frame, const std::vector<int> &items, float renderDistance,
+                        float cameraDistance, int asteroidStride, RenderStats *stats)
     {
-        for(int i = startIndex; i < endIndex; i++)
-        {
-            // Scale position according to the recommended scale factor
-            Vector3 scaledPosition = Vector3Scale(sim->bodies[i].position, SCALE_FACTOR);
-            Vector3 scaledPreviousPosition = Vector3Scale(sim->bodies[i].previousPosition, 
-                                                         SCALE_FACTOR);
-            
-            // Determine if the body is an asteroid
-            int isAsteroid = (i < NUM_ASTEROIDS);
-            
-            // Calculate visual size using the recommended empirical formula
-            float visualRadius = 0.005F * logf(sim->bodies[i].radius);
-            
+        Snapshot *snapshot = frame.snapshot;
+        SnapshotBody *bodies = getSnapshotBodies(snapshot);
+        bool isClose = cameraDistance < renderDistance;
+
+        for (size_t i = 0; i < items.size(); i++)
+        {
+            int item = items[i];
+
+            // Sampled by index, so the same asteroids stay on screen from frame to frame
+            if ((item >= snapshot->bodyCount) && ((item - snapshot->bodyCount) % asteroidStride != 0))
+            {
+                continue;
+            }
+
+            Vector3 scaledPosition, velocity;
+            getFrameState(frame, item, &scaledPosition, &velocity);
+
             // Significant bodies always rendered as spheres
-            if (!isAsteroid)
+            if (item < snapshot->bodyCount)
             {
-                DrawSphere(scaledPosition, visualRadius, sim->bodies[i].color);
+                DrawSphereEx(scaledPosition, getSnapshotVisualRadius(bodies[item].radius), SPHERE_RINGS, SPHERE_SLICES,
+                            bodies[item].color);
+                stats->vertices += SPHERE_VERTICES;
+                stats->drawCalls++;
+                continue;
             }
 
             // Asteroids have dynamic rendering based on camera distance
-            else 
+            SnapshotGroup *group = findSnapshotGroup(snapshot, item - snapshot->bodyCount);
+
+            // Close view: draw asteroids as spheres
+            if (isClose)
+            {
+                DrawSphereEx(scaledPosition, getSnapshotVisualRadius(group->radius), SPHERE_RINGS, SPHERE_SLICES,
+                            group->color);
+            }
+
+            // Far view: asteroids rendered as lines
+            else
+            {
+                // The direction of the asteroid's movement is given by its velocity
+                Vector3 direction = Vector3Normalize(velocity);
+
+                // The line is drawn as a small segment in the direction of the movement
+                Vector3 lineTop = Vector3Add(scaledPosition, Vector3Scale(direction, 0.1f));
+                Vector3 lineBottom = Vector3Subtract(scaledPosition, Vector3Scale(direction, 0.1f));
+                DrawLine3D(lineTop, lineBottom, group->color);
+            }
+
+            stats->vertices += isClose ? SPHERE_VERTICES : LINE_VERTICES;
+            stats->drawCalls++;
+        }
+    }
+
+
+    //* SELECTION
+
+    /// @brief Picks the body under the crosshair on a click, toggles following with F, and
+            // moves the camera along with the selection while following
+    /// @param view The view
+    /// @param frame The frame
+    void updateSelection(View *view, const ViewFrame &frame)
+    {
+        if (IsMouseButtonPressed(MOUSE_BUTTON_LEFT))
+        {
+            // The crosshair sits at the screen center, so the ray is the camera axis
+            Ray ray = {view->camera.position, Vector3Subtract(view->camera.target, view->camera.position)};
+            view->selection = pickSnapshotTree(view->tree, ray, PICK_TOLERANCE);
+            view->isFollowing = false;
+
+            Vector3 velocity;
+            getFrameState(frame, view->selection, &view->selectionPosition, &velocity);
+        }
+
+        Vector3 position, velocity;
+        if (!getFrameState(frame, view->selection, &position, &velocity))
+        {
+            view->selection = -1;
+            view->isFollowing = false;
+
+            return;
+        }
+
+        if (IsKeyPressed(KEY_F))
+        {
+            view->isFollowing = !view->isFollowing;
+        }
+
+        if (view->isFollowing)
+        {
+            Vector3 offset = Vector3Subtract(position, view->selectionPosition);
+            view->camera.position = Vector3Add(view->camera.position, offset);
+            view->camera.target = Vector3Add(view->camera.target, offset);
+        }
+
+        view->selectionPosition = position;
+    }
+
+
+    /// @brief Draws the name, orbital elements and velocity of the selection. Elements are
+            // referred to the most massive significant body
+    /// @param view The view
+    /// @param frame The frame
+    /// @param y Top of the text [pixels]
+    void drawSelection(View *view, const ViewFrame &frame, int y)
+    {
+        Vector3 position, velocity;
+        if (!getFrameState(frame, view->selection, &position, &velocity))
+        {
+            return;
+        }
+
+        Snapshot *snapshot = frame.snapshot;
+        SnapshotBody *bodies = getSnapshotBodies(snapshot);
+        int centerIndex = 0;
+        for (int i = 1; i < snapshot->bodyCount; i++)
+        {
+            if (bodies[i].mass > bodies[centerIndex].mass)
             {
-                // Close view: draw asteroids as spheres
-                if (cameraDistance < renderDistance)
-                {
-                    DrawSphere(scaledPosition, visualRadius, sim->bodies[i].color);
-                }
-
-                // Far view: asteroids rendered as lines
-                else 
-                {
-                    // Calculate and normalize the direction vector of the asteroid's movement
-                    Vector3 direction = Vector3Subtract(scaledPosition, scaledPreviousPosition);
-                    direction = Vector3Normalize(direction);
-
-                    // The line is drawn as a small segment in the direction of the movement
-                    Vector3 lineTop = Vector3Add(scaledPosition, Vector3Scale(direction, 0.1f));
-                    Vector3 lineBottom = Vector3Subtract(scaledPosition, Vector3Scale(direction, 0.1f));
-                    DrawLine3D(lineTop, lineBottom, sim->bodies[i].color);
-                }
+                centerIndex = i;
             }
         }
+
+        const char *name;
+        if (view->selection < snapshot->bodyCount)
+        {
+            name = bodies[view->selection].name;
+        }
+
+        else
+        {
+            int asteroid = view->selection - snapshot->bodyCount;
+            name = TextFormat("%s %d", findSnapshotGroup(snapshot, asteroid)->name, asteroid);
+        }
+
+        DrawText(name, UI_MARGIN, y, UI_TEXT_SIZE, UI_HIGHLIGHT_COLOR);
+
+        if ((snapshot->bodyCount > 0) && (view->selection != centerIndex))
+        {
+            SnapshotBody *center = &bodies[centerIndex];
+            Vector3 centerPosition, centerVelocity;
+            getFrameState(frame, centerIndex, &centerPosition, &centerVelocity);
+
+            Vector3 relativePosition = Vector3Scale(Vector3Subtract(position, centerPosition), 1.0F / SCALE_FACTOR);
+            Vector3 relativeVelocity = Vector3Scale(Vector3Subtract(velocity, centerVelocity), 1.0F / SCALE_FACTOR);
+            OrbitalElements elements = calculateOrbitalElements(relativePosition, relativeVelocity,
+                                                                (double)(GRAVITATIONAL_CONSTANT * center->mass));
+
+            DrawText(TextFormat("a: %.4f AU  e: %.4f  i: %.2f deg", elements.semiMajorAxis / ASTRONOMICAL_UNIT,
+                                elements.eccentricity, elements.inclination * DEGREES_PER_RADIAN),
+                    UI_MARGIN, y + UI_LINE_SPACING, UI_TEXT_SIZE, UI_TEXT_COLOR);
+            DrawText(TextFormat("Node: %.2f deg  Periapsis: %.2f deg  Anomaly: %.2f deg",
+                                elements.ascendingNode * DEGREES_PER_RADIAN,
+                                elements.argumentOfPeriapsis * DEGREES_PER_RADIAN,
+                                elements.trueAnomaly * DEGREES_PER_RADIAN),
+                    UI_MARGIN, y + 2 * UI_LINE_SPACING, UI_TEXT_SIZE, UI_TEXT_COLOR);
+            DrawText(TextFormat("Velocity: %.3f km/s (relative to %s)", Vector3Length(relativeVelocity) * 1E-3F,
+                                center->name),
+                    UI_MARGIN, y + 3 * UI_LINE_SPACING, UI_TEXT_SIZE, UI_TEXT_COLOR);
+        }
+
+        DrawText(view->isFollowing ? "Following (F to stop)" : "F to follow",
+                UI_MARGIN, y + 4 * UI_LINE_SPACING, UI_TEXT_SIZE, UI_HIGHLIGHT_COLOR);
+
+        // Ring around the selection on screen
+        Vector2 screenPosition = GetWorldToScreen(position, view->camera);
+        DrawCircleLines((int)screenPosition.x, (int)screenPosition.y, 8.0F, UI_HIGHLIGHT_COLOR);
     }
 
     
+    //* SCENE DECORATION
+
+    /// @brief Draws the HUD text that never changes
+    void drawStaticHud()
+    {
+        DrawText("Click to select the body under the crosshair",
+                UI_MARGIN, WINDOW_HEIGHT - 2 * UI_LINE_SPACING, UI_TEXT_SIZE, UI_HIGHLIGHT_COLOR);
+        DrawText("Camera Controls: WASD to move, SPACE/CTRL to up/down, Q/E to rotate",
+                UI_MARGIN, WINDOW_HEIGHT - UI_LINE_SPACING, UI_TEXT_SIZE, UI_HIGHLIGHT_COLOR);
+    }
+
+
+    /// @brief Draws the stars, reference orbits and grid, one draw call each
+    /// @param view The view
+    void drawScene(View *view)
+    {
+        SceneCache *scene = view->scene;
+
+        // Around the camera, so they stay at infinity. Stars face the origin: no back face
+        if (scene->hasStars)
+        {
+            rlDisableBackfaceCulling();
+            DrawModel(scene->stars, view->camera.position, 1.0f, WHITE);
+            rlEnableBackfaceCulling();
+            view->stats.drawCalls++;
+            view->stats.vertices += scene->starVertices;
+        }
+
+        if (scene->orbits.vertexCount > 0)
+        {
+            drawSceneLines(&scene->orbits);
+            view->stats.drawCalls++;
+            view->stats.vertices += scene->orbits.vertexCount;
+        }
+
+        if (scene->hasGrid)
+        {
+            drawSceneLines(&scene->grid);
+            view->stats.drawCalls++;
+            view->stats.vertices += scene->grid.vertexCount;
+        }
+
+        else
+        {
+            DrawGrid(GRID_SLICES, 1.0f);
+            view->stats.drawCalls++;
+            view->stats.vertices += GRID_VERTICES;
+        }
+    }
+
+
     //* VIEW MANAGEMENT
 
     /// @brief Constructs an orbital simulation view
@@ -150,21 +473,61 @@
         view->camera.up = {0.0f, 1.0f, 0.0f};
         view->camera.fovy = 45.0f;
         view->camera.projection = CAMERA_PERSPECTIVE;
+        view->isFreeCamera = true;
+        view->stats = {0, 0};
+        view->renderDistance = 10.0f;
+        view->asteroidStride = 1;
+
+        // Static decoration, built once
+        view->scene = constructSceneCache(GRID_SLICES, 1.0f, WINDOW_WIDTH, WINDOW_HEIGHT);
+        if (view->scene->hasHud)
+        {
+            BeginTextureMode(view->scene->hud);
+            drawStaticHud();
+            EndTextureMode();
+        }
+
+        view->tree = constructSnapshotTree();
+        view->selection = -1;
+        view->isFollowing = false;
+        view->selectionPosition = {0.0f, 0.0f, 0.0f};
 
         return view;
     }
 
 
-    /// @brief Renders an orbital simulation
+    /// @brief Renders an orbital simulation. With a previous snapshot, the bodies are drawn
+            // where they are at the given time, between both snapshots, so the physics can step
+            // far less often than frames are drawn
     /// @param view
-    /// @param sim The orbital sim
-    void renderView(View *view, OrbitalSim *sim)
+    /// @param snapshot The latest snapshot of the orbital sim
+    /// @param previousSnapshot The snapshot before it, or NULL to draw the latest as is
+    /// @param time Presentation time of the frame, between both snapshots [s]
+    void renderView(View *view, Snapshot *snapshot, Snapshot *previousSnapshot, float time)
     {
-        UpdateCamera(&view->camera, CAMERA_FREE);
+        uint64_t renderStart = getMetricsTime();
+        ViewFrame frame = getViewFrame(snapshot, previousSnapshot, time);
+
+        if (view->isFreeCamera)
+        {
+            UpdateCamera(&view->camera, CAMERA_FREE);
+        }
+
+        // Culling and picking use the latest positions; interpolated ones trail them by less
+        // than a snapshot interval, which the tree's bounds do not account for
+        updateSnapshotTree(view->tree, snapshot);
+        updateSelection(view, frame);
+        buildSceneOrbits(view->scene, snapshot);
+
+        view->stats = {0, 0};
 
-        // Calculate camera distance threshold for switching rendering modes
+        // Only the bodies inside the camera frustum are submitted
+        Matrix projection = MatrixPerspective(view->camera.fovy * DEG2RAD, (double)WINDOW_WIDTH / WINDOW_HEIGHT,
+                                                CAMERA_NEAR_PLANE, CAMERA_FAR_PLANE);
+        cullSnapshotTree(view->tree, MatrixMultiply(GetCameraMatrix(view->camera), projection), view->visibleItems);
+
+        // Calculate camera distance for switching rendering modes
         float cameraDistance = Vector3Length(view->camera.position);
-        float renderDistance = 10.0f;
 
         BeginDrawing();
 
@@ -174,10 +537,11 @@
         //* 3D DRAWING CODE
 
         // Render asteroids and significant bodies if enabled in orbitalSim.cpp
-        renderOptimizer(sim, 0, sim->bodyCount, renderDistance, cameraDistance);
+        renderOptimizer(frame, view->visibleItems, view->renderDistance, cameraDistance, view->asteroidStride,
+                        &view->stats);
 
-        // Draw reference grid
-        DrawGrid(50, 1.0f);
+        // Draw stars, reference orbits and grid
+        drawScene(view);
         
         EndMode3D();
 
@@ -186,17 +550,45 @@
         DrawFPS(UI_MARGIN, UI_MARGIN);
         
         // Show simulation date using the provided getISODate function
-        const char* dateStr = getISODate(sim->time);
+        const char* dateStr = getISODate(frame.time);
         DrawText(dateStr, UI_MARGIN, UI_MARGIN + UI_LINE_SPACING, UI_TEXT_SIZE, UI_TEXT_COLOR);
         
         // Show simulation time in days
-        DrawText(TextFormat("Simulation Time: %.2f days", sim->time / 86400), 
+        DrawText(TextFormat("Simulation Time: %.2f days", frame.time / 86400), 
                 UI_MARGIN, UI_MARGIN + 2 * UI_LINE_SPACING, UI_TEXT_SIZE, UI_TEXT_COLOR);
+
+        if (view->asteroidStride > 1)
+        {
+            DrawText(TextFormat("Drawing 1 in %d asteroids", view->asteroidStride),
+                    UI_MARGIN, UI_MARGIN + 3 * UI_LINE_SPACING, UI_TEXT_SIZE, UI_TEXT_COLOR);
+        }
         
-        // Show navigation help
-        DrawText("Camera Controls: WASD to move, SPACE/CTRL to up/down, Q/E to rotate", 
-                UI_MARGIN, WINDOW_HEIGHT - UI_LINE_SPACING, UI_TEXT_SIZE, UI_HIGHLIGHT_COLOR);
+        drawSelection(view, frame, UI_MARGIN + 4 * UI_LINE_SPACING);
+
+        // Crosshair the bodies are picked with
+        if (view->isFreeCamera)
+        {
+            DrawLine(WINDOW_WIDTH / 2 - 6, WINDOW_HEIGHT / 2, WINDOW_WIDTH / 2 + 6, WINDOW_HEIGHT / 2, UI_TEXT_COLOR);
+            DrawLine(WINDOW_WIDTH / 2, WINDOW_HEIGHT / 2 - 6, WINDOW_WIDTH / 2, WINDOW_HEIGHT / 2 + 6, UI_TEXT_COLOR);
+        }
+
+        // Show navigation help (render textures are stored upside down)
+        if (view->scene->hasHud)
+        {
+            Rectangle source = {0.0f, 0.0f, (float)WINDOW_WIDTH, -(float)WINDOW_HEIGHT};
+            DrawTextureRec(view->scene->hud.texture, source, {0.0f, 0.0f}, WHITE);
+        }
+
+        else
+        {
+            drawStaticHud();
+        }
         
+        // Render time covers CPU submission; EndDrawing also waits for the target FPS
+        recordMetricsPhase(METRICS_PHASE_RENDER, renderStart);
+        metrics.frames.fetch_add(1, std::memory_order_relaxed);
+        metrics.frameTime.store(GetFrameTime(), std::memory_order_relaxed);
+
         EndDrawing();
     }
 
@@ -214,6 +606,9 @@
     /// @param view The view
     void destroyView(View *view)
     {
+        // The scene's meshes and texture go before the GL context
+        destroySceneCache(view->scene);
         CloseWindow();
+        destroySnapshotTree(view->tree);
         delete view;
     }
\ No newline at end of file
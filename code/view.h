@@ -17,16 +17,42 @@
     
     //* NECESSARY LIBRARIES AND HEADERS
 
+    #include <vector>
+
     #include <raylib.h>
-    #include "OrbitalSim.h"
+    #include "orbitalSim.h"
+    #include "snapshot.h"
+    #include "snapshotTree.h"
+    #include "sceneCache.h"
    
    
     //* STRUCTURES
 
+    /// @brief Work submitted by the last rendered frame
+    struct RenderStats
+    {
+        int drawCalls;              // raylib draw calls (rlgl batches them into fewer GPU draws)
+        long vertices;              // Vertices submitted, estimated for immediate-mode primitives
+    };
+
+
     /// @brief View data
     struct View
     {
         Camera3D camera;
+        bool isFreeCamera;          // Moved with the keyboard and mouse, else set by the caller
+        RenderStats stats;
+
+        float renderDistance;       // Camera distance below which asteroids are spheres [display units]
+        int asteroidStride;         // Only every n-th asteroid is drawn
+
+        SceneCache *scene;          // Grid, reference orbits, stars and static HUD
+        SnapshotTree *tree;         // Shared by culling and picking
+        std::vector<int> visibleItems;
+
+        int selection;              // Item picked (as in the snapshot tree), -1 for none
+        bool isFollowing;           // The camera moves along with the selection
+        Vector3 selectionPosition;  // At the last frame [display units]
     };
    
    
@@ -35,7 +61,7 @@
     View* constructView(int fps);
     void destroyView(View *view);
     bool isViewRendering(View *view);
-    void renderView(View *view, OrbitalSim *sim);
+    void renderView(View *view, Snapshot *snapshot, Snapshot *previousSnapshot = NULL, float time = 0);
 
 
     #endif // ORBITALSIMVIEW_H
@@ -0,0 +1,176 @@
+/* *****************************************************************
+    * FILE INFORMATION *
+   ***************************************************************** */
+   
+/// @brief Orbital simulation viewer: attaches to a running orbitalsim_engine and renders
+        // its latest snapshot. It can be closed and reopened at will.
+        // Frames are presented one publish interval behind the engine, interpolated between
+        // the two latest snapshots
+/// @author Marc S. Ressl, Ian A. Dib, Luciano S. Cordero
+/// @copyright Copyright (c) 2022-2023
+
+
+/* *****************************************************************
+    * FILE CONFIGURATION *
+   ***************************************************************** */
+
+    //* NECESSARY HEADERS
+
+    #include <algorithm>
+
+    #include "view.h"
+    #include "snapshot.h"
+    #include "snapshotRing.h"
+    #include "qualityGovernor.h"
+    #include "metrics.h"
+
+
+    //* CONSTANTS
+
+    // Wall time without new snapshots before reattaching, in case the engine was restarted [s]
+    #define VIEWER_STALL_TIMEOUT 2.0
+
+
+/* *****************************************************************
+    * MAIN LOGIC *
+   ***************************************************************** */
+
+    int main()
+    {
+        // Frames per second
+        int fps = 140;
+
+        View *view = constructView(fps);
+
+        // Only the render is governed here: the physics runs in the engine
+        QualityGovernor *governor = QUALITY_GOVERNOR ? constructQualityGovernor(fps, 1) : NULL;
+
+        // Rendered until the first snapshot arrives
+        Snapshot emptySnapshot = {sizeof(Snapshot), 0.0F, 0, 0, 0, 0};
+
+        SnapshotRing *ring = NULL;
+        Snapshot *snapshot = NULL;
+        Snapshot *previousSnapshot = NULL;
+        uint32_t snapshotCapacity = 0;
+        bool hasSnapshot = false;
+        bool hasPreviousSnapshot = false;
+
+        // Wall times the two latest snapshots arrived at [s]
+        double snapshotArrival = 0.0;
+        double previousArrival = 0.0;
+
+        uint64_t lastPublishCount = 0;
+        double lastPublishTime = 0.0;
+
+
+        //* ATTACH, READ AND RENDER
+
+        while (isViewRendering(view))
+        {
+            if (!ring)
+            {
+                ring = attachSnapshotRing();
+
+                if (ring)
+                {
+                    if (ring->header->slotSize > snapshotCapacity)
+                    {
+                        delete[] (unsigned char *)snapshot;
+                        delete[] (unsigned char *)previousSnapshot;
+                        snapshotCapacity = ring->header->slotSize;
+                        snapshot = (Snapshot *)new unsigned char[snapshotCapacity];
+                        previousSnapshot = (Snapshot *)new unsigned char[snapshotCapacity];
+                        hasSnapshot = false;
+                    }
+
+                    // A restarted engine starts over in time
+                    hasPreviousSnapshot = false;
+
+                    lastPublishCount = 0;
+                    lastPublishTime = GetTime();
+                }
+            }
+
+            if (ring)
+            {
+                uint64_t publishCount = getSnapshotRingPublishCount(ring);
+
+                if (publishCount != lastPublishCount)
+                {
+                    lastPublishCount = publishCount;
+                    lastPublishTime = GetTime();
+
+                    // Read into the older buffer, which then becomes the latest
+                    if (readLatestSnapshot(ring, previousSnapshot, snapshotCapacity))
+                    {
+                        std::swap(snapshot, previousSnapshot);
+                        hasPreviousSnapshot = hasSnapshot;
+                        hasSnapshot = true;
+
+                        previousArrival = snapshotArrival;
+                        snapshotArrival = lastPublishTime;
+                    }
+
+                    else
+                    {
+                        hasPreviousSnapshot = false;
+                    }
+                }
+
+                // Stalled engine: keep showing the last snapshot and look for a new ring
+                else if (GetTime() - lastPublishTime > VIEWER_STALL_TIMEOUT)
+                {
+                    destroySnapshotRing(ring);
+                    ring = NULL;
+                }
+            }
+
+            if (!hasSnapshot)
+            {
+                renderView(view, &emptySnapshot);
+            }
+
+            else if (!hasPreviousSnapshot || (snapshotArrival <= previousArrival))
+            {
+                renderView(view, snapshot);
+            }
+
+            // Walks from the previous snapshot to the latest in the time they took to arrive
+            else
+            {
+                double fraction = (GetTime() - snapshotArrival) / (snapshotArrival - previousArrival);
+                fraction = std::min(fraction, 1.0);
+
+                renderView(view, snapshot, previousSnapshot,
+                            previousSnapshot->time + (float)fraction * (snapshot->time - previousSnapshot->time));
+            }
+
+            if (governor)
+            {
+                updateQualityGovernor(governor, metrics.phases[METRICS_PHASE_RENDER].lastNanoseconds.load() * 1E-9F,
+                                        GetFrameTime());
+
+                view->renderDistance = governor->renderDistance;
+                view->asteroidStride = governor->asteroidStride;
+            }
+        }
+
+
+        //* DETACH AND CLEANUP
+
+        if (ring)
+        {
+            destroySnapshotRing(ring);
+        }
+
+        delete[] (unsigned char *)snapshot;
+        delete[] (unsigned char *)previousSnapshot;
+        destroyView(view);
+
+        if (governor)
+        {
+            destroyQualityGovernor(governor);
+        }
+
+        return 0;
+    }
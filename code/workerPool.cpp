@@ -0,0 +1,408 @@
+/* *****************************************************************
+    * FILE INFORMATION *
+   ***************************************************************** */
+
+/// @brief Persistent worker threads that split a range of items into chunks.
+        // Threads are created once and sleep between jobs; the calling thread also works.
+        // Chunks are split into one contiguous range per thread, balanced with the chunk
+        // costs measured on the previous run, and threads that finish early steal chunks
+        // from the others' ranges
+/// @author Marc S. Ressl, Ian A. Dib, Luciano S. Cordero
+/// @copyright Copyright (c) 2022-2023
+
+
+/* *****************************************************************
+    * FILE CONFIGURATION *
+   ***************************************************************** */
+
+    //* NECESSARY LIBRARIES
+
+    #include <stdint.h>
+    #include <atomic>
+    #include <chrono>
+    #include <condition_variable>
+    #include <mutex>
+    #include <thread>
+    #include <vector>
+
+
+    //* NECESSARY HEADERS
+
+    #include "workerPool.h"
+
+
+    //* STRUCTURES
+
+    /// @brief Chunks assigned to one thread. Any thread may claim them once its own range is done
+    struct WorkerRange
+    {
+        std::atomic<int> nextChunk;
+        int endChunk;
+    };
+
+
+    struct WorkerSchedule
+    {
+        std::vector<uint64_t> chunkCosts;       // Time taken by every chunk on the last run [ns]
+        std::vector<uint64_t> busyTimes;        // Time spent in chunks by every thread on the last run [ns]
+        double imbalance;                       // Busiest thread over mean busy time on the last run
+    };
+
+
+    struct WorkerPool
+    {
+        std::vector<std::thread> threads;
+        std::mutex mutex;
+        std::condition_variable wake;           // A job was posted or the pool is stopping
+        std::condition_variable done;           // The last participating worker finished
+        uint64_t generation;                    // Incremented on every job
+        bool isStopping;
+
+        // Current job
+        WorkerTask task;
+        void *context;
+        int itemCount;
+        int chunkSize;
+        int workerCount;                        // Worker threads taking part (the caller is not counted)
+        int pendingWorkers;
+        WorkerRange *ranges;                    // One per taking part thread, the caller first
+        WorkerSchedule *schedule;               // Cost model of the job, NULL if not measured
+    };
+
+
+    //* PRIVATE FUNCTIONS PROTOTYPES
+
+    static uint64_t getWorkerTime();
+    static void partitionChunks(WorkerPool *pool, int chunkCount);
+    static void processChunks(WorkerPool *pool, int participant);
+    static void runWorker(WorkerPool *pool, int workerIndex);
+
+
+/* *****************************************************************
+    * LOGIC MODULES *
+   ***************************************************************** */
+
+    //* SCHEDULING
+
+    static uint64_t getWorkerTime()
+    {
+        return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+
+    /// @brief Splits the chunks into one contiguous range per taking part thread, with equal
+            // measured cost in each (weighted prefix-sum partitioning). Chunks without a
+            // measurement, or jobs without a schedule, count every chunk the same
+    /// @param pool The pool, with the job already set
+    /// @param chunkCount Number of chunks of the job
+    static void partitionChunks(WorkerPool *pool, int chunkCount)
+    {
+        WorkerSchedule *schedule = pool->schedule;
+        int participantCount = pool->workerCount + 1;
+
+        if (schedule && (schedule->chunkCosts.size() != (size_t)chunkCount))
+        {
+            schedule->chunkCosts.assign(chunkCount, 1);
+        }
+
+        uint64_t totalCost = schedule ? 0 : (uint64_t)chunkCount;
+        for (int i = 0; schedule && (i < chunkCount); i++)
+        {
+            totalCost += schedule->chunkCosts[i];
+        }
+
+        int chunk = 0;
+        uint64_t prefixCost = 0;
+
+        for (int participant = 0; participant < participantCount; participant++)
+        {
+            uint64_t targetCost = totalCost * (participant + 1) / participantCount;
+
+            pool->ranges[participant].nextChunk.store(chunk, std::memory_order_relaxed);
+
+            while ((chunk < chunkCount) &&
+                    ((prefixCost < targetCost) || (participant == participantCount - 1)))
+            {
+                prefixCost += schedule ? schedule->chunkCosts[chunk] : 1;
+                chunk++;
+            }
+
+            pool->ranges[participant].endChunk = chunk;
+        }
+    }
+
+
+    /// @brief Runs the chunks of a thread's own range, then steals from the other ranges
+    /// @param pool The pool
+    /// @param participant Index of the thread within the job (0 is the caller)
+    static void processChunks(WorkerPool *pool, int participant)
+    {
+        WorkerSchedule *schedule = pool->schedule;
+        int participantCount = pool->workerCount + 1;
+        uint64_t busyTime = 0;
+
+        for (int offset = 0; offset < participantCount; offset++)
+        {
+            WorkerRange *range = &pool->ranges[(participant + offset) % participantCount];
+            int chunk;
+
+            while ((chunk = range->nextChunk.fetch_add(1, std::memory_order_relaxed)) < range->endChunk)
+            {
+                int startIndex = chunk * pool->chunkSize;
+                int endIndex = (startIndex + pool->chunkSize < pool->itemCount) ?
+                                startIndex + pool->chunkSize : pool->itemCount;
+
+                if (schedule)
+                {
+                    uint64_t startTime = getWorkerTime();
+                    pool->task(pool->context, startIndex, endIndex);
+                    uint64_t cost = getWorkerTime() - startTime;
+
+                    // Every chunk is claimed exactly once, so no other thread writes this entry
+                    schedule->chunkCosts[chunk] = cost ? cost : 1;
+                    busyTime += cost;
+                }
+
+                else
+                {
+                    pool->task(pool->context, startIndex, endIndex);
+                }
+            }
+        }
+
+        if (schedule)
+        {
+            schedule->busyTimes[participant] = busyTime;
+        }
+    }
+
+
+    //* WORKERS
+
+    /// @brief Worker thread: sleeps until a job is posted and takes part if it is within the job's thread count
+    /// @param pool The pool
+    /// @param workerIndex Index of the worker
+    static void runWorker(WorkerPool *pool, int workerIndex)
+    {
+        uint64_t lastGeneration = 0;
+        std::unique_lock<std::mutex> lock(pool->mutex);
+
+        while (true)
+        {
+            while (!pool->isStopping && (pool->generation == lastGeneration))
+            {
+                pool->wake.wait(lock);
+            }
+
+            if (pool->isStopping)
+            {
+                return;
+            }
+
+            lastGeneration = pool->generation;
+
+            if (workerIndex < pool->workerCount)
+            {
+                lock.unlock();
+                processChunks(pool, workerIndex + 1);
+                lock.lock();
+
+                pool->pendingWorkers--;
+                if (pool->pendingWorkers == 0)
+                {
+                    pool->done.notify_one();
+                }
+            }
+        }
+    }
+
+
+    //* POOL MANAGEMENT
+
+    /// @brief Gets the number of hardware threads
+    /// @return Number of hardware threads, at least 1
+    int getHardwareThreadCount()
+    {
+        unsigned int threadCount = std::thread::hardware_concurrency();
+
+        return threadCount ? (int)threadCount : 1;
+    }
+
+
+    /// @brief Constructs a worker pool
+    /// @param threadCount Maximum threads of a job, including the calling thread
+    /// @return The pool
+    WorkerPool *constructWorkerPool(int threadCount)
+    {
+        WorkerPool *pool = new WorkerPool;
+        pool->generation = 0;
+        pool->isStopping = false;
+        pool->workerCount = 0;
+        pool->pendingWorkers = 0;
+        pool->ranges = new WorkerRange[threadCount > 1 ? threadCount : 1];
+        pool->schedule = NULL;
+
+        for (int i = 0; i < threadCount - 1; i++)
+        {
+            pool->threads.push_back(std::thread(runWorker, pool, i));
+        }
+
+        return pool;
+    }
+
+
+    /// @brief Stops the workers and destroys the pool
+    /// @param pool The pool
+    void destroyWorkerPool(WorkerPool *pool)
+    {
+        {
+            std::lock_guard<std::mutex> lock(pool->mutex);
+            pool->isStopping = true;
+        }
+        pool->wake.notify_all();
+
+        for (size_t i = 0; i < pool->threads.size(); i++)
+        {
+            pool->threads[i].join();
+        }
+
+        delete[] pool->ranges;
+        delete pool;
+    }
+
+
+    /// @brief Gets the maximum threads of a job
+    /// @param pool The pool
+    /// @return Worker threads plus the calling thread
+    int getWorkerPoolSize(WorkerPool *pool)
+    {
+        return (int)pool->threads.size() + 1;
+    }
+
+
+    /// @brief Constructs an empty cost model for a recurring job
+    /// @return The schedule
+    WorkerSchedule *constructWorkerSchedule()
+    {
+        WorkerSchedule *schedule = new WorkerSchedule;
+        schedule->imbalance = 1.0;
+
+        return schedule;
+    }
+
+
+    /// @brief Destroys a schedule
+    /// @param schedule The schedule
+    void destroyWorkerSchedule(WorkerSchedule *schedule)
+    {
+        delete schedule;
+    }
+
+
+    /// @brief Gets how unevenly the last run was spread
+    /// @param schedule The schedule
+    /// @return Busiest thread's time in chunks over the mean (1 is perfectly balanced)
+    double getWorkerScheduleImbalance(WorkerSchedule *schedule)
+    {
+        return schedule->imbalance;
+    }
+
+
+    /// @brief Runs a task over [0, itemCount) in chunks and waits for it to finish
+    /// @param pool The pool
+    /// @param threadCount Threads to use, including the calling thread (clamped to the pool size)
+    /// @param itemCount Number of items
+    /// @param chunkSize Items per chunk
+    /// @param task Function called for every chunk, possibly from several threads at once
+    /// @param context Argument passed to the task
+    /// @param schedule Cost model updated by every run of the same job, or NULL to split chunks evenly
+    void runWorkerPool(WorkerPool *pool, int threadCount, int itemCount, int chunkSize,
+                        WorkerTask task, void *context, WorkerSchedule *schedule)
+    {
+        if (chunkSize < 1)
+        {
+            chunkSize = 1;
+        }
+
+        int chunkCount = (itemCount + chunkSize - 1) / chunkSize;
+        int workerCount = threadCount - 1;
+
+        if (workerCount > (int)pool->threads.size())
+        {
+            workerCount = (int)pool->threads.size();
+        }
+
+        // Nothing to share: skip the wake-up
+        if (workerCount > chunkCount - 1)
+        {
+            workerCount = chunkCount - 1;
+        }
+
+        // A measured job still runs chunk by chunk on the calling thread, so its chunk costs and
+        // imbalance stay current when it goes serial
+        if (workerCount <= 0)
+        {
+            if (!schedule)
+            {
+                if (itemCount > 0)
+                {
+                    task(context, 0, itemCount);
+                }
+
+                return;
+            }
+
+            workerCount = 0;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(pool->mutex);
+            pool->task = task;
+            pool->context = context;
+            pool->itemCount = itemCount;
+            pool->chunkSize = chunkSize;
+            pool->workerCount = workerCount;
+            pool->pendingWorkers = workerCount;
+            pool->schedule = schedule;
+
+            if (schedule)
+            {
+                schedule->busyTimes.assign(workerCount + 1, 0);
+            }
+
+            partitionChunks(pool, chunkCount);
+
+            if (workerCount > 0)
+            {
+                pool->generation++;
+            }
+        }
+
+        if (workerCount > 0)
+        {
+            pool->wake.notify_all();
+        }
+
+        processChunks(pool, 0);
+
+        std::unique_lock<std::mutex> lock(pool->mutex);
+        while (pool->pendingWorkers > 0)
+        {
+            pool->done.wait(lock);
+        }
+
+        if (schedule)
+        {
+            uint64_t totalBusyTime = 0;
+            uint64_t maxBusyTime = 0;
+
+            for (int i = 0; i <= workerCount; i++)
+            {
+                totalBusyTime += schedule->busyTimes[i];
+                maxBusyTime = (schedule->busyTimes[i] > maxBusyTime) ? schedule->busyTimes[i] : maxBusyTime;
+            }
+
+            schedule->imbalance = totalBusyTime ? (double)maxBusyTime * (workerCount + 1) / totalBusyTime : 1.0;
+        }
+    }
@@ -0,0 +1,43 @@
+/* *****************************************************************
+    * FILE INFORMATION *
+   ***************************************************************** */
+
+/// @brief Persistent worker threads that split a range of items into chunks
+/// @author Marc S. Ressl, Ian A. Dib, Luciano S. Cordero
+/// @copyright Copyright (c) 2022-2023
+
+
+/* *****************************************************************
+    * HEADER CONFIGURATION *
+   ***************************************************************** */
+
+    #ifndef WORKERPOOL_H
+    #define WORKERPOOL_H
+
+
+    //* CONSTANTS & STRUCTURES
+
+    /// @brief Work on the items [startIndex, endIndex)
+    typedef void (*WorkerTask)(void *context, int startIndex, int endIndex);
+
+    // Opaque, defined in workerPool.cpp
+    struct WorkerPool;
+
+    // Opaque: per-chunk costs measured on the previous run of a recurring job
+    struct WorkerSchedule;
+
+
+    //* PUBLIC FUNCTIONS PROTOTYPES
+
+    WorkerPool *constructWorkerPool(int threadCount);
+    void destroyWorkerPool(WorkerPool *pool);
+    int getWorkerPoolSize(WorkerPool *pool);
+    int getHardwareThreadCount();
+    WorkerSchedule *constructWorkerSchedule();
+    void destroyWorkerSchedule(WorkerSchedule *schedule);
+    double getWorkerScheduleImbalance(WorkerSchedule *schedule);
+    void runWorkerPool(WorkerPool *pool, int threadCount, int itemCount, int chunkSize,
+                        WorkerTask task, void *context, WorkerSchedule *schedule);
+
+
+    #endif // WORKERPOOL_H